@@ -0,0 +1,196 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// arc_replacer.cpp
+//
+// Identification: src/buffer/arc_replacer.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/arc_replacer.h"
+
+#include <algorithm>
+
+namespace bustub {
+
+ARCReplacer::ARCReplacer(size_t num_pages) : capacity_(num_pages), frames_(num_pages) {}
+
+bool ARCReplacer::Victim(frame_id_t *frame_id) {
+  std::scoped_lock<std::mutex> latch(latch_);
+  if (num_evictable_ == 0) {
+    return false;
+  }
+  auto evictable = [this](frame_id_t f) { return frames_[f].evictable_; };
+  auto t1_victim = std::find_if(t1_.rbegin(), t1_.rend(), evictable);
+  auto t2_victim = std::find_if(t2_.rbegin(), t2_.rend(), evictable);
+  ListType from = PickList(t1_.size(), t1_victim != t1_.rend(), t2_victim != t2_.rend());
+  *frame_id = from == ListType::T1 ? *t1_victim : *t2_victim;
+  page_id_t page_id = frames_[*frame_id].page_id_;
+  Detach(*frame_id);
+  if (page_id != INVALID_PAGE_ID) {
+    AddGhost(page_id, from == ListType::T2);
+    TrimGhosts();
+  }
+  return true;
+}
+
+void ARCReplacer::Pin(frame_id_t frame_id) {
+  std::scoped_lock<std::mutex> latch(latch_);
+  FrameEntry &entry = frames_[frame_id];
+  if (entry.list_ != ListType::NONE && entry.evictable_) {
+    entry.evictable_ = false;
+    num_evictable_--;
+  }
+}
+
+void ARCReplacer::Unpin(frame_id_t frame_id) {
+  std::scoped_lock<std::mutex> latch(latch_);
+  FrameEntry &entry = frames_[frame_id];
+  if (entry.list_ == ListType::NONE) {
+    MoveToFront(frame_id, ListType::T1);
+  }
+  if (!entry.evictable_) {
+    entry.evictable_ = true;
+    num_evictable_++;
+  }
+}
+
+void ARCReplacer::RecordAccess(frame_id_t frame_id) {
+  std::scoped_lock<std::mutex> latch(latch_);
+  Touch(frame_id);
+}
+
+void ARCReplacer::RecordPageAccess(frame_id_t frame_id, page_id_t page_id) {
+  std::scoped_lock<std::mutex> latch(latch_);
+  FrameEntry &entry = frames_[frame_id];
+  if (entry.list_ != ListType::NONE) {
+    if (entry.page_id_ == INVALID_PAGE_ID) {
+      entry.page_id_ = page_id;
+    }
+    if (entry.page_id_ == page_id) {
+      Touch(frame_id);
+      return;
+    }
+    // The frame was reused behind our back; what it held is gone without a trace.
+    Detach(frame_id);
+  }
+
+  // The page was just loaded into the frame. If we evicted it recently, the list it was evicted from was too small.
+  auto ghost = ghosts_.find(page_id);
+  if (ghost == ghosts_.end()) {
+    MoveToFront(frame_id, ListType::T1);
+  } else {
+    if (ghost->second.in_b2_) {
+      size_t delta = std::max<size_t>(b1_.size() / b2_.size(), 1);
+      p_ = p_ > delta ? p_ - delta : 0;
+    } else {
+      size_t delta = std::max<size_t>(b2_.size() / b1_.size(), 1);
+      p_ = std::min(p_ + delta, capacity_);
+    }
+    EraseGhost(ghost);
+    MoveToFront(frame_id, ListType::T2);
+  }
+  entry.page_id_ = page_id;
+  TrimGhosts();
+}
+
+void ARCReplacer::Remove(frame_id_t frame_id) {
+  std::scoped_lock<std::mutex> latch(latch_);
+  Detach(frame_id);
+}
+
+void ARCReplacer::PeekVictims(size_t count, std::vector<frame_id_t> *frame_ids) {
+  std::scoped_lock<std::mutex> latch(latch_);
+  // Replay the victim choices on copies of the list positions; p does not change while nothing is accessed.
+  auto evictable = [this](frame_id_t f) { return frames_[f].evictable_; };
+  auto t1_victim = std::find_if(t1_.rbegin(), t1_.rend(), evictable);
+  auto t2_victim = std::find_if(t2_.rbegin(), t2_.rend(), evictable);
+  size_t t1_size = t1_.size();
+  for (size_t n = 0; n < count; ++n) {
+    ListType from = PickList(t1_size, t1_victim != t1_.rend(), t2_victim != t2_.rend());
+    if (from == ListType::T1) {
+      frame_ids->push_back(*t1_victim);
+      t1_victim = std::find_if(std::next(t1_victim), t1_.rend(), evictable);
+      t1_size--;
+    } else if (from == ListType::T2) {
+      frame_ids->push_back(*t2_victim);
+      t2_victim = std::find_if(std::next(t2_victim), t2_.rend(), evictable);
+    } else {
+      break;
+    }
+  }
+}
+
+size_t ARCReplacer::Size() {
+  std::scoped_lock<std::mutex> latch(latch_);
+  return num_evictable_;
+}
+
+size_t ARCReplacer::GetTargetT1Size() {
+  std::scoped_lock<std::mutex> latch(latch_);
+  return p_;
+}
+
+void ARCReplacer::MoveToFront(frame_id_t frame_id, ListType type) {
+  FrameEntry &entry = frames_[frame_id];
+  std::list<frame_id_t> *list = ListOf(type);
+  if (entry.list_ == ListType::NONE) {
+    list->push_front(frame_id);
+    entry.evictable_ = false;
+  } else {
+    list->splice(list->begin(), *ListOf(entry.list_), entry.pos_);
+  }
+  entry.list_ = type;
+  entry.pos_ = list->begin();
+}
+
+void ARCReplacer::Detach(frame_id_t frame_id) {
+  FrameEntry &entry = frames_[frame_id];
+  if (entry.list_ == ListType::NONE) {
+    return;
+  }
+  ListOf(entry.list_)->erase(entry.pos_);
+  if (entry.evictable_) {
+    num_evictable_--;
+  }
+  entry.list_ = ListType::NONE;
+  entry.evictable_ = false;
+  entry.page_id_ = INVALID_PAGE_ID;
+}
+
+void ARCReplacer::Touch(frame_id_t frame_id) {
+  FrameEntry &entry = frames_[frame_id];
+  MoveToFront(frame_id, entry.list_ != ListType::NONE && entry.page_id_ != INVALID_PAGE_ID ? ListType::T2 : ListType::T1);
+}
+
+void ARCReplacer::AddGhost(page_id_t page_id, bool in_b2) {
+  std::list<page_id_t> *ghosts = in_b2 ? &b2_ : &b1_;
+  ghosts->push_front(page_id);
+  ghosts_[page_id] = {in_b2, ghosts->begin()};
+}
+
+void ARCReplacer::EraseGhost(std::unordered_map<page_id_t, GhostEntry>::iterator ghost) {
+  (ghost->second.in_b2_ ? b2_ : b1_).erase(ghost->second.pos_);
+  ghosts_.erase(ghost);
+}
+
+void ARCReplacer::TrimGhosts() {
+  while (t1_.size() + b1_.size() > capacity_ && !b1_.empty()) {
+    EraseGhost(ghosts_.find(b1_.back()));
+  }
+  while (t1_.size() + t2_.size() + b1_.size() + b2_.size() > 2 * capacity_ && !b2_.empty()) {
+    EraseGhost(ghosts_.find(b2_.back()));
+  }
+}
+
+ARCReplacer::ListType ARCReplacer::PickList(size_t t1_size, bool t1_has_victim, bool t2_has_victim) const {
+  if (t1_has_victim && (t1_size > p_ || !t2_has_victim)) {
+    return ListType::T1;
+  }
+  return t2_has_victim ? ListType::T2 : ListType::NONE;
+}
+
+}  // namespace bustub
@@ -12,8 +12,20 @@
 
 #include "buffer/buffer_pool_manager.h"
 
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <future>  // NOLINT
+#include <iostream>
 #include <list>
+#include <memory>
+#include <numeric>
 #include <unordered_map>
+#include <utility>
+#include <vector>
+#include "common/exception.h"
 #include "common/logger.h"
 
 // static std::unordered_map<std::string, bool> output;
@@ -40,27 +52,78 @@
 
 namespace bustub {
 
-BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager)
-    : pool_size_(pool_size), disk_manager_(disk_manager), log_manager_(log_manager) {
-  // We allocate a consecutive memory space for the buffer pool.
+/** @return the nanoseconds elapsed since start */
+static uint64_t NanosSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+/** Marks the start of a resident page dump, followed by the number of page ids in it. */
+static constexpr uint32_t RESIDENT_PAGE_DUMP_MAGIC = 0x42505244;
+
+BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager,
+                                     ReplacerType replacer_type)
+    : pool_size_(pool_size),
+      page_size_(disk_manager != nullptr ? disk_manager->GetPageSize() : PAGE_SIZE),
+      disk_manager_(disk_manager),
+      log_manager_(log_manager) {
+  // The page data is kept apart from the page descriptors, in one aligned arena, so that the descriptors stay small
+  // and densely packed.
   pages_ = new Page[pool_size_];
-  replacer_ = new LRUReplacer(pool_size);
+  frames_ = new FrameArena(pool_size_, page_size_);
+  for (size_t i = 0; i < pool_size_; ++i) {
+    pages_[i].data_ = frames_->GetFrame(i);
+    pages_[i].page_size_ = page_size_;
+  }
+  switch (replacer_type) {
+    case ReplacerType::LRU_K:
+      replacer_ = new LRUKReplacer(pool_size);
+      break;
+    case ReplacerType::CLOCK:
+      replacer_ = new ClockReplacer(pool_size);
+      break;
+    case ReplacerType::ARC:
+      replacer_ = new ARCReplacer(pool_size);
+      break;
+    case ReplacerType::LRU:
+    default:
+      replacer_ = new LRUReplacer(pool_size);
+      break;
+  }
 
   // Initially, every page is in the free list.
   for (size_t i = 0; i < pool_size_; ++i) {
     free_list_.emplace_back(static_cast<int>(i));
   }
+  // The disk manager may be destroyed before us; it then stops our threads first.
+  if (disk_manager_ != nullptr) {
+    background_user_ = disk_manager_->AddBackgroundUser([this] {
+      StopBackgroundThreads();
+      is_background_user_ = false;
+    });
+    is_background_user_ = true;
+  }
+  if (pool_size_ > 0 && bg_writer_low_watermark > 0) {
+    bg_writer_thread_ = std::thread(&BufferPoolManager::BackgroundWriterLoop, this);
+  }
 
   // print_file("/autograder/bustub/test/concurrency/grading_lock_manager_2_test.cpp");
   // print_file("/autograder/bustub/test/concurrency/grading_lock_manager_3_test.cpp");
 }
 
 BufferPoolManager::~BufferPoolManager() {
+  StopResidentPageDumps();
+  if (is_background_user_) {
+    disk_manager_->RemoveBackgroundUser(background_user_);
+  }
+  StopBackgroundThreads();
   delete[] pages_;
+  delete frames_;
   delete replacer_;
 }
 
-Page *BufferPoolManager::FetchPageImpl(page_id_t page_id) {
+Page *BufferPoolManager::FetchPageImpl(page_id_t page_id) { return FetchPageWithStrategyImpl(page_id, nullptr); }
+
+Page *BufferPoolManager::FetchPageWithStrategyImpl(page_id_t page_id, BufferAccessStrategy *strategy) {
   // 1.     Search the page table for the requested page (P).
   // 1.1    If P exists, pin it and return it immediately.
   // 1.2    If P does not exist, find a replacement page (R) from either the free list or the replacer.
@@ -68,38 +131,195 @@ Page *BufferPoolManager::FetchPageImpl(page_id_t page_id) {
   // 2.     If R is dirty, write it back to the disk.
   // 3.     Delete R from the page table and insert P.
   // 4.     Update P's metadata, read in the page content from disk, and then return a pointer to P.
-  std::scoped_lock<std::mutex> latch(latch_);
-  auto it = page_table_.find(page_id);
-  if (it != page_table_.end()) {
-    Page &page = pages_[it->second];
-    ++page.pin_count_;
-    replacer_->Pin(it->second);
-    return &page;
+  // Disk I/O for steps 2 and 4 happens after the pool latch is released; P is marked as having I/O in progress, and
+  // whoever else fetches P in the meantime pins it and waits on the frame.
+  Page *hit = nullptr;
+  {
+    // A cache hit only reads the page table, so concurrent hits never serialize on the pool latch.
+    std::shared_lock<std::shared_mutex> latch(latch_);
+    // The first hit on a prefetched page has to update its state, so it takes the exclusive path below.
+    auto it = page_table_.find(page_id);
+    if (it != page_table_.end() && !pages_[it->second].is_prefetched_) {
+      hit = &pages_[it->second];
+      replacer_->RecordPageAccess(it->second, page_id);
+      if (hit->pin_count_.fetch_add(1) == 0) {
+        replacer_->Pin(it->second);
+      }
+    }
+  }
+  if (hit != nullptr) {
+    metrics_.Add(BufferPoolMetrics::HITS);
+    WaitForIO(hit);
+    return hit;
   }
 
-  frame_id_t frame_id;
-  if (!free_list_.empty()) {
-    frame_id = free_list_.back();
-    free_list_.pop_back();
-  } else if (replacer_->Victim(&frame_id)) {
-    Page &page = pages_[frame_id];
-    page_table_.erase(page.GetPageId());
-    if (page.IsDirty()) {
-      disk_manager_->WritePage(page.GetPageId(), page.GetData());
+  std::unique_lock<std::shared_mutex> latch(latch_);
+  while (true) {
+    // Somebody else may have brought the page in while we were waiting for the exclusive latch.
+    auto it = page_table_.find(page_id);
+    if (it != page_table_.end()) {
+      Page &page = pages_[it->second];
+      if (page.is_prefetched_) {
+        // The read-ahead already counted as this access. A scan takes the page over into its ring, as if it had read
+        // the page itself.
+        page.is_prefetched_ = false;
+        if (strategy != nullptr) {
+          AdoptIntoRing(strategy, page_id);
+        }
+      } else {
+        replacer_->RecordPageAccess(it->second, page_id);
+      }
+      if (page.pin_count_.fetch_add(1) == 0) {
+        replacer_->Pin(it->second);
+      }
+      latch.unlock();
+      metrics_.Add(BufferPoolMetrics::HITS);
+      WaitForIO(&page);
+      return &page;
     }
-  } else {
+    // The page may have just been evicted and still be on its way to disk.
+    if (writing_back_.count(page_id) == 0) {
+      break;
+    }
+    WaitForWriteBack(&latch, page_id);
+  }
+
+  // A scan with an access strategy recycles its own ring before it touches the shared free list or the replacer.
+  frame_id_t frame_id;
+  page_id_t write_back_page_id;
+  bool from_ring = strategy != nullptr && FindRingFrame(strategy, &frame_id, &write_back_page_id);
+  if (!from_ring && !FindFreeFrame(&frame_id, &write_back_page_id)) {
     return nullptr;
   }
+  if (strategy != nullptr) {
+    strategy->Advance(page_id);
+  }
 
   Page &page = pages_[frame_id];
   page.page_id_ = page_id;
   page.pin_count_ = 1;
   page.is_dirty_ = false;
-  disk_manager_->ReadPage(page.GetPageId(), page.GetData());
+  page.io_in_progress_ = true;
   page_table_[page_id] = frame_id;
+  replacer_->RecordPageAccess(frame_id, page_id);
+  latch.unlock();
+  metrics_.Add(BufferPoolMetrics::MISSES);
+
+  if (write_back_page_id != INVALID_PAGE_ID) {
+    WritePageToDisk(write_back_page_id, page.GetData());
+    latch.lock();
+    FinishWriteBack(write_back_page_id);
+    latch.unlock();
+  }
+  ReadPageFromDisk(&page);
+  FinishIO(&page);
   return &page;
 }
 
+void BufferPoolManager::FetchPagesImpl(const std::vector<page_id_t> &page_ids, std::vector<Page *> *pages) {
+  pages->assign(page_ids.size(), nullptr);
+  struct Miss {
+    Page *page_;
+    page_id_t write_back_page_id_;
+  };
+  std::vector<Miss> misses;
+  // Positions of pages that are on their way to disk; they are fetched one at a time once the batch is done.
+  std::vector<size_t> written_back;
+  {
+    std::scoped_lock<std::shared_mutex> latch(latch_);
+    for (size_t i = 0; i < page_ids.size(); ++i) {
+      page_id_t page_id = page_ids[i];
+      auto it = page_table_.find(page_id);
+      if (it != page_table_.end()) {
+        Page &page = pages_[it->second];
+        if (page.is_prefetched_) {
+          page.is_prefetched_ = false;
+        } else {
+          replacer_->RecordPageAccess(it->second, page_id);
+        }
+        if (page.pin_count_.fetch_add(1) == 0) {
+          replacer_->Pin(it->second);
+        }
+        (*pages)[i] = &page;
+        metrics_.Add(BufferPoolMetrics::HITS);
+        continue;
+      }
+      if (writing_back_.count(page_id) != 0) {
+        written_back.push_back(i);
+        continue;
+      }
+      frame_id_t frame_id;
+      page_id_t write_back_page_id;
+      if (!FindFreeFrame(&frame_id, &write_back_page_id)) {
+        continue;
+      }
+      Page &page = pages_[frame_id];
+      page.page_id_ = page_id;
+      page.pin_count_ = 1;
+      page.is_dirty_ = false;
+      page.io_in_progress_ = true;
+      page_table_[page_id] = frame_id;
+      replacer_->RecordPageAccess(frame_id, page_id);
+      (*pages)[i] = &page;
+      misses.push_back({&page, write_back_page_id});
+      metrics_.Add(BufferPoolMetrics::MISSES);
+    }
+  }
+
+  // Each frame is written back before it is read into; the reads then sweep the file in page id order.
+  std::sort(misses.begin(), misses.end(),
+            [](const Miss &a, const Miss &b) { return a.page_->GetPageId() < b.page_->GetPageId(); });
+  std::vector<std::pair<page_id_t, const char *>> write_backs;
+  std::vector<Page *> reads;
+  for (const Miss &miss : misses) {
+    if (miss.write_back_page_id_ != INVALID_PAGE_ID) {
+      write_backs.emplace_back(miss.write_back_page_id_, miss.page_->GetData());
+    }
+    reads.push_back(miss.page_);
+  }
+  if (!write_backs.empty()) {
+    WritePagesToDisk(write_backs);
+    std::scoped_lock<std::shared_mutex> latch(latch_);
+    for (const Miss &miss : misses) {
+      if (miss.write_back_page_id_ != INVALID_PAGE_ID) {
+        FinishWriteBack(miss.write_back_page_id_);
+      }
+    }
+  }
+  ReadPagesFromDisk(reads);
+  for (const Miss &miss : misses) {
+    FinishIO(miss.page_);
+  }
+
+  // Hits may still be being read in by someone else.
+  for (Page *page : *pages) {
+    if (page != nullptr) {
+      WaitForIO(page);
+    }
+  }
+  for (size_t i : written_back) {
+    (*pages)[i] = FetchPageImpl(page_ids[i]);
+  }
+}
+
+ReadPageGuard BufferPoolManager::FetchPageRead(page_id_t page_id, BufferAccessStrategy *strategy) {
+  Page *page = strategy == nullptr ? FetchPageImpl(page_id) : FetchPageWithStrategyImpl(page_id, strategy);
+  if (page == nullptr) {
+    return {};
+  }
+  page->RLatch();
+  return {this, page};
+}
+
+WritePageGuard BufferPoolManager::FetchPageWrite(page_id_t page_id) {
+  Page *page = FetchPageImpl(page_id);
+  if (page == nullptr) {
+    return {};
+  }
+  page->WLatch();
+  return {this, page};
+}
+
 /**
  * Unpin the target page from the buffer pool.
  * @param page_id id of page to be unpinned
@@ -107,15 +327,33 @@ Page *BufferPoolManager::FetchPageImpl(page_id_t page_id) {
  * @return false if the page pin count is <= 0 before this call, true otherwise
  */
 bool BufferPoolManager::UnpinPageImpl(page_id_t page_id, bool is_dirty) {
-  std::scoped_lock<std::mutex> latch(latch_);
+  std::shared_lock<std::shared_mutex> latch(latch_);
+  return UnpinPageLocked(page_id, is_dirty);
+}
+
+bool BufferPoolManager::UnpinPagesImpl(const std::vector<page_id_t> &page_ids, bool is_dirty) {
+  std::shared_lock<std::shared_mutex> latch(latch_);
+  bool all_pinned = true;
+  for (page_id_t page_id : page_ids) {
+    all_pinned = UnpinPageLocked(page_id, is_dirty) && all_pinned;
+  }
+  return all_pinned;
+}
+
+bool BufferPoolManager::UnpinPageLocked(page_id_t page_id, bool is_dirty) {
   auto it = page_table_.find(page_id);
   if (it != page_table_.end()) {
     Page &page = pages_[it->second];
-    if (page.GetPinCount() <= 0) {
-      return false;
+    int pin_count = page.pin_count_.load();
+    do {
+      if (pin_count <= 0) {
+        return false;
+      }
+    } while (!page.pin_count_.compare_exchange_weak(pin_count, pin_count - 1));
+    if (is_dirty) {
+      page.is_dirty_ = true;
     }
-    page.is_dirty_ = page.is_dirty_ || is_dirty;
-    if (--page.pin_count_ == 0) {
+    if (pin_count == 1) {
       replacer_->Unpin(it->second);
     }
     return true;
@@ -129,12 +367,19 @@ bool BufferPoolManager::UnpinPageImpl(page_id_t page_id, bool is_dirty) {
  * @return false if the page could not be found in the page table, true otherwise
  */
 bool BufferPoolManager::FlushPageImpl(page_id_t page_id) {
-  std::scoped_lock<std::mutex> latch(latch_);
+  std::unique_lock<std::shared_mutex> latch(latch_);
+  // The background writer may still be writing an older image of the page; ours must land after it.
+  WaitForWriteBack(&latch, page_id);
   auto it = page_table_.find(page_id);
   if (it != page_table_.end()) {
     Page &page = pages_[it->second];
+    // A page that is still being read in is identical to what is on disk, and its frame does not hold it yet.
+    if (page.io_in_progress_) {
+      return true;
+    }
     page.is_dirty_ = false;
-    disk_manager_->WritePage(page_id, page.GetData());
+    WritePageToDisk(page_id, page.GetData());
+    metrics_.Add(BufferPoolMetrics::FLUSHES);
     return true;
   }
   return false;
@@ -147,27 +392,686 @@ Page *BufferPoolManager::NewPageImpl(page_id_t *page_id) {
   // 2.   Pick a victim page P from either the free list or the replacer. Always pick from the free list first.
   // 3.   Update P's metadata, zero out memory and add P to the page table.
   // 4.   Set the page ID output parameter. Return a pointer to P.
-  std::scoped_lock<std::mutex> latch(latch_);
+  return NewPageInFileImpl(DB_FILE_ID, page_id);
+}
+
+Page *BufferPoolManager::NewPageInFileImpl(file_id_t file_id, page_id_t *page_id) {
+  std::unique_lock<std::shared_mutex> latch(latch_);
   frame_id_t frame_id;
+  page_id_t write_back_page_id;
+  if (!FindFreeFrame(&frame_id, &write_back_page_id)) {
+    return nullptr;
+  }
+  // An id whose stale copy is still pinned cannot be created yet (see InitNewPage). There are fewer such ids than
+  // frames, so we soon get one that is free, and the rejected ones are given back once we are done.
+  std::vector<page_id_t> rejected;
+  Page *page = nullptr;
+  while (page == nullptr) {
+    page_id_t candidate = disk_manager_->AllocatePage(file_id);
+    page = InitNewPage(frame_id, candidate);
+    if (page == nullptr) {
+      rejected.push_back(candidate);
+    }
+  }
+  for (auto candidate : rejected) {
+    disk_manager_->DeallocatePage(candidate);
+  }
+  *page_id = page->GetPageId();
+  FinishNewPage(&latch, page, write_back_page_id);
+  return page;
+}
+
+Page *BufferPoolManager::NewPageWithId(page_id_t page_id) {
+  std::unique_lock<std::shared_mutex> latch(latch_);
+  // Checked before a frame is taken, so that no victim is evicted for a page that cannot be created.
+  auto stale = page_table_.find(page_id);
+  if (stale != page_table_.end() && pages_[stale->second].GetPinCount() > 0) {
+    return nullptr;
+  }
+  frame_id_t frame_id;
+  page_id_t write_back_page_id;
+  if (!FindFreeFrame(&frame_id, &write_back_page_id)) {
+    return nullptr;
+  }
+  Page *page = InitNewPage(frame_id, page_id);
+  FinishNewPage(&latch, page, write_back_page_id);
+  return page;
+}
+
+void BufferPoolManager::FinishNewPage(std::unique_lock<std::shared_mutex> *latch, Page *page,
+                                      page_id_t write_back_page_id) {
+  // Like a miss, the frame is written back before it is reused; whoever fetches the new page meanwhile waits on it.
+  latch->unlock();
+  if (write_back_page_id != INVALID_PAGE_ID) {
+    WritePageToDisk(write_back_page_id, page->GetData());
+    latch->lock();
+    FinishWriteBack(write_back_page_id);
+    latch->unlock();
+  }
+  page->data_ = GetFrame(static_cast<frame_id_t>(page - pages_));
+  page->ResetMemory();
+  WritePageToDisk(page->GetPageId(), page->GetData());
+  FinishIO(page);
+}
+
+bool BufferPoolManager::FindFreeFrame(frame_id_t *frame_id, page_id_t *write_back_page_id) {
+  // Pages are always found from the free list first.
   if (!free_list_.empty()) {
-    frame_id = free_list_.back();
+    *frame_id = free_list_.back();
     free_list_.pop_back();
-  } else if (replacer_->Victim(&frame_id)) {
-    Page &page = pages_[frame_id];
-    page_table_.erase(page.GetPageId());
+    if (write_back_page_id != nullptr) {
+      *write_back_page_id = INVALID_PAGE_ID;
+    }
+    return true;
+  }
+  // Frames whose page was changed again while the background writer is still writing back an older image. Writing
+  // back the new image now could be overtaken by the old one, so they are passed over and handed back afterwards.
+  std::vector<frame_id_t> busy;
+  bool found = false;
+  while (!found && replacer_->Victim(frame_id)) {
+    Page &page = pages_[*frame_id];
+    // A hit racing with the last unpin can leave a pinned frame in the replacer. It is dropped here and re-enters the
+    // replacer when its pin count next drops to zero.
+    if (page.GetPinCount() > 0) {
+      continue;
+    }
+    if (page.IsDirty() && writing_back_.count(page.GetPageId()) > 0) {
+      busy.push_back(*frame_id);
+      continue;
+    }
     if (page.IsDirty()) {
-      disk_manager_->WritePage(page.GetPageId(), page.GetData());
+      WakeBackgroundWriter();
     }
-  } else {
+    EvictFrame(*frame_id, write_back_page_id);
+    found = true;
+  }
+  for (frame_id_t busy_frame_id : busy) {
+    replacer_->Unpin(busy_frame_id);
+  }
+  return found;
+}
+
+bool BufferPoolManager::FindRingFrame(BufferAccessStrategy *strategy, frame_id_t *frame_id,
+                                      page_id_t *write_back_page_id) {
+  page_id_t ring_page_id = strategy->Current();
+  if (ring_page_id == INVALID_PAGE_ID) {
+    return false;
+  }
+  // The page may have been evicted, deleted or picked up by someone else since the scan loaded it.
+  auto it = page_table_.find(ring_page_id);
+  if (it == page_table_.end() || pages_[it->second].GetPinCount() > 0 ||
+      (pages_[it->second].IsDirty() && writing_back_.count(ring_page_id) > 0)) {
+    return false;
+  }
+  *frame_id = it->second;
+  replacer_->Remove(*frame_id);
+  EvictFrame(*frame_id, write_back_page_id);
+  return true;
+}
+
+void BufferPoolManager::EvictFrame(frame_id_t frame_id, page_id_t *write_back_page_id) {
+  Page &page = pages_[frame_id];
+  page_table_.erase(page.GetPageId());
+  page.is_prefetched_ = false;
+  metrics_.Add(BufferPoolMetrics::EVICTIONS);
+  if (write_back_page_id != nullptr) {
+    *write_back_page_id = INVALID_PAGE_ID;
+  }
+  if (!page.IsDirty()) {
+    return;
+  }
+  metrics_.Add(BufferPoolMetrics::DIRTY_EVICTIONS);
+  if (write_back_page_id != nullptr) {
+    *write_back_page_id = page.GetPageId();
+    writing_back_.insert(page.GetPageId());
+    return;
+  }
+  WritePageToDisk(page.GetPageId(), page.GetData());
+}
+
+void BufferPoolManager::WaitForIO(Page *page) {
+  if (!page->io_in_progress_) {
+    return;
+  }
+  auto start = std::chrono::steady_clock::now();
+  {
+    std::unique_lock<std::mutex> latch(page->io_latch_);
+    page->io_cv_.wait(latch, [&] { return !page->io_in_progress_; });
+  }
+  metrics_.Add(BufferPoolMetrics::IO_WAITS);
+  metrics_.Add(BufferPoolMetrics::IO_WAIT_NANOS, NanosSince(start));
+}
+
+void BufferPoolManager::WaitForWriteBack(std::unique_lock<std::shared_mutex> *latch, page_id_t page_id) {
+  if (writing_back_.count(page_id) == 0) {
+    return;
+  }
+  auto start = std::chrono::steady_clock::now();
+  write_back_cv_.wait(*latch, [&] { return writing_back_.count(page_id) == 0; });
+  metrics_.Add(BufferPoolMetrics::IO_WAITS);
+  metrics_.Add(BufferPoolMetrics::IO_WAIT_NANOS, NanosSince(start));
+}
+
+void BufferPoolManager::FinishWriteBack(page_id_t page_id) {
+  writing_back_.erase(page_id);
+  write_back_cv_.notify_all();
+}
+
+void BufferPoolManager::DumpFrameStates(std::ostream &os) {
+  os << "frame\tpage\tpins\tdirty\tio\tvictim" << std::endl;
+  for (const FrameState &frame : GetFrameStates()) {
+    if (frame.page_id_ == INVALID_PAGE_ID) {
+      continue;
+    }
+    os << frame.frame_id_ << '\t' << frame.page_id_ << '\t' << frame.pin_count_ << '\t' << frame.is_dirty_ << '\t'
+       << frame.io_in_progress_ << '\t' << frame.replacer_position_ << std::endl;
+  }
+}
+
+void BufferPoolManager::ReadPageFromDisk(Page *page) {
+  auto start = std::chrono::steady_clock::now();
+  if (!MapPage(page)) {
+    disk_manager_->ReadPage(page->GetPageId(), page->GetData());
+  }
+  metrics_.Add(BufferPoolMetrics::READS);
+  metrics_.Add(BufferPoolMetrics::READ_NANOS, NanosSince(start));
+}
+
+void BufferPoolManager::WritePageToDisk(page_id_t page_id, const char *page_data) {
+  auto start = std::chrono::steady_clock::now();
+  disk_manager_->WritePage(page_id, page_data);
+  metrics_.Add(BufferPoolMetrics::WRITES);
+  metrics_.Add(BufferPoolMetrics::WRITE_NANOS, NanosSince(start));
+}
+
+void BufferPoolManager::ReadPagesFromDisk(const std::vector<Page *> &pages) {
+  if (pages.empty()) {
+    return;
+  }
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::future<void>> reads;
+  reads.reserve(pages.size());
+  for (Page *page : pages) {
+    if (!MapPage(page)) {
+      reads.push_back(disk_manager_->ReadPageAsync(page->GetPageId(), page->GetData()));
+    }
+  }
+  disk_manager_->SubmitAsync();
+  for (auto &read : reads) {
+    read.wait();
+  }
+  metrics_.Add(BufferPoolMetrics::READS, pages.size());
+  metrics_.Add(BufferPoolMetrics::READ_NANOS, NanosSince(start));
+}
+
+bool BufferPoolManager::MapPage(Page *page) {
+  const char *mapped = disk_manager_->GetMappedPage(page->GetPageId());
+  // The frame may still point at the mapped copy of the page it held before.
+  page->data_ = mapped != nullptr ? const_cast<char *>(mapped) : GetFrame(page - pages_);  // NOLINT
+  return mapped != nullptr;
+}
+
+void BufferPoolManager::WritePagesToDisk(const std::vector<std::pair<page_id_t, const char *>> &pages) {
+  if (pages.empty()) {
+    return;
+  }
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::future<void>> writes;
+  writes.reserve(pages.size());
+  for (const auto &[page_id, page_data] : pages) {
+    writes.push_back(disk_manager_->WritePageAsync(page_id, page_data));
+  }
+  disk_manager_->SubmitAsync();
+  for (auto &write : writes) {
+    write.wait();
+  }
+  metrics_.Add(BufferPoolMetrics::WRITES, pages.size());
+  metrics_.Add(BufferPoolMetrics::WRITE_NANOS, NanosSince(start));
+}
+
+void BufferPoolManager::GetFrameStatesImpl(std::vector<FrameState> *frames) {
+  std::scoped_lock<std::shared_mutex> latch(latch_);
+  std::vector<frame_id_t> victims;
+  replacer_->PeekVictims(pool_size_, &victims);
+  std::vector<int> positions(pool_size_, -1);
+  for (size_t i = 0; i < victims.size(); ++i) {
+    positions[victims[i]] = static_cast<int>(i);
+  }
+  for (size_t i = 0; i < pool_size_; ++i) {
+    Page &page = pages_[i];
+    frames->push_back({static_cast<frame_id_t>(i), page.GetPageId(), page.GetPinCount(), page.IsDirty(),
+                       page.io_in_progress_, positions[i]});
+  }
+}
+
+void BufferPoolManager::FinishIO(Page *page) {
+  {
+    std::scoped_lock<std::mutex> latch(page->io_latch_);
+    page->io_in_progress_ = false;
+  }
+  page->io_cv_.notify_all();
+}
+
+void BufferPoolManager::WakeBackgroundWriter() {
+  if (!bg_writer_thread_.joinable()) {
+    return;
+  }
+  std::scoped_lock<std::mutex> latch(bg_writer_latch_);
+  bg_writer_wakeup_ = true;
+  bg_writer_cv_.notify_one();
+}
+
+void BufferPoolManager::BackgroundWriterLoop() {
+  std::unique_lock<std::mutex> latch(bg_writer_latch_);
+  while (true) {
+    bg_writer_cv_.wait_for(latch, bg_writer_interval, [&] { return bg_writer_stop_ || bg_writer_wakeup_; });
+    if (bg_writer_stop_) {
+      return;
+    }
+    bg_writer_wakeup_ = false;
+    // Fetches that write back a victim wake us up, so the latch must not be held while we take latch_.
+    latch.unlock();
+    CleanVictims();
+    latch.lock();
+  }
+}
+
+void BufferPoolManager::CleanVictims() {
+  auto low_watermark = static_cast<size_t>(bg_writer_low_watermark * pool_size_);
+  auto high_watermark = std::max(low_watermark, static_cast<size_t>(bg_writer_high_watermark * pool_size_));
+  std::unique_ptr<char, decltype(&std::free)> images(nullptr, &std::free);
+  std::vector<std::pair<page_id_t, const char *>> writes;
+  {
+    std::scoped_lock<std::shared_mutex> latch(latch_);
+    size_t free_frames = free_list_.size();
+    if (free_frames >= low_watermark) {
+      return;
+    }
+    std::vector<frame_id_t> victims;
+    replacer_->PeekVictims(high_watermark - free_frames, &victims);
+    size_t clean_frames = free_frames;
+    std::vector<Page *> dirty_pages;
+    for (frame_id_t frame_id : victims) {
+      Page &page = pages_[frame_id];
+      if (!page.IsDirty()) {
+        ++clean_frames;
+      } else if (page.GetPinCount() == 0 && writing_back_.count(page.GetPageId()) == 0) {
+        dirty_pages.push_back(&page);
+      }
+    }
+    if (clean_frames >= low_watermark || dirty_pages.empty()) {
+      return;
+    }
+    // The pages are copied while we hold latch_ exclusively, so nobody can pin them, and none of them stays pinned
+    // while it is written: fetches and evictions never find a frame held up by the writer. Until the copies are on
+    // disk the pages are in writing_back_, which keeps a miss from reading them stale and a newer image from being
+    // overtaken. Clearing the flag under the page latch means a later update marks the page dirty again.
+    images.reset(static_cast<char *>(std::aligned_alloc(page_size_, dirty_pages.size() * page_size_)));
+    if (images == nullptr) {
+      return;
+    }
+    for (Page *page : dirty_pages) {
+      // Unpinned pages are not latched; the try only guards against a holder that unpins before it unlatches.
+      if (!page->TryRLatch()) {
+        continue;
+      }
+      char *image = images.get() + writes.size() * page_size_;
+      memcpy(image, page->GetData(), page_size_);
+      page->is_dirty_ = false;
+      page->RUnlatch();
+      writing_back_.insert(page->GetPageId());
+      writes.emplace_back(page->GetPageId(), image);
+    }
+  }
+  WritePagesToDisk(writes);
+  std::scoped_lock<std::shared_mutex> latch(latch_);
+  for (const auto &[page_id, image] : writes) {
+    FinishWriteBack(page_id);
+  }
+}
+
+void BufferPoolManager::AdoptIntoRing(BufferAccessStrategy *strategy, page_id_t page_id) {
+  page_id_t ring_page_id = strategy->Current();
+  auto it = page_table_.find(ring_page_id);
+  if (ring_page_id != page_id && it != page_table_.end() && pages_[it->second].GetPinCount() == 0) {
+    frame_id_t frame_id = it->second;
+    replacer_->Remove(frame_id);
+    EvictFrame(frame_id);
+    Page &page = pages_[frame_id];
+    page.page_id_ = INVALID_PAGE_ID;
+    page.is_dirty_ = false;
+    free_list_.push_back(frame_id);
+  }
+  strategy->Advance(page_id);
+}
+
+void BufferPoolManager::PrefetchRange(page_id_t page_id, size_t count, next_page_fn next_page) {
+  if (page_id == INVALID_PAGE_ID || count == 0) {
+    return;
+  }
+  std::scoped_lock<std::mutex> latch(prefetch_latch_);
+  if (prefetch_stop_ || prefetch_queue_.size() >= MAX_PREFETCH_REQUESTS) {
+    return;
+  }
+  if (!prefetch_thread_.joinable()) {
+    prefetch_thread_ = std::thread(&BufferPoolManager::PrefetchLoop, this);
+  }
+  prefetch_queue_.push_back({page_id, count, next_page});
+  prefetch_cv_.notify_one();
+}
+
+void BufferPoolManager::StopBackgroundThreads() {
+  {
+    std::scoped_lock<std::mutex> latch(bg_writer_latch_);
+    bg_writer_stop_ = true;
+    bg_writer_cv_.notify_one();
+  }
+  if (bg_writer_thread_.joinable()) {
+    bg_writer_thread_.join();
+  }
+  StopPrefetcher();
+}
+
+void BufferPoolManager::StopPrefetcher() {
+  {
+    std::scoped_lock<std::mutex> latch(prefetch_latch_);
+    prefetch_stop_ = true;
+    prefetch_queue_.clear();
+    prefetch_cv_.notify_one();
+  }
+  if (prefetch_thread_.joinable()) {
+    prefetch_thread_.join();
+  }
+}
+
+void BufferPoolManager::PrefetchLoop() {
+  std::unique_lock<std::mutex> latch(prefetch_latch_);
+  while (true) {
+    prefetch_cv_.wait(latch, [&] { return prefetch_stop_ || !prefetch_queue_.empty(); });
+    if (prefetch_stop_) {
+      return;
+    }
+    PrefetchRequest request = prefetch_queue_.front();
+    prefetch_queue_.pop_front();
+    // Do the I/O without holding the queue latch, so that scans can keep queueing requests.
+    latch.unlock();
+    // Chains are hinted too: pages are mostly allocated in order, and a wrong hint only costs some read-ahead.
+    disk_manager_->AdviseSequential(request.page_id_, request.count_);
+    if (request.next_page_ == nullptr) {
+      // Consecutive pages can be found without reading the previous one, so they are read all at once.
+      std::vector<page_id_t> page_ids(request.count_);
+      std::iota(page_ids.begin(), page_ids.end(), request.page_id_);
+      PrefetchPagesImpl(page_ids);
+    } else {
+      page_id_t page_id = request.page_id_;
+      for (size_t i = 0; i < request.count_ && page_id != INVALID_PAGE_ID; ++i) {
+        page_id = PrefetchPageImpl(page_id, request.next_page_);
+      }
+    }
+    latch.lock();
+  }
+}
+
+page_id_t BufferPoolManager::PrefetchPageImpl(page_id_t page_id, next_page_fn next_page) {
+  // Pins a resident page, so that it stays put while we follow its next pointer. The caller holds latch_ in any mode.
+  auto pin_resident = [this](frame_id_t frame_id) {
+    Page *page = &pages_[frame_id];
+    if (page->pin_count_.fetch_add(1) == 0) {
+      replacer_->Pin(frame_id);
+    }
+    return page;
+  };
+  Page *page = nullptr;
+  {
+    // Most pages of a read-ahead window are resident already; those only need the shared latch, like a hit.
+    std::shared_lock<std::shared_mutex> latch(latch_);
+    auto it = page_table_.find(page_id);
+    if (it != page_table_.end()) {
+      if (next_page == nullptr) {
+        return page_id + 1;
+      }
+      page = pin_resident(it->second);
+    }
+  }
+  if (page == nullptr) {
+    std::unique_lock<std::shared_mutex> latch(latch_);
+    // A page that is still being written back would be read stale. Only this thread waits for it, not the scan.
+    WaitForWriteBack(&latch, page_id);
+    auto it = page_table_.find(page_id);
+    if (it != page_table_.end()) {
+      if (next_page == nullptr) {
+        return page_id + 1;
+      }
+      page = pin_resident(it->second);
+    } else {
+      frame_id_t frame_id;
+      page_id_t write_back_page_id;
+      if (!FindFreeFrame(&frame_id, &write_back_page_id)) {
+        return INVALID_PAGE_ID;
+      }
+      // Like a miss in FetchPageImpl, the I/O happens outside the pool latch. The page stays pinned until it is read,
+      // and fetches of the page in the meantime wait for the read.
+      page = &pages_[frame_id];
+      page->page_id_ = page_id;
+      page->pin_count_ = 1;
+      page->is_dirty_ = false;
+      page->is_prefetched_ = true;
+      page->io_in_progress_ = true;
+      page_table_[page_id] = frame_id;
+      latch.unlock();
+      if (write_back_page_id != INVALID_PAGE_ID) {
+        WritePageToDisk(write_back_page_id, page->GetData());
+        latch.lock();
+        FinishWriteBack(write_back_page_id);
+        latch.unlock();
+      }
+      ReadPageFromDisk(page);
+      FinishIO(page);
+    }
+  }
+  // Someone else may still be reading a resident page in.
+  WaitForIO(page);
+  page_id_t next_page_id = page_id + 1;
+  if (next_page != nullptr) {
+    page->RLatch();
+    next_page_id = next_page(page->GetData());
+    page->RUnlatch();
+  }
+  std::shared_lock<std::shared_mutex> shared_latch(latch_);
+  UnpinPageLocked(page_id, false);
+  return next_page_id;
+}
+
+void BufferPoolManager::PrefetchPagesImpl(const std::vector<page_id_t> &page_ids) {
+  // Resident pages are skipped under the shared latch; only a window with missing pages takes the exclusive one.
+  std::vector<page_id_t> missing;
+  {
+    std::shared_lock<std::shared_mutex> latch(latch_);
+    for (page_id_t page_id : page_ids) {
+      if (page_table_.count(page_id) == 0) {
+        missing.push_back(page_id);
+      }
+    }
+  }
+  if (missing.empty()) {
+    return;
+  }
+  std::vector<Page *> pages;
+  {
+    std::unique_lock<std::shared_mutex> latch(latch_);
+    for (page_id_t page_id : missing) {
+      // A page that is still being written back would be read stale. Only this thread waits for it, not the scan.
+      WaitForWriteBack(&latch, page_id);
+      if (page_table_.count(page_id) > 0) {
+        continue;
+      }
+      frame_id_t frame_id;
+      if (!FindFreeFrame(&frame_id)) {
+        break;
+      }
+      // The page stays pinned until it is read, so that the frame cannot be evicted under the read. Fetches of the page
+      // in the meantime wait for the read like for any other miss.
+      Page &page = pages_[frame_id];
+      page.page_id_ = page_id;
+      page.pin_count_ = 1;
+      page.is_dirty_ = false;
+      page.is_prefetched_ = true;
+      page.io_in_progress_ = true;
+      page_table_[page_id] = frame_id;
+      pages.push_back(&page);
+    }
+  }
+  ReadPagesFromDisk(pages);
+  for (Page *page : pages) {
+    FinishIO(page);
+  }
+  std::shared_lock<std::shared_mutex> latch(latch_);
+  for (Page *page : pages) {
+    UnpinPageLocked(page->GetPageId(), false);
+  }
+}
+
+bool BufferPoolManager::DumpResidentPages(const std::string &file_name) {
+  std::scoped_lock<std::mutex> latch(dump_latch_);
+  return WriteResidentPages(file_name);
+}
+
+bool BufferPoolManager::WriteResidentPages(const std::string &file_name) {
+  std::vector<page_id_t> page_ids;
+  ListResidentPagesImpl(&page_ids);
+  std::string tmp_file_name = file_name + ".tmp";
+  {
+    std::ofstream out(tmp_file_name, std::ios::binary | std::ios::trunc);
+    uint32_t header[2] = {RESIDENT_PAGE_DUMP_MAGIC, static_cast<uint32_t>(page_ids.size())};
+    out.write(reinterpret_cast<const char *>(header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(page_ids.data()), page_ids.size() * sizeof(page_id_t));
+    out.flush();
+    if (!out) {
+      LOG_WARN("cannot write resident page dump %s", tmp_file_name.c_str());
+      return false;
+    }
+  }
+  return std::rename(tmp_file_name.c_str(), file_name.c_str()) == 0;
+}
+
+size_t BufferPoolManager::LoadResidentPages(const std::string &file_name) {
+  std::ifstream in(file_name, std::ios::binary);
+  uint32_t header[2];
+  if (!in.read(reinterpret_cast<char *>(header), sizeof(header)) || header[0] != RESIDENT_PAGE_DUMP_MAGIC) {
+    return 0;
+  }
+  std::vector<page_id_t> page_ids(header[1]);
+  if (!in.read(reinterpret_cast<char *>(page_ids.data()), page_ids.size() * sizeof(page_id_t))) {
+    LOG_WARN("truncated resident page dump %s", file_name.c_str());
+    return 0;
+  }
+  return LoadResidentPagesImpl(page_ids);
+}
+
+void BufferPoolManager::StartResidentPageDumps(const std::string &file_name, std::chrono::milliseconds interval) {
+  std::scoped_lock<std::mutex> latch(dump_latch_);
+  if (dump_stop_ || dump_thread_.joinable()) {
+    return;
+  }
+  dump_thread_ = std::thread(&BufferPoolManager::ResidentPageDumpLoop, this, file_name, interval);
+}
+
+void BufferPoolManager::StopResidentPageDumps() {
+  {
+    std::scoped_lock<std::mutex> latch(dump_latch_);
+    dump_stop_ = true;
+    dump_cv_.notify_one();
+  }
+  if (dump_thread_.joinable()) {
+    dump_thread_.join();
+  }
+}
+
+void BufferPoolManager::ResidentPageDumpLoop(std::string file_name, std::chrono::milliseconds interval) {
+  std::unique_lock<std::mutex> latch(dump_latch_);
+  while (!dump_cv_.wait_for(latch, interval, [&] { return dump_stop_; })) {
+    WriteResidentPages(file_name);
+  }
+}
+
+void BufferPoolManager::ListResidentPagesImpl(std::vector<page_id_t> *page_ids) {
+  std::shared_lock<std::shared_mutex> latch(latch_);
+  std::vector<frame_id_t> victims;
+  replacer_->PeekVictims(pool_size_, &victims);
+  std::vector<bool> listed(pool_size_, false);
+  for (frame_id_t frame_id : victims) {
+    if (pages_[frame_id].GetPageId() != INVALID_PAGE_ID) {
+      page_ids->push_back(pages_[frame_id].GetPageId());
+      listed[frame_id] = true;
+    }
+  }
+  // Whatever is not a victim yet is pinned, i.e. in use right now, so it goes last.
+  for (const auto &[page_id, frame_id] : page_table_) {
+    if (!listed[frame_id]) {
+      page_ids->push_back(page_id);
+    }
+  }
+}
+
+size_t BufferPoolManager::LoadResidentPagesImpl(const std::vector<page_id_t> &page_ids) {
+  std::scoped_lock<std::shared_mutex> latch(latch_);
+  // Keep the hottest pages that fit into the free frames, skipping any that are already resident.
+  std::vector<page_id_t> to_load;
+  std::unordered_map<page_id_t, frame_id_t> loaded;
+  for (auto it = page_ids.rbegin(); it != page_ids.rend() && to_load.size() < free_list_.size(); ++it) {
+    if (*it >= 0 && page_table_.count(*it) == 0 && writing_back_.count(*it) == 0 && loaded.emplace(*it, -1).second) {
+      to_load.push_back(*it);
+    }
+  }
+  // Read them in page id order, so that the disk sees one sequential sweep.
+  std::sort(to_load.begin(), to_load.end());
+  std::vector<Page *> reads;
+  for (page_id_t page_id : to_load) {
+    frame_id_t frame_id = free_list_.front();
+    free_list_.pop_front();
+    Page &page = pages_[frame_id];
+    page.page_id_ = page_id;
+    page.pin_count_ = 0;
+    page.is_dirty_ = false;
+    reads.push_back(&page);
+    page_table_[page_id] = frame_id;
+    loaded[page_id] = frame_id;
+  }
+  ReadPagesFromDisk(reads);
+  // Hand them to the replacer coldest first, so that it evicts them in the order they would have been evicted.
+  for (page_id_t page_id : page_ids) {
+    auto it = loaded.find(page_id);
+    if (it != loaded.end() && it->second != -1) {
+      replacer_->Unpin(it->second);
+      it->second = -1;
+    }
+  }
+  return to_load.size();
+}
+
+Page *BufferPoolManager::InitNewPage(frame_id_t frame_id, page_id_t page_id) {
+  // The disk manager reuses deallocated page ids, so the id may still name a page that was loaded from before (e.g. by
+  // LoadResidentPages). That copy is stale now; drop it so it cannot shadow the new one. If somebody still has it
+  // pinned, the page cannot be created under this id without pulling the frame out from under them.
+  auto stale = page_table_.find(page_id);
+  if (stale != page_table_.end() && pages_[stale->second].GetPinCount() > 0) {
     return nullptr;
   }
+  if (stale != page_table_.end()) {
+    replacer_->Remove(stale->second);
+    free_list_.push_back(stale->second);
+    pages_[stale->second].page_id_ = INVALID_PAGE_ID;
+    pages_[stale->second].is_dirty_ = false;
+    pages_[stale->second].is_prefetched_ = false;
+    page_table_.erase(stale);
+  }
   Page &page = pages_[frame_id];
-  *page_id = page.page_id_ = disk_manager_->AllocatePage();
+  page.page_id_ = page_id;
   page.pin_count_ = 1;
   page.is_dirty_ = false;
-  page.ResetMemory();
-  disk_manager_->WritePage(page.GetPageId(), page.GetData());
+  page.io_in_progress_ = true;
   page_table_[page.GetPageId()] = frame_id;
+  replacer_->RecordPageAccess(frame_id, page_id);
   return &page;
 }
 
@@ -177,33 +1081,91 @@ bool BufferPoolManager::DeletePageImpl(page_id_t page_id) {
   // 1.   If P does not exist, return true.
   // 2.   If P exists, but has a non-zero pin-count, return false. Someone is using the page.
   // 3.   Otherwise, P can be deleted. Remove P from the page table, reset its metadata and return it to the free list.
-  std::scoped_lock<std::mutex> latch(latch_);
-  disk_manager_->DeallocatePage(page_id);
+  // The page id is only given back once nobody can touch the page any more: the disk manager may hand it out again
+  // right away, and a write-back of the old contents must not land on top of the new page.
+  std::unique_lock<std::shared_mutex> latch(latch_);
+  WaitForWriteBack(&latch, page_id);
   auto it = page_table_.find(page_id);
   if (it == page_table_.end()) {
+    disk_manager_->DeallocatePage(page_id);
     return true;
   }
   Page &page = pages_[it->second];
   if (page.GetPinCount() != 0) {
     return false;
   }
-  replacer_->Pin(it->second);
+  disk_manager_->DeallocatePage(page_id);
+  replacer_->Remove(it->second);
   free_list_.push_back(it->second);
   page.page_id_ = INVALID_PAGE_ID;
   page.pin_count_ = 0;
   page.is_dirty_ = false;
+  page.is_prefetched_ = false;
   page_table_.erase(page_id);
   return true;
 }
 
 void BufferPoolManager::FlushAllPagesImpl() {
-  std::scoped_lock<std::mutex> latch(latch_);
-  for (const auto kv : page_table_) {
-    Page &page = pages_[kv.second];
-    if (page.IsDirty()) {
-      page.is_dirty_ = false;
-      disk_manager_->WritePage(page.GetPageId(), page.GetData());
+  std::unique_ptr<char, decltype(&std::free)> images(nullptr, &std::free);
+  std::vector<Page *> dirty_pages;
+  {
+    std::unique_lock<std::shared_mutex> latch(latch_);
+    // Resident pages can only be in writing_back_ while an older image of them is written; ours must land after it.
+    write_back_cv_.wait(latch, [&] {
+      return std::none_of(writing_back_.begin(), writing_back_.end(),
+                          [&](page_id_t page_id) { return page_table_.count(page_id) > 0; });
+    });
+    for (const auto kv : page_table_) {
+      if (pages_[kv.second].IsDirty()) {
+        dirty_pages.push_back(&pages_[kv.second]);
+      }
+    }
+    if (dirty_pages.empty()) {
+      return;
+    }
+    images.reset(static_cast<char *>(std::aligned_alloc(page_size_, dirty_pages.size() * page_size_)));
+    if (images == nullptr) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "can't allocate the images of the pages to flush");
     }
+    // Pinned so that their frames stay put while we wait for their page latches below, and in writing_back_ like the
+    // background writer's pages, so that nobody writes a newer image before our copies are on disk.
+    for (Page *page : dirty_pages) {
+      if (page->pin_count_.fetch_add(1) == 0) {
+        replacer_->Pin(static_cast<frame_id_t>(page - pages_));
+      }
+      writing_back_.insert(page->GetPageId());
+    }
+  }
+
+  // The copies are taken under the page latches, without latch_, so that users holding a page latch are not blocked
+  // out of the buffer pool in the meantime. Clearing the flag under the page latch means a later update marks the page
+  // dirty again.
+  std::vector<std::pair<page_id_t, const char *>> writes;
+  writes.reserve(dirty_pages.size());
+  for (Page *page : dirty_pages) {
+    char *image = images.get() + writes.size() * page_size_;
+    page->RLatch();
+    memcpy(image, page->GetData(), page_size_);
+    page->is_dirty_ = false;
+    page->RUnlatch();
+    writes.emplace_back(page->GetPageId(), image);
+  }
+  {
+    std::shared_lock<std::shared_mutex> latch(latch_);
+    for (const auto &[page_id, image] : writes) {
+      UnpinPageLocked(page_id, false);
+    }
+  }
+
+  // One batch lets the disk manager write neighbouring pages together and sync only once.
+  auto start = std::chrono::steady_clock::now();
+  disk_manager_->WritePages(writes);
+  metrics_.Add(BufferPoolMetrics::WRITES, writes.size());
+  metrics_.Add(BufferPoolMetrics::WRITE_NANOS, NanosSince(start));
+  metrics_.Add(BufferPoolMetrics::FLUSHES, writes.size());
+  std::scoped_lock<std::shared_mutex> latch(latch_);
+  for (const auto &[page_id, image] : writes) {
+    FinishWriteBack(page_id);
   }
 }
 
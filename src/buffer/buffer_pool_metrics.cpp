@@ -0,0 +1,84 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_metrics.cpp
+//
+// Identification: src/buffer/buffer_pool_metrics.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/buffer_pool_metrics.h"
+
+#include <sstream>
+
+namespace bustub {
+
+double BufferPoolStats::HitRatio() const {
+  uint64_t fetches = hits_ + misses_;
+  return fetches == 0 ? 0 : static_cast<double>(hits_) / static_cast<double>(fetches);
+}
+
+double BufferPoolStats::AverageReadMicros() const {
+  return reads_ == 0 ? 0 : static_cast<double>(read_nanos_) / static_cast<double>(reads_) / 1000;
+}
+
+double BufferPoolStats::AverageWriteMicros() const {
+  return writes_ == 0 ? 0 : static_cast<double>(write_nanos_) / static_cast<double>(writes_) / 1000;
+}
+
+BufferPoolStats &BufferPoolStats::operator+=(const BufferPoolStats &other) {
+  hits_ += other.hits_;
+  misses_ += other.misses_;
+  evictions_ += other.evictions_;
+  dirty_evictions_ += other.dirty_evictions_;
+  flushes_ += other.flushes_;
+  reads_ += other.reads_;
+  read_nanos_ += other.read_nanos_;
+  writes_ += other.writes_;
+  write_nanos_ += other.write_nanos_;
+  io_waits_ += other.io_waits_;
+  io_wait_nanos_ += other.io_wait_nanos_;
+  return *this;
+}
+
+std::string BufferPoolStats::ToString() const {
+  std::ostringstream os;
+  os << "hits=" << hits_ << " misses=" << misses_ << " hit_ratio=" << HitRatio() << " evictions=" << evictions_
+     << " dirty_evictions=" << dirty_evictions_ << " flushes=" << flushes_ << " reads=" << reads_
+     << " avg_read_us=" << AverageReadMicros() << " writes=" << writes_ << " avg_write_us=" << AverageWriteMicros()
+     << " io_waits=" << io_waits_ << " io_wait_us=" << io_wait_nanos_ / 1000;
+  return os.str();
+}
+
+BufferPoolStats BufferPoolMetrics::Snapshot() const {
+  std::array<uint64_t, NUM_COUNTERS> sums{};
+  for (const Stripe &stripe : stripes_) {
+    for (size_t i = 0; i < NUM_COUNTERS; ++i) {
+      sums[i] += stripe.counters_[i].load(std::memory_order_relaxed);
+    }
+  }
+  BufferPoolStats stats;
+  stats.hits_ = sums[HITS];
+  stats.misses_ = sums[MISSES];
+  stats.evictions_ = sums[EVICTIONS];
+  stats.dirty_evictions_ = sums[DIRTY_EVICTIONS];
+  stats.flushes_ = sums[FLUSHES];
+  stats.reads_ = sums[READS];
+  stats.read_nanos_ = sums[READ_NANOS];
+  stats.writes_ = sums[WRITES];
+  stats.write_nanos_ = sums[WRITE_NANOS];
+  stats.io_waits_ = sums[IO_WAITS];
+  stats.io_wait_nanos_ = sums[IO_WAIT_NANOS];
+  return stats;
+}
+
+size_t BufferPoolMetrics::StripeOfThisThread() {
+  static std::atomic<size_t> next_stripe{0};
+  thread_local size_t stripe = next_stripe.fetch_add(1, std::memory_order_relaxed) % NUM_STRIPES;
+  return stripe;
+}
+
+}  // namespace bustub
@@ -14,16 +14,78 @@
 
 namespace bustub {
 
-ClockReplacer::ClockReplacer(size_t num_pages) {}
+ClockReplacer::ClockReplacer(size_t num_pages)
+    : num_frames_(num_pages), states_(std::make_unique<std::atomic<uint8_t>[]>(num_pages)) {
+  for (size_t i = 0; i < num_frames_; ++i) {
+    states_[i].store(0, std::memory_order_relaxed);
+  }
+}
 
 ClockReplacer::~ClockReplacer() = default;
 
-bool ClockReplacer::Victim(frame_id_t *frame_id) { return false; }
+bool ClockReplacer::Victim(frame_id_t *frame_id) {
+  if (num_frames_ == 0) {
+    return false;
+  }
+  // With every frame referenced, the first revolution clears the bits and the second finds a victim. Check for an
+  // empty replacer once per revolution, so that concurrent pins cannot keep us spinning forever.
+  for (size_t scanned = 0;; ++scanned) {
+    if (scanned % num_frames_ == 0 && size_.load(std::memory_order_acquire) == 0) {
+      return false;
+    }
+    size_t pos = hand_.fetch_add(1, std::memory_order_relaxed) % num_frames_;
+    uint8_t state = states_[pos].load(std::memory_order_acquire);
+    if ((state & IN_REPLACER) == 0) {
+      continue;
+    }
+    if ((state & REFERENCED) != 0) {
+      // A failed exchange means the frame was pinned or touched meanwhile; either way it is not our victim now.
+      states_[pos].compare_exchange_strong(state, IN_REPLACER, std::memory_order_acq_rel);
+      continue;
+    }
+    if (states_[pos].compare_exchange_strong(state, 0, std::memory_order_acq_rel)) {
+      size_.fetch_sub(1, std::memory_order_release);
+      *frame_id = static_cast<frame_id_t>(pos);
+      return true;
+    }
+  }
+}
 
-void ClockReplacer::Pin(frame_id_t frame_id) {}
+void ClockReplacer::Pin(frame_id_t frame_id) {
+  if ((states_[frame_id].exchange(0, std::memory_order_acq_rel) & IN_REPLACER) != 0) {
+    size_.fetch_sub(1, std::memory_order_release);
+  }
+}
 
-void ClockReplacer::Unpin(frame_id_t frame_id) {}
+void ClockReplacer::Unpin(frame_id_t frame_id) {
+  if ((states_[frame_id].fetch_or(IN_REPLACER | REFERENCED, std::memory_order_acq_rel) & IN_REPLACER) == 0) {
+    size_.fetch_add(1, std::memory_order_release);
+  }
+}
 
-size_t ClockReplacer::Size() { return 0; }
+void ClockReplacer::PeekVictims(size_t count, std::vector<frame_id_t> *frame_ids) {
+  if (num_frames_ == 0) {
+    return;
+  }
+  size_t hand = hand_.load(std::memory_order_relaxed) % num_frames_;
+  std::vector<frame_id_t> referenced;
+  for (size_t i = 0; i < num_frames_ && frame_ids->size() < count; ++i) {
+    size_t pos = (hand + i) % num_frames_;
+    uint8_t state = states_[pos].load(std::memory_order_acquire);
+    if ((state & IN_REPLACER) == 0) {
+      continue;
+    }
+    if ((state & REFERENCED) != 0) {
+      referenced.push_back(static_cast<frame_id_t>(pos));
+    } else {
+      frame_ids->push_back(static_cast<frame_id_t>(pos));
+    }
+  }
+  for (size_t i = 0; i < referenced.size() && frame_ids->size() < count; ++i) {
+    frame_ids->push_back(referenced[i]);
+  }
+}
+
+size_t ClockReplacer::Size() { return size_.load(std::memory_order_acquire); }
 
 }  // namespace bustub
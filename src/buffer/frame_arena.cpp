@@ -0,0 +1,67 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena.cpp
+//
+// Identification: src/buffer/frame_arena.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/frame_arena.h"
+
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <cstdint>
+
+#include "common/exception.h"
+#include "common/logger.h"
+
+namespace bustub {
+
+FrameArena::FrameArena(size_t num_frames, size_t frame_size) : frame_size_(frame_size) {
+  size_t size = std::max<size_t>(num_frames * frame_size, frame_size);
+  // Small arenas are not worth a huge page; they only need their frames aligned.
+  size_t alignment = size >= HUGE_PAGE_SIZE ? HUGE_PAGE_SIZE : frame_size;
+  mapped_size_ = (size + alignment - 1) / alignment * alignment;
+
+#ifdef MAP_HUGETLB
+  if (alignment == HUGE_PAGE_SIZE) {
+    void *data = mmap(nullptr, mapped_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (data != MAP_FAILED) {
+      data_ = static_cast<char *>(data);
+      huge_tlb_ = true;
+      return;
+    }
+  }
+#endif
+
+  // Over-map by one alignment unit and trim both ends, which leaves an aligned region of mapped_size_ bytes.
+  size_t padded_size = mapped_size_ + alignment;
+  void *data = mmap(nullptr, padded_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (data == MAP_FAILED) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot map the buffer pool frames");
+  }
+  auto start = reinterpret_cast<uintptr_t>(data);
+  auto aligned = (start + alignment - 1) / alignment * alignment;
+  if (aligned > start) {
+    munmap(data, aligned - start);
+  }
+  if (aligned + mapped_size_ < start + padded_size) {
+    munmap(reinterpret_cast<void *>(aligned + mapped_size_), start + padded_size - aligned - mapped_size_);
+  }
+  data_ = reinterpret_cast<char *>(aligned);
+
+#ifdef MADV_HUGEPAGE
+  if (alignment == HUGE_PAGE_SIZE && madvise(data_, mapped_size_, MADV_HUGEPAGE) != 0) {
+    LOG_DEBUG("transparent huge pages are not available for the buffer pool");
+  }
+#endif
+}
+
+FrameArena::~FrameArena() { munmap(data_, mapped_size_); }
+
+}  // namespace bustub
@@ -0,0 +1,183 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer.cpp
+//
+// Identification: src/buffer/lru_k_replacer.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/lru_k_replacer.h"
+
+#include <algorithm>
+
+namespace bustub {
+
+LRUKReplacer::LRUKReplacer(size_t num_pages, size_t k, uint64_t correlated_period)
+    : k_(k == 0 ? 1 : k), correlated_period_(correlated_period), histories_(num_pages) {}
+
+/**
+ * @brief Remove the evictable frame with the largest backward k-distance.
+ *
+ * @param frame_id output parameter
+ * @return true if a victim was found, and its id is stored in @param frame_id.
+ * @return false if no frame is evictable.
+ */
+bool LRUKReplacer::Victim(frame_id_t *frame_id) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  while (!victims_.empty()) {
+    frame_id_t candidate = std::get<2>(*victims_.begin());
+    FrameHistory &history = histories_[candidate];
+    if (history.last_access_.load() != history.folded_access_) {
+      // Accessed since it was filed, so it belongs further back.
+      victims_.erase(victims_.begin());
+      Fold(&history);
+      Enqueue(candidate);
+      continue;
+    }
+    victims_.erase(victims_.begin());
+    Reset(&history);
+    *frame_id = candidate;
+    return true;
+  }
+  return false;
+}
+
+/**
+ * @brief This method should be called after a page is pinned in the BufferPoolManager.
+ * The frame keeps its access history but can no longer be victimized.
+ *
+ * @param frame_id id of the pinned frame
+ */
+void LRUKReplacer::Pin(frame_id_t frame_id) {
+  if (static_cast<size_t>(frame_id) >= histories_.size()) {
+    return;
+  }
+  std::scoped_lock<std::mutex> lock(latch_);
+  FrameHistory &history = histories_[frame_id];
+  if (history.evictable_.load()) {
+    victims_.erase(history.position_);
+    history.evictable_.store(false);
+  }
+  Fold(&history);
+}
+
+/**
+ * @brief This method should be called when the pin_count of a page becomes 0.
+ * A frame that has never been accessed is started with a single access.
+ *
+ * @param frame_id id of the unpinned frame
+ */
+void LRUKReplacer::Unpin(frame_id_t frame_id) {
+  if (static_cast<size_t>(frame_id) >= histories_.size()) {
+    return;
+  }
+  std::scoped_lock<std::mutex> lock(latch_);
+  FrameHistory &history = histories_[frame_id];
+  if (history.evictable_.load()) {
+    return;
+  }
+  Fold(&history);
+  if (history.accesses_.empty()) {
+    history.accesses_.push_back(++current_timestamp_);
+  }
+  Enqueue(frame_id);
+}
+
+/**
+ * @brief Record an access to the page held by the frame. The frame is tracked as pinned until it is unpinned.
+ * Only stamps the frame; the access is folded into its history later, under the latch.
+ *
+ * @param frame_id id of the accessed frame
+ */
+void LRUKReplacer::RecordAccess(frame_id_t frame_id) {
+  if (static_cast<size_t>(frame_id) >= histories_.size()) {
+    return;
+  }
+  FrameHistory &history = histories_[frame_id];
+  uint64_t now = ++current_timestamp_;
+  uint64_t seen = history.last_access_.load();
+  // Keep the newest timestamp; a concurrent access may have stamped a later one already.
+  while (seen < now && !history.last_access_.compare_exchange_weak(seen, now)) {
+  }
+}
+
+/**
+ * @brief Drop the frame and its access history, so the next page placed in it starts from scratch.
+ *
+ * @param frame_id id of the frame to forget
+ */
+void LRUKReplacer::Remove(frame_id_t frame_id) {
+  if (static_cast<size_t>(frame_id) >= histories_.size()) {
+    return;
+  }
+  std::scoped_lock<std::mutex> lock(latch_);
+  FrameHistory &history = histories_[frame_id];
+  if (history.evictable_.load()) {
+    victims_.erase(history.position_);
+  }
+  Reset(&history);
+}
+
+/**
+ * @brief List the evictable frames with the largest backward k-distance, starting with the one Victim would pick.
+ * Accesses that have not been folded in yet are not taken into account.
+ *
+ * @param count the maximum number of frames to list
+ * @param frame_ids output parameter
+ */
+void LRUKReplacer::PeekVictims(size_t count, std::vector<frame_id_t> *frame_ids) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  for (auto it = victims_.begin(); it != victims_.end() && count > 0; ++it, --count) {
+    frame_ids->push_back(std::get<2>(*it));
+  }
+}
+
+/**
+ * @brief This method returns the number of frames that can currently be victimized.
+ *
+ * @return size_t # of evictable frames
+ */
+size_t LRUKReplacer::Size() {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return victims_.size();
+}
+
+void LRUKReplacer::Fold(FrameHistory *history) {
+  uint64_t timestamp = history->last_access_.load();
+  if (timestamp == 0 || timestamp == history->folded_access_) {
+    return;
+  }
+  history->folded_access_ = timestamp;
+  auto &accesses = history->accesses_;
+  bool uncorrelated = !accesses.empty() && timestamp - accesses.back() > correlated_period_;
+  if (accesses.empty() || uncorrelated) {
+    accesses.push_back(timestamp);
+    if (accesses.size() > k_) {
+      accesses.pop_front();
+    }
+    return;
+  }
+  accesses.back() = std::max(accesses.back(), timestamp);
+}
+
+void LRUKReplacer::Enqueue(frame_id_t frame_id) {
+  FrameHistory &history = histories_[frame_id];
+  // The front of the history is the k-th most recent access once the history is full, and the oldest access
+  // otherwise; the smaller it is, the further back in time the frame was last useful.
+  bool finite = history.accesses_.size() >= k_;
+  history.position_ = victims_.emplace(finite, history.accesses_.front(), frame_id).first;
+  history.evictable_.store(true);
+}
+
+void LRUKReplacer::Reset(FrameHistory *history) {
+  history->accesses_.clear();
+  history->last_access_.store(0);
+  history->folded_access_ = 0;
+  history->evictable_.store(false);
+}
+
+}  // namespace bustub
@@ -86,6 +86,19 @@ void LRUReplacer::Unpin(frame_id_t frame_id) {
   mps[frame_id] = mkNode(frame_id);
 }
 
+/**
+ * @brief List the least recently used frames, starting with the one Victim would pick.
+ *
+ * @param count the maximum number of frames to list
+ * @param frame_ids output parameter
+ */
+void LRUReplacer::PeekVictims(size_t count, std::vector<frame_id_t> *frame_ids) {
+  std::scoped_lock<std::mutex> lock(this->latch);
+  for (pNode node = this->tail->prev; node != this->head && frame_ids->size() < count; node = node->prev) {
+    frame_ids->push_back(node->frame_id);
+  }
+}
+
 /**
  * @brief This method returns the number of frames that are currently in the LRUReplacer.
  *
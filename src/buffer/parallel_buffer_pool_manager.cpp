@@ -0,0 +1,187 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_buffer_pool_manager.cpp
+//
+// Identification: src/buffer/parallel_buffer_pool_manager.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/parallel_buffer_pool_manager.h"
+
+#include <vector>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+ParallelBufferPoolManager::ParallelBufferPoolManager(size_t num_instances, size_t pool_size,
+                                                     DiskManager *disk_manager, LogManager *log_manager,
+                                                     ReplacerType replacer_type)
+    : BufferPoolManager(0, disk_manager, log_manager), instance_pool_size_(pool_size) {
+  BUSTUB_ASSERT(num_instances > 0, "A parallel buffer pool needs at least one instance.");
+  instances_.reserve(num_instances);
+  for (size_t i = 0; i < num_instances; ++i) {
+    instances_.push_back(new BufferPoolManager(pool_size, disk_manager, log_manager, replacer_type));
+  }
+}
+
+ParallelBufferPoolManager::~ParallelBufferPoolManager() {
+  // The prefetcher and the dump thread route into the instances, so they have to be gone before they are.
+  StopPrefetcher();
+  StopResidentPageDumps();
+  for (auto *instance : instances_) {
+    delete instance;
+  }
+}
+
+BufferPoolManager *ParallelBufferPoolManager::GetBufferPoolManager(page_id_t page_id) {
+  return instances_[static_cast<size_t>(page_id) % instances_.size()];
+}
+
+Page *ParallelBufferPoolManager::FetchPageImpl(page_id_t page_id) {
+  return GetBufferPoolManager(page_id)->FetchPageImpl(page_id);
+}
+
+Page *ParallelBufferPoolManager::FetchPageWithStrategyImpl(page_id_t page_id, BufferAccessStrategy *strategy) {
+  return GetBufferPoolManager(page_id)->FetchPageWithStrategyImpl(page_id, strategy);
+}
+
+void ParallelBufferPoolManager::FetchPagesImpl(const std::vector<page_id_t> &page_ids, std::vector<Page *> *pages) {
+  std::vector<std::vector<page_id_t>> instance_page_ids(instances_.size());
+  std::vector<std::vector<size_t>> instance_positions(instances_.size());
+  for (size_t i = 0; i < page_ids.size(); ++i) {
+    size_t instance = static_cast<size_t>(page_ids[i]) % instances_.size();
+    instance_page_ids[instance].push_back(page_ids[i]);
+    instance_positions[instance].push_back(i);
+  }
+  pages->assign(page_ids.size(), nullptr);
+  std::vector<Page *> instance_pages;
+  for (size_t instance = 0; instance < instances_.size(); ++instance) {
+    if (instance_page_ids[instance].empty()) {
+      continue;
+    }
+    instances_[instance]->FetchPagesImpl(instance_page_ids[instance], &instance_pages);
+    for (size_t j = 0; j < instance_pages.size(); ++j) {
+      (*pages)[instance_positions[instance][j]] = instance_pages[j];
+    }
+  }
+}
+
+page_id_t ParallelBufferPoolManager::PrefetchPageImpl(page_id_t page_id, next_page_fn next_page) {
+  return GetBufferPoolManager(page_id)->PrefetchPageImpl(page_id, next_page);
+}
+
+void ParallelBufferPoolManager::PrefetchPagesImpl(const std::vector<page_id_t> &page_ids) {
+  std::vector<std::vector<page_id_t>> instance_page_ids(instances_.size());
+  for (page_id_t page_id : page_ids) {
+    instance_page_ids[static_cast<size_t>(page_id) % instances_.size()].push_back(page_id);
+  }
+  for (size_t i = 0; i < instances_.size(); ++i) {
+    if (!instance_page_ids[i].empty()) {
+      instances_[i]->PrefetchPagesImpl(instance_page_ids[i]);
+    }
+  }
+}
+
+void ParallelBufferPoolManager::ListResidentPagesImpl(std::vector<page_id_t> *page_ids) {
+  for (auto *instance : instances_) {
+    instance->ListResidentPagesImpl(page_ids);
+  }
+}
+
+size_t ParallelBufferPoolManager::LoadResidentPagesImpl(const std::vector<page_id_t> &page_ids) {
+  std::vector<std::vector<page_id_t>> instance_page_ids(instances_.size());
+  for (page_id_t page_id : page_ids) {
+    if (page_id >= 0) {
+      instance_page_ids[static_cast<size_t>(page_id) % instances_.size()].push_back(page_id);
+    }
+  }
+  size_t num_loaded = 0;
+  for (size_t i = 0; i < instances_.size(); ++i) {
+    num_loaded += instances_[i]->LoadResidentPagesImpl(instance_page_ids[i]);
+  }
+  return num_loaded;
+}
+
+BufferPoolStats ParallelBufferPoolManager::GetStats() {
+  BufferPoolStats stats;
+  for (auto *instance : instances_) {
+    stats += instance->GetStats();
+  }
+  return stats;
+}
+
+void ParallelBufferPoolManager::GetFrameStatesImpl(std::vector<FrameState> *frames) {
+  for (size_t i = 0; i < instances_.size(); ++i) {
+    size_t first = frames->size();
+    instances_[i]->GetFrameStatesImpl(frames);
+    for (size_t j = first; j < frames->size(); ++j) {
+      (*frames)[j].frame_id_ += static_cast<frame_id_t>(i * instance_pool_size_);
+    }
+  }
+}
+
+bool ParallelBufferPoolManager::UnpinPageImpl(page_id_t page_id, bool is_dirty) {
+  return GetBufferPoolManager(page_id)->UnpinPageImpl(page_id, is_dirty);
+}
+
+bool ParallelBufferPoolManager::UnpinPagesImpl(const std::vector<page_id_t> &page_ids, bool is_dirty) {
+  std::vector<std::vector<page_id_t>> instance_page_ids(instances_.size());
+  for (page_id_t page_id : page_ids) {
+    instance_page_ids[static_cast<size_t>(page_id) % instances_.size()].push_back(page_id);
+  }
+  bool all_pinned = true;
+  for (size_t i = 0; i < instances_.size(); ++i) {
+    if (!instance_page_ids[i].empty()) {
+      all_pinned = instances_[i]->UnpinPagesImpl(instance_page_ids[i], is_dirty) && all_pinned;
+    }
+  }
+  return all_pinned;
+}
+
+bool ParallelBufferPoolManager::FlushPageImpl(page_id_t page_id) {
+  return GetBufferPoolManager(page_id)->FlushPageImpl(page_id);
+}
+
+Page *ParallelBufferPoolManager::NewPageInFileImpl(file_id_t file_id, page_id_t *page_id) {
+  // Page ids come from the disk manager, which reuses deallocated ids first and then hands out new ones in order, so
+  // retrying eventually lands on every instance. Ids whose instance was full are given back once we are done.
+  std::vector<page_id_t> rejected;
+  std::vector<bool> tried(instances_.size(), false);
+  size_t num_tried = 0;
+  Page *page = nullptr;
+  while (page == nullptr && num_tried < instances_.size()) {
+    page_id_t candidate = disk_manager_->AllocatePage(file_id);
+    size_t instance = static_cast<size_t>(candidate) % instances_.size();
+    if (!tried[instance]) {
+      tried[instance] = true;
+      ++num_tried;
+      page = instances_[instance]->NewPageWithId(candidate);
+    }
+    if (page == nullptr) {
+      rejected.push_back(candidate);
+    } else {
+      *page_id = candidate;
+    }
+  }
+  for (auto candidate : rejected) {
+    disk_manager_->DeallocatePage(candidate);
+  }
+  return page;
+}
+
+bool ParallelBufferPoolManager::DeletePageImpl(page_id_t page_id) {
+  return GetBufferPoolManager(page_id)->DeletePageImpl(page_id);
+}
+
+void ParallelBufferPoolManager::FlushAllPagesImpl() {
+  for (auto *instance : instances_) {
+    instance->FlushAllPagesImpl();
+  }
+}
+
+}  // namespace bustub
@@ -20,4 +20,16 @@ std::chrono::duration<int64_t> log_timeout = std::chrono::seconds(1);
 
 std::chrono::milliseconds cycle_detection_interval = std::chrono::milliseconds(50);
 
+std::atomic<size_t> read_ahead_window(8);
+
+std::atomic<double> bg_writer_low_watermark(0.1);
+
+std::atomic<double> bg_writer_high_watermark(0.25);
+
+std::chrono::milliseconds bg_writer_interval = std::chrono::milliseconds(10);
+
+std::chrono::milliseconds buffer_pool_dump_interval = std::chrono::milliseconds(0);
+
+std::atomic<ChecksumMode> page_checksum_mode(ChecksumMode::OFF);
+
 }  // namespace bustub
@@ -0,0 +1,85 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// crc32c.cpp
+//
+// Identification: src/common/crc32c.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/crc32c.h"
+
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#define BUSTUB_HAS_SSE42_CRC
+#endif
+
+namespace bustub {
+
+namespace {
+
+// The Castagnoli polynomial, bit-reversed.
+constexpr uint32_t CRC32C_POLY = 0x82F63B78;
+
+constexpr std::array<uint32_t, 256> MakeCrc32cTable() {
+  std::array<uint32_t, 256> table{};
+  for (uint32_t i = 0; i < 256; ++i) {
+    uint32_t crc = i;
+    for (int bit = 0; bit < 8; ++bit) {
+      crc = (crc & 1) != 0 ? (crc >> 1) ^ CRC32C_POLY : crc >> 1;
+    }
+    table[i] = crc;
+  }
+  return table;
+}
+
+constexpr std::array<uint32_t, 256> CRC32C_TABLE = MakeCrc32cTable();
+
+#ifdef BUSTUB_HAS_SSE42_CRC
+__attribute__((target("sse4.2"))) uint32_t Crc32cHardware(const char *data, size_t size) {
+  uint64_t crc = 0xFFFFFFFF;
+  for (; size >= 8; data += 8, size -= 8) {
+    uint64_t word;
+    memcpy(&word, data, sizeof(word));
+    crc = _mm_crc32_u64(crc, word);
+  }
+  auto crc32 = static_cast<uint32_t>(crc);
+  for (; size > 0; ++data, --size) {
+    crc32 = _mm_crc32_u8(crc32, static_cast<uint8_t>(*data));
+  }
+  return ~crc32;
+}
+
+const bool HAS_SSE42 = __builtin_cpu_supports("sse4.2");
+#else
+const bool HAS_SSE42 = false;
+#endif
+
+}  // namespace
+
+uint32_t Crc32cSoftware(const char *data, size_t size) {
+  uint32_t crc = 0xFFFFFFFF;
+  for (size_t i = 0; i < size; ++i) {
+    crc = CRC32C_TABLE[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+
+uint32_t Crc32c(const char *data, size_t size) {
+#ifdef BUSTUB_HAS_SSE42_CRC
+  if (HAS_SSE42) {
+    return Crc32cHardware(data, size);
+  }
+#endif
+  return Crc32cSoftware(data, size);
+}
+
+bool Crc32cIsHardwareAccelerated() { return HAS_SSE42; }
+
+}  // namespace bustub
@@ -0,0 +1,178 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lz4.cpp
+//
+// Identification: src/common/lz4.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/lz4.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+namespace bustub {
+
+namespace {
+
+// A match is at least 4 bytes, and at most 65535 bytes back.
+constexpr size_t MIN_MATCH = 4;
+constexpr size_t MAX_OFFSET = 65535;
+// The format requires the last 5 bytes to be literals, and the last match to start at least 12 bytes before the end.
+constexpr size_t LAST_LITERALS = 5;
+constexpr size_t MF_LIMIT = 12;
+constexpr int HASH_BITS = 12;
+
+uint32_t Read32(const uint8_t *p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+uint32_t Hash(uint32_t sequence) { return (sequence * 2654435761U) >> (32 - HASH_BITS); }
+
+/** Writes the 255-run encoding of a length that did not fit in its 4-bit token field. */
+void WriteLength(uint8_t *out, size_t *op, size_t length) {
+  for (; length >= 255; length -= 255) {
+    out[(*op)++] = 255;
+  }
+  out[(*op)++] = static_cast<uint8_t>(length);
+}
+
+/** Reads the 255-run encoding of a length. @return false if the input ends first */
+bool ReadLength(const uint8_t *in, size_t size, size_t *ip, size_t *length) {
+  uint8_t byte;
+  do {
+    if (*ip >= size) {
+      return false;
+    }
+    byte = in[(*ip)++];
+    *length += byte;
+  } while (byte == 255);
+  return true;
+}
+
+/** Emits a sequence, or the last literals if match_length is 0. @return false if it does not fit */
+bool WriteSequence(const uint8_t *literals, size_t literal_length, size_t offset, size_t match_length, uint8_t *out,
+                   size_t *op, size_t capacity) {
+  size_t needed = 1 + literal_length + literal_length / 255 + 1 + (match_length > 0 ? 2 + match_length / 255 + 1 : 0);
+  if (*op + needed > capacity) {
+    return false;
+  }
+  size_t token_at = (*op)++;
+  uint8_t token = static_cast<uint8_t>(std::min<size_t>(literal_length, 15) << 4);
+  if (literal_length >= 15) {
+    WriteLength(out, op, literal_length - 15);
+  }
+  memcpy(out + *op, literals, literal_length);
+  *op += literal_length;
+  if (match_length > 0) {
+    out[(*op)++] = static_cast<uint8_t>(offset);
+    out[(*op)++] = static_cast<uint8_t>(offset >> 8);
+    size_t length = match_length - MIN_MATCH;
+    token |= static_cast<uint8_t>(std::min<size_t>(length, 15));
+    if (length >= 15) {
+      WriteLength(out, op, length - 15);
+    }
+  }
+  out[token_at] = token;
+  return true;
+}
+
+}  // namespace
+
+size_t Lz4Compress(const char *src, size_t size, char *dst, size_t capacity) {
+  const auto *in = reinterpret_cast<const uint8_t *>(src);
+  auto *out = reinterpret_cast<uint8_t *>(dst);
+  size_t op = 0;
+  size_t anchor = 0;
+  if (size > MF_LIMIT) {
+    // Positions are only candidates; every match is checked, so stale or zero entries are harmless.
+    std::array<uint32_t, 1U << HASH_BITS> table{};
+    size_t match_end = size - LAST_LITERALS;
+    size_t ip = 0;
+    while (ip < size - MF_LIMIT) {
+      uint32_t sequence = Read32(in + ip);
+      uint32_t hash = Hash(sequence);
+      size_t ref = table[hash];
+      table[hash] = static_cast<uint32_t>(ip);
+      if (ref >= ip || ip - ref > MAX_OFFSET || Read32(in + ref) != sequence) {
+        // Step faster through data that does not compress.
+        ip += 1 + ((ip - anchor) >> 6);
+        continue;
+      }
+      while (ip > anchor && ref > 0 && in[ip - 1] == in[ref - 1]) {
+        --ip;
+        --ref;
+      }
+      size_t length = MIN_MATCH;
+      while (ip + length < match_end && in[ref + length] == in[ip + length]) {
+        ++length;
+      }
+      if (!WriteSequence(in + anchor, ip - anchor, ip - ref, length, out, &op, capacity)) {
+        return 0;
+      }
+      ip += length;
+      anchor = ip;
+    }
+  }
+  if (!WriteSequence(in + anchor, size - anchor, 0, 0, out, &op, capacity)) {
+    return 0;
+  }
+  return op;
+}
+
+bool Lz4Decompress(const char *src, size_t size, char *dst, size_t dst_size) {
+  const auto *in = reinterpret_cast<const uint8_t *>(src);
+  auto *out = reinterpret_cast<uint8_t *>(dst);
+  size_t ip = 0;
+  size_t op = 0;
+  while (ip < size) {
+    uint8_t token = in[ip++];
+    size_t literal_length = token >> 4;
+    if (literal_length == 15 && !ReadLength(in, size, &ip, &literal_length)) {
+      return false;
+    }
+    if (literal_length > size - ip || literal_length > dst_size - op) {
+      return false;
+    }
+    memcpy(out + op, in + ip, literal_length);
+    ip += literal_length;
+    op += literal_length;
+    // The last sequence has no match.
+    if (ip == size) {
+      return op == dst_size;
+    }
+    if (size - ip < 2) {
+      return false;
+    }
+    size_t offset = in[ip] | (static_cast<size_t>(in[ip + 1]) << 8);
+    ip += 2;
+    size_t match_length = token & 15;
+    if (match_length == 15 && !ReadLength(in, size, &ip, &match_length)) {
+      return false;
+    }
+    match_length += MIN_MATCH;
+    if (offset == 0 || offset > op || match_length > dst_size - op) {
+      return false;
+    }
+    if (offset >= match_length) {
+      memcpy(out + op, out + op - offset, match_length);
+    } else {
+      // The match overlaps the bytes it produces, which is how runs are encoded.
+      for (size_t i = 0; i < match_length; ++i) {
+        out[op + i] = out[op + i - offset];
+      }
+    }
+    op += match_length;
+  }
+  return false;
+}
+
+}  // namespace bustub
@@ -0,0 +1,85 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// rwlatch.cpp
+//
+// Identification: src/common/rwlatch.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/rwlatch.h"
+
+#include <thread>  // NOLINT
+
+namespace bustub {
+
+namespace {
+
+/** Tell the CPU that we are in a spin loop. */
+inline void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield");
+#endif
+}
+
+}  // namespace
+
+template <class Pred>
+uint32_t ReaderWriterLatch::WaitUntil(Pred pred) {
+  for (int spin = 0; spin < SPIN_LIMIT; ++spin) {
+    uint32_t state = state_.load(std::memory_order_relaxed);
+    if (pred(state)) {
+      return state;
+    }
+    CpuRelax();
+  }
+  std::this_thread::yield();
+
+  // The parked count is raised before the state is checked under park_mutex_, and releasers change the state before
+  // they read the count, so either we see the new state or the releaser sees us and notifies under the mutex.
+  std::unique_lock<std::mutex> lock(park_mutex_);
+  parked_.fetch_add(1, std::memory_order_seq_cst);
+  uint32_t state;
+  park_cv_.wait(lock, [&] { return pred(state = state_.load(std::memory_order_seq_cst)); });
+  parked_.fetch_sub(1, std::memory_order_relaxed);
+  return state;
+}
+
+void ReaderWriterLatch::WLockSlow() {
+  // Enter as the writer; from then on new readers are held back.
+  uint32_t state = state_.load(std::memory_order_relaxed);
+  while (true) {
+    if ((state & WRITER_ENTERED) == 0) {
+      if (state_.compare_exchange_weak(state, state | WRITER_ENTERED, std::memory_order_acquire)) {
+        break;
+      }
+      continue;
+    }
+    state = WaitUntil([](uint32_t s) { return (s & WRITER_ENTERED) == 0; });
+  }
+  // Wait for the readers that got in before us to leave.
+  if ((state & MAX_READERS) != 0) {
+    WaitUntil([](uint32_t s) { return (s & MAX_READERS) == 0; });
+    std::atomic_thread_fence(std::memory_order_acquire);
+  }
+}
+
+void ReaderWriterLatch::RLockSlow() {
+  uint32_t state = state_.load(std::memory_order_relaxed);
+  while (true) {
+    if (CanRead(state)) {
+      if (state_.compare_exchange_weak(state, state + 1, std::memory_order_acquire)) {
+        return;
+      }
+      continue;
+    }
+    state = WaitUntil(CanRead);
+  }
+}
+
+}  // namespace bustub
@@ -33,6 +33,9 @@ void IndexScanExecutor::Init() {
   Index *index = index_info->index_.get();
   key_schema_ = index->GetKeySchema();
   itr_ = dynamic_cast<BPLUSTREE_INDEX_TYPE *>(index)->GetBeginIterator();
+  rids_.clear();
+  tuples_.clear();
+  next_ = 0;
 
   // Get Table and it's schema
   table_ = catalog->GetTable(index_info->table_name_)->table_.get();
@@ -41,18 +44,27 @@ void IndexScanExecutor::Init() {
 bool IndexScanExecutor::Next(Tuple *tuple, RID *rid) {
   BUSTUB_ASSERT(tuple != nullptr, "Tuple have invalid address 'nullptr'!");
   BUSTUB_ASSERT(rid != nullptr, "RID have invalid address 'nullptr'!");
-  const AbstractExpression *predicate = plan_->GetPredicate();
-  Transaction *txn = GetExecutorContext()->GetTransaction();
-  for (Tuple key; !itr_.isEnd(); ++itr_) {
-    key = Tuple({(*itr_).first.ToValue(key_schema_, 0)}, key_schema_);
-    if (predicate == nullptr || predicate->Evaluate(&key, key_schema_).GetAs<bool>()) {
-      *rid = (*itr_).second;
-      BUSTUB_ASSERT(table_->GetTuple(*rid, tuple, txn), "Inconsistence!");
-      ++itr_;
-      return true;
+  if (next_ == rids_.size()) {
+    const AbstractExpression *predicate = plan_->GetPredicate();
+    rids_.clear();
+    next_ = 0;
+    for (Tuple key; !itr_.isEnd() && rids_.size() < BATCH_SIZE; ++itr_) {
+      key = Tuple({(*itr_).first.ToValue(key_schema_, 0)}, key_schema_);
+      if (predicate == nullptr || predicate->Evaluate(&key, key_schema_).GetAs<bool>()) {
+        rids_.push_back((*itr_).second);
+      }
     }
+    if (rids_.empty()) {
+      return false;
+    }
+    // Tuples that share a table page are read under a single fetch of that page.
+    [[maybe_unused]] bool found = table_->GetTuples(rids_, &tuples_, GetExecutorContext()->GetTransaction());
+    BUSTUB_ASSERT(found, "Inconsistence!");
   }
-  return false;
+  *rid = rids_[next_];
+  *tuple = tuples_[next_];
+  ++next_;
+  return true;
 }
 
 }  // namespace bustub
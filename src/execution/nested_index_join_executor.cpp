@@ -26,6 +26,7 @@ void NestIndexJoinExecutor::Init() {
   index_ = catalog->GetIndex(plan_->GetIndexName(), table_info->name_)->index_.get();
   ltuple = Tuple();
   rtuples.clear();
+  rvalues.clear();
   it = rtuples.begin();
 }
 
@@ -42,8 +43,8 @@ generation:
   if (it == rtuples.end()) {
     goto allocation;
   }
-  *rid = *it++;
-  BUSTUB_ASSERT(table_->GetTuple(*rid, &rtuple, txn), "Inconsistence!");
+  rtuple = rvalues[it - rtuples.begin()];
+  ++it;
   values.reserve(GetOutputSchema()->GetColumnCount());
   for (const auto &col : GetOutputSchema()->GetColumns()) {
     values.emplace_back(col.GetExpr()->EvaluateJoin(&ltuple, outer_schema, &rtuple, inner_schema));
@@ -59,6 +60,9 @@ allocation:
     const Schema *chd_schema = child_executor_->GetOutputSchema();
     Tuple key(std::vector<Value>{lcol->Evaluate(&ltuple, chd_schema)}, key_schema);
     index_->ScanKey(key, &rtuples, txn);
+    // Matches that share a table page are read under a single fetch of that page.
+    [[maybe_unused]] bool found = table_->GetTuples(rtuples, &rvalues, txn);
+    BUSTUB_ASSERT(found, "Inconsistence!");
     it = rtuples.begin();
     goto generation;
   }
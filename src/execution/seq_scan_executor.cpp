@@ -11,6 +11,8 @@
 //===----------------------------------------------------------------------===//
 #include "execution/executors/seq_scan_executor.h"
 
+#include <algorithm>
+
 namespace bustub {
 /*
 Hint: Be careful when using the TableIterator object. Make sure that you understand the difference between the
@@ -32,7 +34,16 @@ SeqScanExecutor::SeqScanExecutor(ExecutorContext *exec_ctx, const SeqScanPlanNod
       end_(nullptr, RID(), nullptr),
       start_(false) {}
 
-void SeqScanExecutor::Init() { start_ = true; }
+void SeqScanExecutor::Init() {
+  start_ = true;
+  // A table that fits comfortably in the pool is worth caching, so only larger ones are read through a ring.
+  size_t pool_size = GetExecutorContext()->GetBufferPoolManager()->GetPoolSize();
+  if (table_metadata_->table_->GetNumPages() > pool_size / SCAN_RING_THRESHOLD) {
+    strategy_ = std::make_unique<BufferAccessStrategy>(std::min<size_t>(SCAN_RING_SIZE, pool_size / 4));
+  } else {
+    strategy_.reset();
+  }
+}
 
 bool SeqScanExecutor::Next(Tuple *tuple, RID *rid) {
   BUSTUB_ASSERT(tuple != nullptr, "Tuple have invalid address 'nullptr'!");
@@ -40,7 +51,7 @@ bool SeqScanExecutor::Next(Tuple *tuple, RID *rid) {
   const Schema *output_schema = GetOutputSchema();
   const Schema *table_schema = GetTableSchema();
   if (start_) {
-    itr_ = table_metadata_->table_->Begin(GetTransaction());
+    itr_ = table_metadata_->table_->Begin(GetTransaction(), strategy_.get());
     end_ = table_metadata_->table_->End();
     start_ = false;
   } else {
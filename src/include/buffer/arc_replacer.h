@@ -0,0 +1,124 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// arc_replacer.h
+//
+// Identification: src/include/buffer/arc_replacer.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <list>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * ARCReplacer implements the Adaptive Replacement Cache policy (Megiddo and Modha, FAST '03).
+ *
+ * Resident frames are kept on two LRU lists: T1 holds pages that were accessed once since they were loaded, T2 pages
+ * that were accessed again. Evicted pages leave a ghost entry, keyed by page id, on B1 (evicted from T1) or B2
+ * (evicted from T2). A miss on a page in B1 means T1 was too small, and grows the target size p of T1; a miss on a
+ * page in B2 shrinks it. Victims come from T1 while it is larger than p, and from T2 otherwise. A scan therefore only
+ * ever churns T1, while a lookup-heavy phase lets T2 take over the pool.
+ *
+ * Pinned frames stay on their lists but are skipped when looking for a victim. Frames that show up without a page id
+ * (e.g. pages read ahead) start on T1 and learn their page id on their next access.
+ */
+class ARCReplacer : public Replacer {
+  enum class ListType { NONE, T1, T2 };
+
+  struct GhostEntry {
+    bool in_b2_;
+    std::list<page_id_t>::iterator pos_;
+  };
+
+  struct FrameEntry {
+    ListType list_{ListType::NONE};
+    std::list<frame_id_t>::iterator pos_;
+    page_id_t page_id_{INVALID_PAGE_ID};
+    bool evictable_{false};
+  };
+
+ public:
+  /**
+   * Create a new ARCReplacer.
+   * @param num_pages the maximum number of pages the ARCReplacer will be required to store
+   */
+  explicit ARCReplacer(size_t num_pages);
+
+  /**
+   * Destroys the ARCReplacer.
+   */
+  ~ARCReplacer() override = default;
+
+  bool Victim(frame_id_t *frame_id) override;
+
+  void Pin(frame_id_t frame_id) override;
+
+  void Unpin(frame_id_t frame_id) override;
+
+  /** Accesses without a page id count as hits on whatever page the frame holds. */
+  void RecordAccess(frame_id_t frame_id) override;
+
+  void RecordPageAccess(frame_id_t frame_id, page_id_t page_id) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  void PeekVictims(size_t count, std::vector<frame_id_t> *frame_ids) override;
+
+  size_t Size() override;
+
+  /** @return the current target size of T1, for tests */
+  size_t GetTargetT1Size();
+
+ private:
+  /** @return the list a frame of the given type lives on */
+  std::list<frame_id_t> *ListOf(ListType type) { return type == ListType::T1 ? &t1_ : &t2_; }
+
+  /** Moves a frame to the most recently used end of a list, taking it off its current list first. */
+  void MoveToFront(frame_id_t frame_id, ListType type);
+
+  /** Takes a frame off its list. */
+  void Detach(frame_id_t frame_id);
+
+  /** Adds an evicted page to the front of B1 or B2. */
+  void AddGhost(page_id_t page_id, bool in_b2);
+
+  /** Forgets a ghost page. */
+  void EraseGhost(std::unordered_map<page_id_t, GhostEntry>::iterator ghost);
+
+  /** Marks an access to a resident frame: a frame whose page is known moves to T2, any other to the front of T1. */
+  void Touch(frame_id_t frame_id);
+
+  /** Keeps |T1| + |B1| <= c and |T1| + |T2| + |B1| + |B2| <= 2c by forgetting the oldest ghosts. */
+  void TrimGhosts();
+
+  /** @return the list the next victim comes from, given the current size of T1 and whether each list has one */
+  ListType PickList(size_t t1_size, bool t1_has_victim, bool t2_has_victim) const;
+
+  size_t capacity_;
+  /** Target size of T1. */
+  size_t p_{0};
+  std::vector<FrameEntry> frames_;
+  /** Resident frames, most recently used first. */
+  std::list<frame_id_t> t1_;
+  std::list<frame_id_t> t2_;
+  /** Ghost pages, most recently evicted first, and where each one sits. */
+  std::list<page_id_t> b1_;
+  std::list<page_id_t> b2_;
+  std::unordered_map<page_id_t, GhostEntry> ghosts_;
+  size_t num_evictable_{0};
+  std::mutex latch_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,57 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_access_strategy.h
+//
+// Identification: src/include/buffer/buffer_access_strategy.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <vector>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * BufferAccessStrategy gives a large scan a small private ring of buffer pool frames. Pages the scan has to read from
+ * disk are placed in the ring, and once the ring is full each new page reuses the frame of the page loaded ring_size
+ * misses ago, as long as nobody has it pinned. The scan therefore displaces at most ring_size pages of the shared
+ * working set. Pages that are already resident are used in place and never enter the ring.
+ *
+ * A strategy belongs to a single scan and is not thread-safe.
+ */
+class BufferAccessStrategy {
+  friend class BufferPoolManager;
+
+ public:
+  /**
+   * Creates a new ring.
+   * @param ring_size the number of frames the scan may recycle
+   */
+  explicit BufferAccessStrategy(size_t ring_size) : ring_(ring_size == 0 ? 1 : ring_size, INVALID_PAGE_ID) {}
+
+  /** @return the number of frames in the ring */
+  size_t GetRingSize() const { return ring_.size(); }
+
+ private:
+  /** @return the page whose frame the next miss should reuse, or INVALID_PAGE_ID if that slot is still empty */
+  page_id_t Current() const { return ring_[current_]; }
+
+  /** Records that the next miss was loaded as page_id and moves on to the following slot. */
+  void Advance(page_id_t page_id) {
+    ring_[current_] = page_id;
+    current_ = (current_ + 1) % ring_.size();
+  }
+
+  /** Page ids loaded through the ring, in load order starting at current_. */
+  std::vector<page_id_t> ring_;
+  size_t current_{0};
+};
+
+}  // namespace bustub
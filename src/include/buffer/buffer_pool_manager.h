@@ -12,37 +12,74 @@
 
 #pragma once
 
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <iosfwd>
 #include <list>
-#include <mutex>  // NOLINT
+#include <mutex>         // NOLINT
+#include <shared_mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
+#include "buffer/arc_replacer.h"
+#include "buffer/buffer_access_strategy.h"
+#include "buffer/buffer_pool_metrics.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/frame_arena.h"
+#include "buffer/lru_k_replacer.h"
 #include "buffer/lru_replacer.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/page/page.h"
+#include "storage/page/page_guard.h"
 
 namespace bustub {
 
+/** The state of one buffer pool frame, as reported by BufferPoolManager::GetFrameStates. */
+struct FrameState {
+  frame_id_t frame_id_;
+  /** INVALID_PAGE_ID if the frame is free */
+  page_id_t page_id_;
+  int pin_count_;
+  bool is_dirty_;
+  /** true while the page is being read into the frame */
+  bool io_in_progress_;
+  /** 0 for the frame the replacer would evict next, 1 for the one after it, ...; -1 if it is not evictable or the
+   * replacer cannot tell its order */
+  int replacer_position_;
+};
+
 /**
  * BufferPoolManager reads disk pages to and from its internal buffer pool.
  */
 class BufferPoolManager {
+  // The parallel buffer pool routes page requests into the Impl methods of its instances.
+  friend class ParallelBufferPoolManager;
+
  public:
   enum class CallbackType { BEFORE, AFTER };
   using bufferpool_callback_fn = void (*)(enum CallbackType, const page_id_t page_id);
+  /** Reads the id of the page that follows a page in a chain (e.g. the next table page) from its raw data. */
+  using next_page_fn = page_id_t (*)(const char *page_data);
 
   /**
    * Creates a new BufferPoolManager.
    * @param pool_size the size of the buffer pool
    * @param disk_manager the disk manager
    * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_type the replacement policy used to pick victim frames
    */
-  BufferPoolManager(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager = nullptr);
+  BufferPoolManager(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager = nullptr,
+                    ReplacerType replacer_type = ReplacerType::LRU);
 
   /**
    * Destroys an existing BufferPoolManager.
    */
-  ~BufferPoolManager();
+  virtual ~BufferPoolManager();
 
   /** Grading function. Do not modify! */
   Page *FetchPage(page_id_t page_id, bufferpool_callback_fn callback = nullptr) {
@@ -52,6 +89,43 @@ class BufferPoolManager {
     return result;
   }
 
+  /**
+   * Fetches a page on behalf of a large scan. On a miss the page is read into a frame from the strategy's ring
+   * instead of a frame taken from the shared pool, whenever the ring has a reusable one.
+   * @param page_id id of page to be fetched
+   * @param strategy the access strategy of the scan, nullptr behaves like FetchPage
+   * @return the requested page
+   */
+  Page *FetchPageWithStrategy(page_id_t page_id, BufferAccessStrategy *strategy) {
+    return FetchPageWithStrategyImpl(page_id, strategy);
+  }
+
+  /**
+   * Fetches a page and read-latches it.
+   * @param page_id id of page to be fetched
+   * @param strategy the access strategy of a scan, nullptr to read through the shared pool
+   * @return a guard that holds the pin and the latch, invalid if the page could not be fetched
+   */
+  ReadPageGuard FetchPageRead(page_id_t page_id, BufferAccessStrategy *strategy = nullptr);
+
+  /**
+   * Fetches a page and write-latches it.
+   * @param page_id id of page to be fetched
+   * @return a guard that holds the pin and the latch, invalid if the page could not be fetched
+   */
+  WritePageGuard FetchPageWrite(page_id_t page_id);
+
+  /**
+   * Fetches several pages at once. The pool latch is taken once for the whole batch, and the pages that miss are read
+   * after it is released, in page id order. Every page that is returned is pinned once per occurrence in page_ids and
+   * must be unpinned, e.g. with UnpinPages.
+   * @param page_ids ids of the pages to fetch
+   * @param[out] pages the requested pages, in the order of page_ids; nullptr where no frame could be found
+   */
+  void FetchPages(const std::vector<page_id_t> &page_ids, std::vector<Page *> *pages) {
+    FetchPagesImpl(page_ids, pages);
+  }
+
   /** Grading function. Do not modify! */
   bool UnpinPage(page_id_t page_id, bool is_dirty, bufferpool_callback_fn callback = nullptr) {
     GradingCallback(callback, CallbackType::BEFORE, page_id);
@@ -60,6 +134,14 @@ class BufferPoolManager {
     return result;
   }
 
+  /**
+   * Unpins several pages at once, taking the pool latch once for the whole batch.
+   * @param page_ids ids of the pages to unpin
+   * @param is_dirty true if the pages should be marked as dirty, false otherwise
+   * @return false if any of the pages was not pinned, true otherwise
+   */
+  bool UnpinPages(const std::vector<page_id_t> &page_ids, bool is_dirty) { return UnpinPagesImpl(page_ids, is_dirty); }
+
   /** Grading function. Do not modify! */
   bool FlushPage(page_id_t page_id, bufferpool_callback_fn callback = nullptr) {
     GradingCallback(callback, CallbackType::BEFORE, page_id);
@@ -76,6 +158,14 @@ class BufferPoolManager {
     return result;
   }
 
+  /**
+   * Creates a new page in a given file of the disk manager, see DiskManager::CreateSegment.
+   * @param file_id the file to allocate the page in
+   * @param[out] page_id id of created page
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  Page *NewPageInFile(file_id_t file_id, page_id_t *page_id) { return NewPageInFileImpl(file_id, page_id); }
+
   /** Grading function. Do not modify! */
   bool DeletePage(page_id_t page_id, bufferpool_callback_fn callback = nullptr) {
     GradingCallback(callback, CallbackType::BEFORE, page_id);
@@ -95,7 +185,76 @@ class BufferPoolManager {
   Page *GetPages() { return pages_; }
 
   /** @return size of the buffer pool */
-  size_t GetPoolSize() { return pool_size_; }
+  virtual size_t GetPoolSize() { return pool_size_; }
+
+  /** @return size of the pages in the buffer pool, which is the page size of its disk manager */
+  size_t GetPageSize() const { return page_size_; }
+
+  /**
+   * Asks the background I/O thread to read a page into the buffer pool. The page is left unpinned. This is only a
+   * hint: it is dropped if the prefetch queue is full or no frame can be freed.
+   * @param page_id id of the page to read ahead
+   */
+  void PrefetchPage(page_id_t page_id) { PrefetchRange(page_id, 1); }
+
+  /**
+   * Asks the background I/O thread to read up to count pages into the buffer pool, starting at page_id. Without
+   * next_page the pages are page_id, page_id + 1, ...; with it, the chain of pages it describes is followed instead.
+   * The chain stops early at a page that is currently pinned, since its next pointer may be changing.
+   * @param page_id id of the first page to read ahead
+   * @param count number of pages to read ahead
+   * @param next_page extracts the id of the following page from a page, nullptr for consecutive page ids
+   */
+  void PrefetchRange(page_id_t page_id, size_t count, next_page_fn next_page = nullptr);
+
+  /**
+   * Writes the ids of the pages resident in the buffer pool to a file, coldest first, so that LoadResidentPages can
+   * bring the same pages back after a restart. The file is written under a temporary name and then renamed, so a
+   * crash in the middle leaves the previous dump intact.
+   * @param file_name the dump file
+   * @return false if the file could not be written
+   */
+  bool DumpResidentPages(const std::string &file_name);
+
+  /**
+   * Reads the pages listed in a dump back into the buffer pool, unpinned. Meant to be called at startup, before the
+   * pool is used: pages only go into free frames, they are read in page id order so that the disk sees sequential
+   * reads, and they are then handed to the replacer in their dumped order, so the hottest pages are evicted last.
+   * @param file_name the dump file
+   * @return the number of pages loaded; 0 if the file does not exist or is not a dump
+   */
+  size_t LoadResidentPages(const std::string &file_name);
+
+  /**
+   * Starts a background thread that calls DumpResidentPages every interval, so that a crash does not lose the
+   * resident set. The thread is stopped when the buffer pool is destroyed.
+   * @param file_name the dump file
+   * @param interval time between two dumps
+   */
+  void StartResidentPageDumps(const std::string &file_name, std::chrono::milliseconds interval);
+
+  /**
+   * Sums the event counters of the buffer pool. Counting is lock-free, so this is cheap enough to poll, but a
+   * snapshot taken under load is not atomic across counters.
+   * @return the counters since the buffer pool was created
+   */
+  virtual BufferPoolStats GetStats() { return metrics_.Snapshot(); }
+
+  /**
+   * Reports the state of every frame, e.g. to find the pages whose pins leak.
+   * @return one entry per frame, in frame order
+   */
+  std::vector<FrameState> GetFrameStates() {
+    std::vector<FrameState> frames;
+    GetFrameStatesImpl(&frames);
+    return frames;
+  }
+
+  /**
+   * Writes GetFrameStates as a table, one frame per line, skipping free frames.
+   * @param os the stream to write to
+   */
+  void DumpFrameStates(std::ostream &os);
 
  protected:
   /**
@@ -116,7 +275,22 @@ class BufferPoolManager {
    * @param page_id id of page to be fetched
    * @return the requested page
    */
-  Page *FetchPageImpl(page_id_t page_id);
+  virtual Page *FetchPageImpl(page_id_t page_id);
+
+  /**
+   * Fetch the requested page from the buffer pool, recycling the frames of the given ring on a miss.
+   * @param page_id id of page to be fetched
+   * @param strategy the access strategy of the caller, may be nullptr
+   * @return the requested page
+   */
+  virtual Page *FetchPageWithStrategyImpl(page_id_t page_id, BufferAccessStrategy *strategy);
+
+  /**
+   * Fetch several pages from the buffer pool under a single acquisition of the pool latch.
+   * @param page_ids ids of the pages to be fetched
+   * @param[out] pages the requested pages, in the order of page_ids
+   */
+  virtual void FetchPagesImpl(const std::vector<page_id_t> &page_ids, std::vector<Page *> *pages);
 
   /**
    * Unpin the target page from the buffer pool.
@@ -124,38 +298,226 @@ class BufferPoolManager {
    * @param is_dirty true if the page should be marked as dirty, false otherwise
    * @return false if the page pin count is <= 0 before this call, true otherwise
    */
-  bool UnpinPageImpl(page_id_t page_id, bool is_dirty);
+  virtual bool UnpinPageImpl(page_id_t page_id, bool is_dirty);
+
+  /**
+   * Unpin several pages under a single acquisition of the pool latch.
+   * @param page_ids ids of the pages to be unpinned
+   * @param is_dirty true if the pages should be marked as dirty, false otherwise
+   * @return false if any of the pages was not pinned, true otherwise
+   */
+  virtual bool UnpinPagesImpl(const std::vector<page_id_t> &page_ids, bool is_dirty);
 
   /**
    * Flushes the target page to disk.
    * @param page_id id of page to be flushed, cannot be INVALID_PAGE_ID
    * @return false if the page could not be found in the page table, true otherwise
    */
-  bool FlushPageImpl(page_id_t page_id);
+  virtual bool FlushPageImpl(page_id_t page_id);
 
   /**
    * Creates a new page in the buffer pool.
    * @param[out] page_id id of created page
    * @return nullptr if no new pages could be created, otherwise pointer to new page
    */
-  Page *NewPageImpl(page_id_t *page_id);
+  virtual Page *NewPageImpl(page_id_t *page_id);
+
+  /**
+   * Creates a new page in the buffer pool, allocated in a given file.
+   * @param file_id the file to allocate the page in
+   * @param[out] page_id id of created page
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  virtual Page *NewPageInFileImpl(file_id_t file_id, page_id_t *page_id);
 
   /**
    * Deletes a page from the buffer pool.
    * @param page_id id of page to be deleted
    * @return false if the page exists but could not be deleted, true if the page didn't exist or deletion succeeded
    */
-  bool DeletePageImpl(page_id_t page_id);
+  virtual bool DeletePageImpl(page_id_t page_id);
+
+  /**
+   * Flushes all the dirty pages in the buffer pool to disk, as one durable batch (see DiskManager::WritePages). The
+   * pages are copied under their page latches and written without latch_ held; until their copies are on disk they
+   * are in writing_back_.
+   * @throws Exception if there is no memory for the copies
+   */
+  virtual void FlushAllPagesImpl();
+
+  /**
+   * Reads a page into the buffer pool without pinning it, on behalf of the prefetcher.
+   * @param page_id id of the page to read
+   * @param next_page extracts the id of the following page, nullptr for consecutive page ids
+   * @return the id of the page to read next, INVALID_PAGE_ID to stop read-ahead
+   */
+  virtual page_id_t PrefetchPageImpl(page_id_t page_id, next_page_fn next_page);
 
   /**
-   * Flushes all the pages in the buffer pool to disk.
+   * Reads pages into the buffer pool without pinning them, on behalf of the prefetcher. The reads are all in flight at
+   * once. Stops at the first page that no frame can be freed for.
+   * @param page_ids ids of the pages to read
    */
-  void FlushAllPagesImpl();
+  virtual void PrefetchPagesImpl(const std::vector<page_id_t> &page_ids);
+
+  /** Stops the prefetch thread and drops outstanding requests. Subclasses call it before tearing down. */
+  void StopPrefetcher();
+
+  /**
+   * Stops the prefetch thread and the background writer, the threads that use the disk manager on their own. Called
+   * by the destructor, or by the disk manager if it goes away first.
+   */
+  void StopBackgroundThreads();
+
+  /**
+   * Lists the resident pages, coldest first: the victims in the order the replacer would evict them, then the pinned
+   * pages.
+   * @param[out] page_ids the resident pages
+   */
+  virtual void ListResidentPagesImpl(std::vector<page_id_t> *page_ids);
+
+  /**
+   * Reads pages into free frames, in page id order, and then makes them evictable in the given order.
+   * @param page_ids the pages to load, coldest first
+   * @return the number of pages loaded
+   */
+  virtual size_t LoadResidentPagesImpl(const std::vector<page_id_t> &page_ids);
+
+  /**
+   * Appends the state of every frame to frames. Takes the pool latch, so the states are consistent with each other.
+   * @param[out] frames the frame states
+   */
+  virtual void GetFrameStatesImpl(std::vector<FrameState> *frames);
+
+  /** Stops the resident page dump thread. Subclasses call it before tearing down. */
+  void StopResidentPageDumps();
+
+  /**
+   * Creates a new page in the buffer pool for a page id that the caller has already allocated.
+   * @param page_id id of the page to create
+   * @return nullptr if no frame could be found for the page or a stale copy of it is still pinned, otherwise pointer to
+   * new page
+   */
+  Page *NewPageWithId(page_id_t page_id);
+
+  /**
+   * Unpins a page. Caller must hold latch_, in shared mode at least.
+   * @param page_id id of page to be unpinned
+   * @param is_dirty true if the page should be marked as dirty
+   * @return false if the page is not resident or not pinned, true otherwise
+   */
+  bool UnpinPageLocked(page_id_t page_id, bool is_dirty);
+
+  /**
+   * Finds a frame to hold a page, writing back the evicted page if it is dirty. Caller must hold latch_.
+   * @param[out] frame_id id of the frame that can be reused
+   * @param[out] write_back_page_id if not nullptr, see EvictFrame
+   * @return false if every frame is pinned, true otherwise
+   */
+  bool FindFreeFrame(frame_id_t *frame_id, page_id_t *write_back_page_id = nullptr);
+
+  /**
+   * Takes back the frame of the page in the strategy's current ring slot, if it is still resident and unpinned.
+   * Caller must hold latch_.
+   * @param strategy the access strategy of the caller
+   * @param[out] frame_id id of the recycled frame
+   * @param[out] write_back_page_id if not nullptr, see EvictFrame
+   * @return true if a frame was recycled, false if the caller should fall back to FindFreeFrame
+   */
+  bool FindRingFrame(BufferAccessStrategy *strategy, frame_id_t *frame_id, page_id_t *write_back_page_id = nullptr);
+
+  /**
+   * Evicts the page held by an unpinned frame, writing it back if it is dirty. Caller must hold latch_.
+   * @param frame_id id of the frame to evict
+   * @param[out] write_back_page_id if not nullptr, a dirty page is not written here: its id is stored in
+   * write_back_page_id and recorded in writing_back_, and the caller writes the frame back after releasing latch_ and
+   * then calls FinishWriteBack.
+   * Otherwise it is set to INVALID_PAGE_ID.
+   */
+  void EvictFrame(frame_id_t frame_id, page_id_t *write_back_page_id = nullptr);
+
+  /** Blocks until no I/O is in progress on the page. The caller must have it pinned, or expect it to be reused. */
+  void WaitForIO(Page *page);
+
+  /**
+   * Blocks until a page is no longer being written back, see writing_back_.
+   * @param latch the caller's hold on latch_, which is released while waiting
+   * @param page_id id of the page
+   */
+  void WaitForWriteBack(std::unique_lock<std::shared_mutex> *latch, page_id_t page_id);
+
+  /** Takes a page out of writing_back_ and wakes up whoever waits for it. Caller must hold latch_. */
+  void FinishWriteBack(page_id_t page_id);
+
+  /**
+   * Reads a page from the disk manager into its frame, counting the read and its latency. The page is aliased to the
+   * mapping instead if the disk manager serves it without a copy (see MapPage).
+   */
+  void ReadPageFromDisk(Page *page);
+
+  /** Writes a page through the disk manager, counting the write and its latency. */
+  void WritePageToDisk(page_id_t page_id, const char *page_data);
+
+  /**
+   * Reads pages through the disk manager with all the reads in flight at once, counting the reads and their latency.
+   * @param pages the pages to read, each into its own frame or aliased to the mapping like in ReadPageFromDisk
+   */
+  void ReadPagesFromDisk(const std::vector<Page *> &pages);
+
+  /**
+   * Points a page that is being read in at the disk manager's mapped copy of it, if there is one, and otherwise back
+   * at its own frame.
+   * @return true iff the page now aliases the mapping and needs no read
+   */
+  bool MapPage(Page *page);
+
+  /**
+   * Writes pages through the disk manager with all the writes in flight at once, counting the writes and their latency.
+   * @param pages the id of each page and its data
+   */
+  void WritePagesToDisk(const std::vector<std::pair<page_id_t, const char *>> &pages);
+
+  /** Marks the I/O on the page as complete and wakes up everyone waiting for it. */
+  void FinishIO(Page *page);
+
+  /**
+   * Adopts a prefetched page into the ring of a scan that just hit it: the page in the current ring slot, if it is
+   * unpinned, goes back to the free list so that the prefetcher can reuse its frame. Caller must hold latch_.
+   * @param strategy the access strategy of the scan
+   * @param page_id id of the prefetched page
+   */
+  void AdoptIntoRing(BufferAccessStrategy *strategy, page_id_t page_id);
+
+  /**
+   * Installs a freshly created page into the given frame, with I/O in progress until FinishNewPage. Caller must hold
+   * latch_.
+   * @param frame_id id of the frame obtained from FindFreeFrame
+   * @param page_id id of the new page
+   * @return nullptr if a stale copy of the page is still pinned, leaving the frame to the caller, otherwise pointer to
+   * the new page
+   */
+  Page *InitNewPage(frame_id_t frame_id, page_id_t page_id);
+
+  /**
+   * Releases latch_, writes back the page the frame of a new page held, and zeroes the new page both in memory and on
+   * disk.
+   * @param latch the caller's hold on latch_, unlocked on return
+   * @param page the page returned by InitNewPage
+   * @param write_back_page_id the page to write back, as returned by FindFreeFrame
+   */
+  void FinishNewPage(std::unique_lock<std::shared_mutex> *latch, Page *page, page_id_t write_back_page_id);
+
+  /** @return the memory frame frame_id holds its page in, when the page is not mapped from the file */
+  char *GetFrame(frame_id_t frame_id) { return frames_->GetFrame(frame_id); }
 
   /** Number of pages in the buffer pool. */
   size_t pool_size_;
+  /** Size of each page, in bytes. */
+  size_t page_size_;
   /** Array of buffer pool pages. */
   Page *pages_;
+  /** The memory the pages hold their data in: pool_size_ aligned frames of page_size_ bytes each. */
+  FrameArena *frames_{nullptr};
   /** Pointer to the disk manager. */
   DiskManager *disk_manager_ __attribute__((__unused__));
   /** Pointer to the log manager. */
@@ -166,7 +528,79 @@ class BufferPoolManager {
   Replacer *replacer_;
   /** List of free pages. */
   std::list<frame_id_t> free_list_;
-  /** This latch protects frame_id_t in free_list, replacer and pages*/
-  std::mutex latch_;
+  /**
+   * This latch protects frame_id_t in free_list, replacer and pages. Lookups that only pin or unpin a resident page
+   * (cache hits, UnpinPage) take it shared; anything that changes the page table or evicts a frame takes it
+   * exclusively, so a frame can never be evicted while a shared holder is pinning it.
+   */
+  std::shared_mutex latch_;
+  /**
+   * Pages that are being written back outside latch_: dirty pages evicted from a frame, and pages the background
+   * writer is cleaning. Reading one of them from disk in the meantime would return stale data, and writing a newer
+   * image could be overtaken by the older one, so both wait until the page has left the set.
+   */
+  std::unordered_set<page_id_t> writing_back_;
+  /** Signalled whenever a page leaves writing_back_. */
+  std::condition_variable_any write_back_cv_;
+  /** Event counters: hits, misses, evictions, disk I/O. */
+  BufferPoolMetrics metrics_;
+
+ private:
+  /** A pending read-ahead request. */
+  struct PrefetchRequest {
+    page_id_t page_id_;
+    size_t count_;
+    next_page_fn next_page_;
+  };
+  /** Read-ahead is a hint, so requests beyond this many are dropped rather than queued. */
+  static constexpr size_t MAX_PREFETCH_REQUESTS = 64;
+
+  /** Body of the prefetch thread. */
+  void PrefetchLoop();
+
+  /** Protects the prefetch queue and the prefetch thread. */
+  std::mutex prefetch_latch_;
+  std::condition_variable prefetch_cv_;
+  std::deque<PrefetchRequest> prefetch_queue_;
+  /** Started on the first prefetch request. */
+  std::thread prefetch_thread_;
+  bool prefetch_stop_{false};
+
+  /** Body of the background writer thread. */
+  void BackgroundWriterLoop();
+
+  /**
+   * Writes back the dirty pages among the next victims of the replacer if the pool is below the low watermark, so
+   * that misses find clean frames and do not have to write back themselves.
+   */
+  void CleanVictims();
+
+  /** Tells the background writer that a fetch had to write back a dirty victim. Caller must hold latch_. */
+  void WakeBackgroundWriter();
+
+  /** Protects the background writer state. */
+  std::mutex bg_writer_latch_;
+  std::condition_variable bg_writer_cv_;
+  /** Started by the constructor if bg_writer_low_watermark is set. */
+  std::thread bg_writer_thread_;
+  bool bg_writer_stop_{false};
+  bool bg_writer_wakeup_{false};
+
+  /** Our handle as a background user of the disk manager, valid while is_background_user_ is set. */
+  size_t background_user_{0};
+  std::atomic<bool> is_background_user_{false};
+
+  /** Writes the dump for DumpResidentPages. Caller must hold dump_latch_, which keeps dumps from racing. */
+  bool WriteResidentPages(const std::string &file_name);
+
+  /** Body of the resident page dump thread. */
+  void ResidentPageDumpLoop(std::string file_name, std::chrono::milliseconds interval);
+
+  /** Protects the resident page dump thread and the dump file. */
+  std::mutex dump_latch_;
+  std::condition_variable dump_cv_;
+  /** Started by StartResidentPageDumps. */
+  std::thread dump_thread_;
+  bool dump_stop_{false};
 };
 }  // namespace bustub
@@ -0,0 +1,113 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_metrics.h
+//
+// Identification: src/include/buffer/buffer_pool_metrics.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/** A point-in-time copy of the counters of a buffer pool. */
+struct BufferPoolStats {
+  /** Fetches that found the page resident. */
+  uint64_t hits_{0};
+  /** Fetches that had to read the page from disk. */
+  uint64_t misses_{0};
+  /** Pages evicted to make room for another page. */
+  uint64_t evictions_{0};
+  /** Evicted pages that had to be written back first. */
+  uint64_t dirty_evictions_{0};
+  /** Pages written by FlushPage and FlushAllPages. */
+  uint64_t flushes_{0};
+  /** Page reads and writes issued to the disk manager, and the total time they took. */
+  uint64_t reads_{0};
+  uint64_t read_nanos_{0};
+  uint64_t writes_{0};
+  uint64_t write_nanos_{0};
+  /** Fetches that found their page resident but still being read in, and the total time they waited for it. */
+  uint64_t io_waits_{0};
+  uint64_t io_wait_nanos_{0};
+
+  /** @return hits / (hits + misses), 0 if nothing was fetched */
+  double HitRatio() const;
+
+  /** @return the mean time of a page read, in microseconds */
+  double AverageReadMicros() const;
+
+  /** @return the mean time of a page write, in microseconds */
+  double AverageWriteMicros() const;
+
+  /** Adds the counters of another snapshot to this one. */
+  BufferPoolStats &operator+=(const BufferPoolStats &other);
+
+  /** @return the counters as a single line of "name=value" pairs */
+  std::string ToString() const;
+};
+
+/**
+ * BufferPoolMetrics counts buffer pool events without locks on the hot path. Counters are striped: each thread bumps
+ * a relaxed atomic in its own cache-line-sized stripe, so threads on different stripes never contend, and Snapshot
+ * sums the stripes. A snapshot taken while threads are counting is not atomic across counters.
+ */
+class BufferPoolMetrics {
+ public:
+  enum Counter {
+    HITS,
+    MISSES,
+    EVICTIONS,
+    DIRTY_EVICTIONS,
+    FLUSHES,
+    READS,
+    READ_NANOS,
+    WRITES,
+    WRITE_NANOS,
+    IO_WAITS,
+    IO_WAIT_NANOS,
+    NUM_COUNTERS
+  };
+
+  BufferPoolMetrics() = default;
+
+  DISALLOW_COPY_AND_MOVE(BufferPoolMetrics);
+
+  /**
+   * Adds to a counter.
+   * @param counter the counter
+   * @param delta the amount to add
+   */
+  void Add(Counter counter, uint64_t delta = 1) {
+    stripes_[StripeOfThisThread()].counters_[counter].fetch_add(delta, std::memory_order_relaxed);
+  }
+
+  /** @return the sum of every stripe */
+  BufferPoolStats Snapshot() const;
+
+ private:
+  static constexpr size_t NUM_STRIPES = 16;
+
+  struct alignas(64) Stripe {
+    std::array<std::atomic<uint64_t>, NUM_COUNTERS> counters_{};
+  };
+
+  /** Threads are assigned stripes round-robin, the first time they count anything. */
+  static size_t StripeOfThisThread();
+
+  std::array<Stripe, NUM_STRIPES> stripes_;
+};
+
+}  // namespace bustub
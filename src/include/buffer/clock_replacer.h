@@ -12,8 +12,9 @@
 
 #pragma once
 
-#include <list>
-#include <mutex>  // NOLINT
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <vector>
 
 #include "buffer/replacer.h"
@@ -23,8 +24,16 @@ namespace bustub {
 
 /**
  * ClockReplacer implements the clock replacement policy, which approximates the Least Recently Used policy.
+ *
+ * Every frame has an atomic state byte, which says whether the frame is in the replacer and holds its reference bit.
+ * Pin and Unpin are a single atomic read-modify-write on that byte (plus a size update when membership changes), and
+ * nothing is allocated or locked. Victim sweeps an atomic clock hand over the frames: a frame whose reference bit is
+ * set has the bit cleared and gets a second chance, the first one without it is evicted.
  */
 class ClockReplacer : public Replacer {
+  static constexpr uint8_t IN_REPLACER = 1;
+  static constexpr uint8_t REFERENCED = 2;
+
  public:
   /**
    * Create a new ClockReplacer.
@@ -43,10 +52,16 @@ class ClockReplacer : public Replacer {
 
   void Unpin(frame_id_t frame_id) override;
 
+  /** Lists the frames without a reference bit in clock order from the hand, then those with one, in the same order. */
+  void PeekVictims(size_t count, std::vector<frame_id_t> *frame_ids) override;
+
   size_t Size() override;
 
  private:
-  // TODO(student): implement me!
+  size_t num_frames_;
+  std::unique_ptr<std::atomic<uint8_t>[]> states_;
+  std::atomic<size_t> hand_{0};
+  std::atomic<size_t> size_{0};
 };
 
 }  // namespace bustub
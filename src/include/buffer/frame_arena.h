@@ -0,0 +1,61 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena.h
+//
+// Identification: src/include/buffer/frame_arena.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * FrameArena is the memory a buffer pool keeps its page data in: one contiguous, zero-filled region of num_frames
+ * frames of frame_size bytes each. The region is mapped directly from the kernel, so every frame is aligned to its
+ * size (which suits O_DIRECT), and the page descriptors live elsewhere.
+ *
+ * Large arenas are backed by huge pages to cut TLB misses. The arena first asks for explicit huge pages
+ * (MAP_HUGETLB), which only succeeds if the administrator has reserved them; otherwise it maps ordinary pages aligned
+ * to the huge page size and asks for transparent huge pages (MADV_HUGEPAGE), which the kernel may or may not grant.
+ */
+class FrameArena {
+ public:
+  /** Huge page size the arena aligns to and rounds up to. */
+  static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+  /**
+   * Maps a new arena.
+   * @param num_frames number of frames
+   * @param frame_size size of each frame, a power of two no larger than HUGE_PAGE_SIZE
+   * @throws Exception if the memory cannot be mapped
+   */
+  FrameArena(size_t num_frames, size_t frame_size);
+
+  ~FrameArena();
+
+  DISALLOW_COPY_AND_MOVE(FrameArena);
+
+  /** @return the data of frame frame_id */
+  char *GetFrame(size_t frame_id) const { return data_ + frame_id * frame_size_; }
+
+  /** @return true if the arena is backed by explicitly reserved huge pages */
+  bool IsHugeTlb() const { return huge_tlb_; }
+
+ private:
+  size_t frame_size_;
+  /** Size of the mapping, a multiple of HUGE_PAGE_SIZE for large arenas. */
+  size_t mapped_size_{0};
+  char *data_{nullptr};
+  bool huge_tlb_{false};
+};
+
+}  // namespace bustub
@@ -0,0 +1,112 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer.h
+//
+// Identification: src/include/buffer/lru_k_replacer.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <mutex>  // NOLINT
+#include <set>
+#include <tuple>
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * LRUKReplacer implements the LRU-K replacement policy.
+ *
+ * The victim is the evictable frame whose backward k-distance, i.e. the time since its k-th most recent access, is
+ * the largest. Frames with fewer than k recorded accesses have an infinite backward k-distance; among those, the one
+ * whose oldest recorded access is earliest goes first. A single sequential scan therefore only touches frames that
+ * were referenced once, and cannot push out pages that have been referenced k times.
+ *
+ * Correlated references are collapsed into one: an access that comes within correlated_period ticks of the previous
+ * access to the same frame only refreshes the most recent timestamp instead of adding a new entry to the history.
+ * Whether the frame is pinned does not matter, so a hot page that some thread always has pinned still collects k
+ * uncorrelated references.
+ *
+ * RecordAccess does not take the latch; it only stamps the frame, and the stamp is folded into the history the next
+ * time the frame is pinned, unpinned or considered for eviction.
+ */
+class LRUKReplacer : public Replacer {
+  struct FrameHistory {
+    /** Timestamps of the last (at most) k uncorrelated accesses, oldest first. Protected by latch_. */
+    std::deque<uint64_t> accesses_;
+    /** The timestamp of the most recent access, recorded without the latch. Zero if never accessed. */
+    std::atomic<uint64_t> last_access_{0};
+    /** The value of last_access_ that was last folded into accesses_. */
+    uint64_t folded_access_{0};
+    std::atomic<bool> evictable_{false};
+    /** The frame's position in victims_, valid while it is evictable. */
+    std::set<std::tuple<bool, uint64_t, frame_id_t>>::iterator position_;
+  };
+
+ public:
+  /**
+   * Create a new LRUKReplacer.
+   * @param num_pages the maximum number of pages the LRUKReplacer will be required to store
+   * @param k the number of past accesses considered when picking a victim
+   * @param correlated_period accesses closer than this many ticks to the previous one are treated as correlated
+   */
+  explicit LRUKReplacer(size_t num_pages, size_t k = LRUK_REPLACER_K,
+                        uint64_t correlated_period = LRUK_CORRELATED_PERIOD);
+
+  /**
+   * Destroys the LRUKReplacer.
+   */
+  ~LRUKReplacer() override = default;
+
+  bool Victim(frame_id_t *frame_id) override;
+
+  void Pin(frame_id_t frame_id) override;
+
+  void Unpin(frame_id_t frame_id) override;
+
+  void RecordAccess(frame_id_t frame_id) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  void PeekVictims(size_t count, std::vector<frame_id_t> *frame_ids) override;
+
+  size_t Size() override;
+
+ private:
+  /**
+   * Folds the access recorded in last_access_ into the history: appended if it is uncorrelated, otherwise it only
+   * refreshes the most recent timestamp.
+   */
+  void Fold(FrameHistory *history);
+
+  /** Makes the frame evictable and files it under its current backward k-distance. */
+  void Enqueue(frame_id_t frame_id);
+
+  /** Forgets the frame's history. */
+  void Reset(FrameHistory *history);
+
+  size_t k_;
+  uint64_t correlated_period_;
+  /** Logical clock, advanced on every recorded access. */
+  std::atomic<uint64_t> current_timestamp_{0};
+  std::vector<FrameHistory> histories_;
+  /**
+   * The evictable frames, next victim first: frames with an infinite backward k-distance, then the rest, each ordered
+   * by the front of their history. A frame accessed while evictable is filed under a stale position until the access
+   * is folded in; that only ever moves it back, so Victim re-files such frames as it meets them.
+   */
+  std::set<std::tuple<bool, uint64_t, frame_id_t>> victims_;
+  std::mutex latch_;
+};
+
+}  // namespace bustub
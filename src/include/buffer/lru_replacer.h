@@ -51,6 +51,8 @@ class LRUReplacer : public Replacer {
 
   void Unpin(frame_id_t frame_id) override;
 
+  void PeekVictims(size_t count, std::vector<frame_id_t> *frame_ids) override;
+
   size_t Size() override;
 
  private:
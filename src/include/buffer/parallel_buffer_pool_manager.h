@@ -0,0 +1,116 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_buffer_pool_manager.h
+//
+// Identification: src/include/buffer/parallel_buffer_pool_manager.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "recovery/log_manager.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/page/page.h"
+
+namespace bustub {
+
+/**
+ * ParallelBufferPoolManager shards the buffer pool into several independent BufferPoolManager instances, each with
+ * its own frames, page table, free list, replacer and latch. A page always lives in instance (page_id % N), so
+ * threads working on different pages rarely contend on the same latch.
+ */
+class ParallelBufferPoolManager : public BufferPoolManager {
+ public:
+  /**
+   * Creates a new ParallelBufferPoolManager.
+   * @param num_instances the number of buffer pool instances
+   * @param pool_size the size of each buffer pool instance
+   * @param disk_manager the disk manager
+   * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_type the replacement policy used by every instance
+   */
+  ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
+                            LogManager *log_manager = nullptr, ReplacerType replacer_type = ReplacerType::LRU);
+
+  /**
+   * Destroys an existing ParallelBufferPoolManager and all of its instances.
+   */
+  ~ParallelBufferPoolManager() override;
+
+  /** @return the total size of all the buffer pool instances */
+  size_t GetPoolSize() override { return instances_.size() * instance_pool_size_; }
+
+  /** @return the counters of all instances, summed */
+  BufferPoolStats GetStats() override;
+
+  /** @return the number of buffer pool instances */
+  size_t GetNumInstances() { return instances_.size(); }
+
+ protected:
+  /**
+   * @param page_id id of the page
+   * @return the buffer pool instance responsible for page_id
+   */
+  BufferPoolManager *GetBufferPoolManager(page_id_t page_id);
+
+  Page *FetchPageImpl(page_id_t page_id) override;
+
+  /**
+   * Routes the fetch to the instance that owns page_id. A ring slot is only recycled when the page in it belongs to
+   * the same instance; otherwise that instance allocates a frame as usual.
+   */
+  Page *FetchPageWithStrategyImpl(page_id_t page_id, BufferAccessStrategy *strategy) override;
+
+  /** Splits the batch by instance; each instance takes its own latch once for its share of the pages. */
+  void FetchPagesImpl(const std::vector<page_id_t> &page_ids, std::vector<Page *> *pages) override;
+
+  bool UnpinPageImpl(page_id_t page_id, bool is_dirty) override;
+
+  bool UnpinPagesImpl(const std::vector<page_id_t> &page_ids, bool is_dirty) override;
+
+  bool FlushPageImpl(page_id_t page_id) override;
+
+  /**
+   * Creates a new page in the instance that owns the newly allocated page id. If that instance is full, a fresh id
+   * (and therefore the next instance) is tried, so every instance is attempted at most once.
+   * @param file_id the file to allocate the page in
+   * @param[out] page_id id of created page
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  Page *NewPageInFileImpl(file_id_t file_id, page_id_t *page_id) override;
+
+  bool DeletePageImpl(page_id_t page_id) override;
+
+  void FlushAllPagesImpl() override;
+
+  /** Reads the page into the instance that owns it. A single prefetcher thread serves all instances. */
+  page_id_t PrefetchPageImpl(page_id_t page_id, next_page_fn next_page) override;
+
+  /** Hands each instance the pages it owns, so that each instance reads its share all at once. */
+  void PrefetchPagesImpl(const std::vector<page_id_t> &page_ids) override;
+
+  /** Lists the resident pages of each instance in turn; each instance evicts on its own, so order is per instance. */
+  void ListResidentPagesImpl(std::vector<page_id_t> *page_ids) override;
+
+  /** Hands each instance the pages it owns, in their original order. */
+  size_t LoadResidentPagesImpl(const std::vector<page_id_t> &page_ids) override;
+
+  /** Lists the frames of each instance in turn; frame ids are numbered across instances. */
+  void GetFrameStatesImpl(std::vector<FrameState> *frames) override;
+
+ private:
+  /** Number of pages in each buffer pool instance. */
+  size_t instance_pool_size_;
+  /** The buffer pool instances, indexed by page_id % num_instances. */
+  std::vector<BufferPoolManager *> instances_;
+};
+
+}  // namespace bustub
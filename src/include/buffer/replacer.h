@@ -12,10 +12,15 @@
 
 #pragma once
 
+#include <vector>
+
 #include "common/config.h"
 
 namespace bustub {
 
+/** The replacement policies that a BufferPoolManager can be constructed with. */
+enum class ReplacerType { LRU, LRU_K, CLOCK, ARC };
+
 /**
  * Replacer is an abstract class that tracks page usage.
  */
@@ -43,6 +48,36 @@ class Replacer {
    */
   virtual void Unpin(frame_id_t frame_id) = 0;
 
+  /**
+   * Records that the page held by a frame was accessed. Policies that only care about unpin order can ignore it.
+   * @param frame_id the id of the accessed frame
+   */
+  virtual void RecordAccess(frame_id_t frame_id) {}
+
+  /**
+   * Records that a frame was accessed, and which page it holds. The buffer pool reports every access this way, so
+   * that policies that remember evicted pages (e.g. ARC's ghost lists) can recognize a page coming back. By default
+   * the page is ignored.
+   * @param frame_id the id of the accessed frame
+   * @param page_id the id of the page in the frame
+   */
+  virtual void RecordPageAccess(frame_id_t frame_id, page_id_t page_id) { RecordAccess(frame_id); }
+
+  /**
+   * Forgets a frame entirely, e.g. because its page was deleted. Policies that keep no state beyond the set of
+   * evictable frames can treat this as a pin.
+   * @param frame_id the id of the frame to remove
+   */
+  virtual void Remove(frame_id_t frame_id) { Pin(frame_id); }
+
+  /**
+   * Lists the frames that Victim would return next, in order, without removing them. Policies that cannot tell their
+   * victims in advance may list nothing.
+   * @param count the maximum number of frames to list
+   * @param[out] frame_ids the frames, next victim first
+   */
+  virtual void PeekVictims(size_t count, std::vector<frame_id_t> *frame_ids) {}
+
   /** @return the number of elements in the replacer that can be victimized */
   virtual size_t Size() = 0;
 };
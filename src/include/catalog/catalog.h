@@ -73,13 +73,15 @@ class Catalog {
    * @param txn the transaction in which the table is being created
    * @param table_name the name of the new table
    * @param schema the schema of the new table
+   * @param file_id the file of the disk manager to store the table in, see DiskManager::CreateSegment
    * @return a pointer to the metadata of the new table
    */
-  TableMetadata *CreateTable(Transaction *txn, const std::string &table_name, const Schema &schema) {
+  TableMetadata *CreateTable(Transaction *txn, const std::string &table_name, const Schema &schema,
+                             file_id_t file_id = DB_FILE_ID) {
     BUSTUB_ASSERT(names_.count(table_name) == 0, "Table names should be unique!");
     // Alloc a table
     table_oid_t table_oid = next_table_oid_++;
-    std::unique_ptr<TableHeap> table(new TableHeap(bpm_, lock_manager_, log_manager_, txn));
+    std::unique_ptr<TableHeap> table(new TableHeap(bpm_, lock_manager_, log_manager_, txn, file_id));
     // Generate metadata about that table, and track it
     TableMetadata *table_metadata = new TableMetadata(schema, table_name, std::move(table), table_oid);
     tables_[table_oid] = std::unique_ptr<TableMetadata>(table_metadata);
@@ -108,16 +110,17 @@ class Catalog {
    * @param key_schema the schema of the key
    * @param key_attrs key attributes
    * @param keysize size of the key
+   * @param file_id the file of the disk manager to store the index in, see DiskManager::CreateSegment
    * @return a pointer to the metadata of the new table
    */
   template <class KeyType, class ValueType, class KeyComparator>
   IndexInfo *CreateIndex(Transaction *txn, const std::string &index_name, const std::string &table_name,
                          const Schema &schema, const Schema &key_schema, const std::vector<uint32_t> &key_attrs,
-                         size_t keysize) {
+                         size_t keysize, file_id_t file_id = DB_FILE_ID) {
     // Allocate index
     index_oid_t index_oid = next_index_oid_++;
     IndexMetadata *index_metadata = new IndexMetadata(index_name, table_name, &schema, key_attrs);
-    std::unique_ptr<Index> index(new BPLUSTREE_INDEX_TYPE(index_metadata, bpm_));
+    std::unique_ptr<Index> index(new BPLUSTREE_INDEX_TYPE(index_metadata, bpm_, file_id));
 
     // Populate existing data of the table
     TableHeap *table = GetTable(table_name)->table_.get();
@@ -10,6 +10,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <string>
 
 #include "buffer/buffer_pool_manager.h"
@@ -18,21 +19,73 @@
 #include "recovery/checkpoint_manager.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
+#include "storage/disk/disk_manager_compressed.h"
+#include "storage/disk/disk_manager_mmap.h"
+#include "storage/disk/disk_manager_uring.h"
 
 namespace bustub {
 
+/** How a BustubInstance sizes its storage. */
+struct BustubConfig {
+  /** Memory for the buffer pool, in bytes. The pool holds as many pages as fit, and at least one. */
+  size_t buffer_pool_bytes_{static_cast<size_t>(BUFFER_POOL_SIZE) * PAGE_SIZE};
+  /** Page size of the database file: 4K, 8K or 16K. A file must always be opened with the same page size. */
+  size_t page_size_{PAGE_SIZE};
+  /** Read and write the database file with O_DIRECT, leaving caching to the buffer pool alone. */
+  bool direct_io_{false};
+  /** Do the buffer pool's batched page I/O through io_uring, where the kernel supports it. */
+  bool async_io_{false};
+  /** Serve the database file read-only out of a memory mapping, for read-only replicas. */
+  bool mmap_read_only_{false};
+  /** With mmap_read_only_, let the buffer pool use the mapped pages in place instead of copying them. */
+  bool mmap_zero_copy_{false};
+  /** Store pages LZ4-compressed, to save disk bandwidth on repetitive data. Overrides the I/O options above. */
+  bool compress_pages_{false};
+  /**
+   * Pick up an existing database file where it left off, instead of allocating pages from the start of it again.
+   * Read-only replicas always do.
+   */
+  bool reopen_{true};
+  /**
+   * Dump the resident page set to a .bpdump file next to the database file on shutdown (and every
+   * buffer_pool_dump_interval), and load those pages back into the buffer pool on startup if the file is reopened.
+   */
+  bool warm_restart_{false};
+};
+
 class BustubInstance {
  public:
-  explicit BustubInstance(const std::string &db_file_name) {
+  explicit BustubInstance(const std::string &db_file_name, const BustubConfig &config = BustubConfig()) {
     enable_logging = false;
 
     // storage related
-    disk_manager_ = new DiskManager(db_file_name);
+    if (config.compress_pages_) {
+      disk_manager_ = new DiskManagerCompressed(db_file_name, config.page_size_, config.reopen_);
+    } else if (config.mmap_read_only_) {
+      disk_manager_ = new DiskManagerMmap(db_file_name, config.page_size_, config.mmap_zero_copy_);
+    } else if (config.async_io_) {
+      disk_manager_ = new DiskManagerUring(db_file_name, config.page_size_, config.direct_io_, config.reopen_);
+    } else {
+      disk_manager_ = new DiskManager(db_file_name, config.page_size_, config.direct_io_, config.reopen_);
+    }
 
     // log related
     log_manager_ = new LogManager(disk_manager_);
 
-    buffer_pool_manager_ = new BufferPoolManager(BUFFER_POOL_SIZE, disk_manager_, log_manager_);
+    size_t pool_size = std::max<size_t>(config.buffer_pool_bytes_ / config.page_size_, 1);
+    buffer_pool_manager_ = new BufferPoolManager(pool_size, disk_manager_, log_manager_);
+
+    // warm restart: bring back the pages that were resident when we last shut down
+    if (config.warm_restart_) {
+      std::string::size_type n = db_file_name.rfind('.');
+      buffer_pool_dump_file_name_ = db_file_name.substr(0, n) + ".bpdump";
+      if (config.reopen_ || config.mmap_read_only_) {
+        buffer_pool_manager_->LoadResidentPages(buffer_pool_dump_file_name_);
+      }
+      if (buffer_pool_dump_interval.count() > 0) {
+        buffer_pool_manager_->StartResidentPageDumps(buffer_pool_dump_file_name_, buffer_pool_dump_interval);
+      }
+    }
 
     // txn related
     lock_manager_ = new LockManager();
@@ -46,6 +99,9 @@ class BustubInstance {
     if (enable_logging) {
       log_manager_->StopFlushThread();
     }
+    if (!buffer_pool_dump_file_name_.empty()) {
+      buffer_pool_manager_->DumpResidentPages(buffer_pool_dump_file_name_);
+    }
     delete checkpoint_manager_;
     delete log_manager_;
     delete buffer_pool_manager_;
@@ -60,6 +116,8 @@ class BustubInstance {
   TransactionManager *transaction_manager_;
   LogManager *log_manager_;
   CheckpointManager *checkpoint_manager_;
+  /** Where the resident page set of the buffer pool is dumped for the next restart; empty without warm_restart_. */
+  std::string buffer_pool_dump_file_name_;
 };
 
 }  // namespace bustub
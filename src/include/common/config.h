@@ -27,14 +27,60 @@ extern std::atomic<bool> enable_logging;
 /** If ENABLE_LOGGING is true, the log should be flushed to disk every LOG_TIMEOUT. */
 extern std::chrono::duration<int64_t> log_timeout;
 
+/**
+ * Number of pages that table and index scans read ahead of the page they are on, in the background; 0 disables
+ * read-ahead. Read-ahead only takes free frames or frames that are next in line for eviction.
+ */
+extern std::atomic<size_t> read_ahead_window;
+
+/**
+ * The background writer of a buffer pool starts writing back dirty victims when less than bg_writer_low_watermark of
+ * the frames are free or hold a clean page next in line for eviction; 0 disables the background writer.
+ */
+extern std::atomic<double> bg_writer_low_watermark;
+
+/** Once started, the background writer cleans victims until bg_writer_high_watermark of the frames are clean. */
+extern std::atomic<double> bg_writer_high_watermark;
+
+/** The background writer checks the watermarks every bg_writer_interval, or as soon as a fetch has to write back. */
+extern std::chrono::milliseconds bg_writer_interval;
+
+/** A BustubInstance with warm_restart_ dumps its resident pages every buffer_pool_dump_interval; 0 only on shutdown. */
+extern std::chrono::milliseconds buffer_pool_dump_interval;
+
+/** What a disk manager does with page checksums. */
+enum class ChecksumMode {
+  /** Neither computes nor verifies checksums; pages written in this mode have none. */
+  OFF,
+  /** Computes a checksum for every page written and verifies it on every read. Damaged pages are reported. */
+  VERIFY,
+  /** Like VERIFY, but damaged pages are also remembered until they are rewritten, see DiskManager::GetDamagedPages. */
+  REPAIR,
+};
+
+/** Checksum mode of all disk managers; it may be changed at any time. */
+extern std::atomic<ChecksumMode> page_checksum_mode;
+
 static constexpr int INVALID_PAGE_ID = -1;                                    // invalid page id
 static constexpr int INVALID_TXN_ID = -1;                                     // invalid transaction id
 static constexpr int INVALID_LSN = -1;                                        // invalid log sequence number
 static constexpr int HEADER_PAGE_ID = 0;                                      // the header page id
-static constexpr int PAGE_SIZE = 4096;                                        // size of a data page in byte
+static constexpr int PAGE_SIZE = 4096;                                        // default (and smallest) page size
+static constexpr int MAX_PAGE_SIZE = 16384;                                   // largest page size a db can use
 static constexpr int BUFFER_POOL_SIZE = 10;                                   // size of buffer pool
 static constexpr int LOG_BUFFER_SIZE = ((BUFFER_POOL_SIZE + 1) * PAGE_SIZE);  // size of a log buffer in byte
 static constexpr int BUCKET_SIZE = 50;                                        // size of extendible hash bucket
+static constexpr int SCAN_RING_SIZE = 16;                                     // frames in the private ring of a large scan
+static constexpr int SCAN_RING_THRESHOLD = 4;                                 // scans of tables over 1/4 of the pool use a ring
+static constexpr int FETCH_BATCH_FRACTION = 4;                                // batched fetches pin at most 1/4 of the pool at once
+static constexpr int LRUK_REPLACER_K = 2;                                     // lookback window for lru-k replacer
+static constexpr int LRUK_CORRELATED_PERIOD = 4;                              // lru-k re-accesses within this many ticks are correlated
+static constexpr int SEGMENT_PAGE_BIT = 30;                                   // page id bit set only in segment pages
+static constexpr int PAGE_NO_BITS = 24;                                       // page id bits that number segment pages
+static constexpr int DB_FILE_ID = 0;                                          // file id of the database file itself
+static constexpr int MAX_FILE_ID = 63;                                        // largest id a segment file can get
+static constexpr int MAX_DB_PAGE_NO = (1 << SEGMENT_PAGE_BIT) - 1;            // last page the database file can have
+static constexpr int MAX_SEGMENT_PAGE_NO = (1 << PAGE_NO_BITS) - 1;           // last page a segment file can have
 
 using frame_id_t = int32_t;    // frame id type
 using page_id_t = int32_t;     // page id type
@@ -42,5 +88,25 @@ using txn_id_t = int32_t;      // transaction id type
 using lsn_t = int32_t;         // log sequence number type
 using slot_offset_t = size_t;  // slot offset type
 using oid_t = uint16_t;
+using file_id_t = int32_t;     // file id type
+
+/**
+ * A page id names a page of a file. Pages of the database file itself keep their plain page numbers as ids, so the
+ * database file has all the ids below bit SEGMENT_PAGE_BIT to itself. The ids of segment pages have that bit set, the
+ * file id in the bits below it, and the page number within the segment in the low PAGE_NO_BITS bits.
+ */
+constexpr page_id_t MakePageId(file_id_t file_id, page_id_t page_no) {
+  return file_id == DB_FILE_ID ? page_no : (1 << SEGMENT_PAGE_BIT) | (file_id << PAGE_NO_BITS) | page_no;
+}
+
+/** @return the file that a page lives in; DB_FILE_ID for INVALID_PAGE_ID */
+constexpr file_id_t GetFileId(page_id_t page_id) {
+  return page_id < 0 || (page_id & (1 << SEGMENT_PAGE_BIT)) == 0 ? DB_FILE_ID : (page_id >> PAGE_NO_BITS) & MAX_FILE_ID;
+}
+
+/** @return the number of a page within its file */
+constexpr page_id_t GetPageNo(page_id_t page_id) {
+  return GetFileId(page_id) == DB_FILE_ID ? page_id : page_id & MAX_SEGMENT_PAGE_NO;
+}
 
 }  // namespace bustub
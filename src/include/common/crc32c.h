@@ -0,0 +1,35 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// crc32c.h
+//
+// Identification: src/include/common/crc32c.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace bustub {
+
+/**
+ * Computes the CRC32C (Castagnoli) checksum of a buffer. Uses the SSE4.2 crc32 instruction if the CPU has it, and a
+ * table-driven implementation otherwise.
+ * @param data the buffer
+ * @param size size of the buffer in bytes
+ * @return the checksum
+ */
+uint32_t Crc32c(const char *data, size_t size);
+
+/** Same as Crc32c, but always table-driven. */
+uint32_t Crc32cSoftware(const char *data, size_t size);
+
+/** @return true iff Crc32c uses the SSE4.2 crc32 instruction */
+bool Crc32cIsHardwareAccelerated();
+
+}  // namespace bustub
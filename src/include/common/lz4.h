@@ -0,0 +1,40 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lz4.h
+//
+// Identification: src/include/common/lz4.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+
+namespace bustub {
+
+/**
+ * Compresses a buffer into the LZ4 block format: a greedy, single-pass LZ77 with a hash table of recent 4-byte
+ * sequences. Fast on both ends, and good at the repetitive data that fills most table pages.
+ * @param src the buffer to compress
+ * @param size size of the buffer in bytes
+ * @param[out] dst output buffer
+ * @param capacity size of the output buffer in bytes
+ * @return size of the compressed data, or 0 if it does not fit in capacity bytes
+ */
+size_t Lz4Compress(const char *src, size_t size, char *dst, size_t capacity);
+
+/**
+ * Decompresses an LZ4 block. Malformed input is detected, never read or written out of bounds.
+ * @param src the compressed data
+ * @param size size of the compressed data in bytes
+ * @param[out] dst output buffer
+ * @param dst_size the exact size of the decompressed data
+ * @return true iff src is a well-formed block that decompresses to exactly dst_size bytes
+ */
+bool Lz4Decompress(const char *src, size_t size, char *dst, size_t dst_size);
+
+}  // namespace bustub
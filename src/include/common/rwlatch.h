@@ -12,27 +12,128 @@
 
 #pragma once
 
+#include <atomic>
 #include <climits>
 #include <condition_variable>  // NOLINT
-#include <mutex>               // NOLINT
+#include <cstdint>
+#include <mutex>  // NOLINT
 
 #include "common/macros.h"
 
 namespace bustub {
 
 /**
- * Reader-Writer latch backed by std::mutex.
+ * Reader-Writer latch backed by a single atomic word.
+ *
+ * The high bit of the word is set by a writer that holds the latch or waits for the readers to drain; the remaining
+ * bits count the readers. Uncontended RLock/RUnlock and WLock/WUnlock are a single compare-and-swap or fetch-and-op.
+ * A thread that cannot get the latch spins for a while and then parks on a condition variable, which is only touched
+ * when someone is parked. As with the mutex-based latch, writers are preferred: once a writer has entered, new
+ * readers wait until it has released the latch.
  */
 class ReaderWriterLatch {
+  static constexpr uint32_t WRITER_ENTERED = 1U << 31;
+  static constexpr uint32_t MAX_READERS = WRITER_ENTERED - 1;
+  /** Number of times the state is polled before the waiting thread parks. */
+  static constexpr int SPIN_LIMIT = 100;
+
+ public:
+  ReaderWriterLatch() = default;
+  ~ReaderWriterLatch() = default;
+
+  DISALLOW_COPY(ReaderWriterLatch);
+
+  /**
+   * Acquire a write latch.
+   */
+  void WLock() {
+    uint32_t expected = 0;
+    if (!state_.compare_exchange_strong(expected, WRITER_ENTERED, std::memory_order_acquire)) {
+      WLockSlow();
+    }
+  }
+
+  /**
+   * Release a write latch.
+   */
+  void WUnlock() {
+    state_.fetch_and(~WRITER_ENTERED, std::memory_order_seq_cst);
+    WakeWaiters();
+  }
+
+  /**
+   * Acquire a read latch.
+   */
+  void RLock() {
+    uint32_t state = state_.load(std::memory_order_relaxed);
+    if (!CanRead(state) || !state_.compare_exchange_weak(state, state + 1, std::memory_order_acquire)) {
+      RLockSlow();
+    }
+  }
+
+  /**
+   * Acquire a read latch if that does not take any waiting.
+   * @return true iff the latch was acquired
+   */
+  bool TryRLock() {
+    uint32_t state = state_.load(std::memory_order_relaxed);
+    return CanRead(state) && state_.compare_exchange_strong(state, state + 1, std::memory_order_acquire);
+  }
+
+  /**
+   * Release a read latch.
+   */
+  void RUnlock() {
+    uint32_t prev = state_.fetch_sub(1, std::memory_order_seq_cst);
+    // The last reader lets a waiting writer in; a reader leaving a full latch lets one more reader in.
+    if (((prev & WRITER_ENTERED) != 0 && (prev & MAX_READERS) == 1) || (prev & MAX_READERS) == MAX_READERS) {
+      WakeWaiters();
+    }
+  }
+
+ private:
+  static bool CanRead(uint32_t state) { return (state & WRITER_ENTERED) == 0 && (state & MAX_READERS) != MAX_READERS; }
+
+  void WLockSlow();
+  void RLockSlow();
+
+  /**
+   * Spin on the state, and then park, until pred holds for it.
+   * @param pred predicate on the latch state
+   * @return the state that satisfied pred
+   */
+  template <class Pred>
+  uint32_t WaitUntil(Pred pred);
+
+  /** Wake every parked thread, so that they check the state again. */
+  void WakeWaiters() {
+    if (parked_.load(std::memory_order_seq_cst) > 0) {
+      std::lock_guard<std::mutex> guard(park_mutex_);
+      park_cv_.notify_all();
+    }
+  }
+
+  std::atomic<uint32_t> state_{0};
+  /** Number of threads parked, or about to park, on park_cv_. */
+  std::atomic<uint32_t> parked_{0};
+  std::mutex park_mutex_;
+  std::condition_variable park_cv_;
+};
+
+/**
+ * Reader-Writer latch backed by std::mutex. Every operation takes the mutex, even when the latch is uncontended.
+ * Superseded by ReaderWriterLatch; kept as the baseline for the latch benchmark.
+ */
+class MutexReaderWriterLatch {
   using mutex_t = std::mutex;
   using cond_t = std::condition_variable;
   static const uint32_t MAX_READERS = UINT_MAX;
 
  public:
-  ReaderWriterLatch() = default;
-  ~ReaderWriterLatch() { std::lock_guard<mutex_t> guard(mutex_); }
+  MutexReaderWriterLatch() = default;
+  ~MutexReaderWriterLatch() { std::lock_guard<mutex_t> guard(mutex_); }
 
-  DISALLOW_COPY(ReaderWriterLatch);
+  DISALLOW_COPY(MutexReaderWriterLatch);
 
   /**
    * Acquire a write latch.
@@ -50,5 +50,11 @@ class IndexScanExecutor : public AbstractExecutor {
   TableHeap *table_;
   Schema *key_schema_;
   INDEXITERATOR_TYPE itr_;
+  /** Number of matching rids whose tuples are read from the table in one batch. */
+  static constexpr size_t BATCH_SIZE = 64;
+  /** The current batch: matching rids, their tuples, and the position of the next one to emit. */
+  std::vector<RID> rids_;
+  std::vector<Tuple> tuples_;
+  size_t next_{0};
 };
 }  // namespace bustub
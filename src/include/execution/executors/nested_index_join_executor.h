@@ -60,6 +60,8 @@ class NestIndexJoinExecutor : public AbstractExecutor {
   Tuple ltuple;
   /** valid tuples from inner table */
   std::vector<RID> rtuples;
+  /** The inner tuples named by rtuples, read as one batch */
+  std::vector<Tuple> rvalues;
   std::vector<RID>::iterator it;
 };
 }  // namespace bustub
@@ -12,8 +12,10 @@
 
 #pragma once
 
+#include <memory>
 #include <vector>
 
+#include "buffer/buffer_access_strategy.h"
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
 #include "execution/plans/seq_scan_plan.h"
@@ -87,5 +89,7 @@ class SeqScanExecutor : public AbstractExecutor {
   TableIterator itr_;                    // itr iterator
   TableIterator end_;                    // end iterator
   bool start_;
+  /** Private ring of frames for scanning a large table, so that the scan does not flush the shared buffer pool. */
+  std::unique_ptr<BufferAccessStrategy> strategy_;
 };
 }  // namespace bustub
@@ -14,8 +14,16 @@
 
 #include <atomic>
 #include <fstream>
+#include <functional>
 #include <future>  // NOLINT
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <set>
+#include <shared_mutex>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "common/config.h"
 
@@ -24,6 +32,38 @@ namespace bustub {
 /**
  * DiskManager takes care of the allocation and deallocation of pages within a database. It performs the reading and
  * writing of pages to and from disk, providing a logical file layer within the context of a database management system.
+ *
+ * Deallocated pages are reused by later allocations. Which pages are free is recorded in a bitmap (one bit per page,
+ * set while the page is free) that is cached in memory and, for file-based managers, persisted in a free-page map file
+ * next to the database file ("foo.db" keeps it in "foo.fsm"). A page is marked in use on disk, and synced, before
+ * AllocatePage hands it out again, and only becomes reusable once DeallocatePage has synced its free bit. The map also
+ * records how far page allocation got, reserved FSM_RESERVE_PAGES at a time ahead of the ids handed out, so a crash can
+ * at worst leak pages: those allocated but never written count as allocated after a restart, as do deallocated pages
+ * whose bit had not been synced yet.
+ *
+ * A file-based manager picks up an existing database where it left off, with its free pages, checksums and segments.
+ * It only starts over when the database file does not exist yet, or when it is told to create the database anew:
+ * pages are then allocated from page 0 again, and the free-page map, the checksum map and the segment list are
+ * emptied. The old database file is not truncated, so pages that are read before they are written again still hold
+ * the old data. RemoveFiles deletes a database along with all the files kept next to it.
+ *
+ * File-based managers also keep a CRC32C checksum of every page, computed when the page is written and verified when
+ * it is read, as page_checksum_mode says. The page layouts leave no room for it in the page header, so the checksums
+ * live in a checksum map next to the database file ("foo.db" keeps them in "foo.crc"), one ChecksumEntry per page. The
+ * entries are updated in memory as pages are written, and reach the map with the next WritePages batch, before the
+ * pages of the batch, or at shutdown. Each entry keeps the checksum of the image before as well, so a crash in the
+ * middle of a batch leaves either image of its pages, and both verify. A page written with WritePage since the last
+ * batch may fail verification after a crash although it is intact, because its entry went out without it or not at
+ * all; a page whose last write was lost altogether goes unnoticed. Damaged pages are counted and reported, but always
+ * returned as read, so such a false alarm costs nothing but the report.
+ *
+ * Besides the database file, file-based managers can keep pages in segment files, so that for example a hot index can
+ * live on a faster device, or a table can be dropped by unlinking its file. A page id names a file and a page within
+ * it (see MakePageId); the database file is file DB_FILE_ID. The segments are listed in a segment list next to the
+ * database file ("foo.db" keeps it in "foo.seg") and reopened on restart. Each segment has a free-page map and a
+ * checksum map of its own, which work like those of the database file and sit next to it ("seg.db" keeps them in
+ * "seg.db.fsm" and "seg.db.crc"). Pages of different files are read and written independently, and WritePages writes
+ * the files of a batch in parallel.
  */
 class DiskManager {
  public:
@@ -35,30 +75,92 @@ class DiskManager {
   /**
    * Creates a new disk manager that writes to the specified database file.
    * @param db_file the file name of the database file to write to
+   * @param page_size size of the pages in the file: a power of two between PAGE_SIZE and MAX_PAGE_SIZE. A file must
+   * always be opened with the page size it was created with.
+   * @param direct_io open the database file with O_DIRECT, so page reads and writes bypass the OS page cache. Falls back
+   * to buffered I/O if the file system does not support it.
+   * @param reopen pick up an existing database where it left off: keep its free pages, checksums and segments, and
+   * allocate new pages after the ones it has. false creates the database anew, discarding what the maps and the
+   * segment list held.
    */
-  explicit DiskManager(const std::string &db_file);
+  explicit DiskManager(const std::string &db_file, size_t page_size = PAGE_SIZE, bool direct_io = false,
+                       bool reopen = true);
 
-  virtual ~DiskManager() = default;
+  virtual ~DiskManager();
 
   /**
    * Shut down the disk manager and close all the file resources.
    */
-  void ShutDown();
+  virtual void ShutDown();
 
   /**
-   * Write a page to the database file.
+   * Deletes a database file and every file a disk manager keeps next to it: the log, the free-page and checksum maps,
+   * the page map of compressed databases, the segment list, and each listed segment along with its own maps. No disk
+   * manager may have the database open.
+   * @param db_file the file name of the database file
+   */
+  static void RemoveFiles(const std::string &db_file);
+
+  /**
+   * Write a page to the database file. Safe to call concurrently with other page reads and writes.
    * @param page_id id of the page
    * @param page_data raw page data
    */
   virtual void WritePage(page_id_t page_id, const char *page_data);
 
   /**
-   * Read a page from the database file.
+   * Read a page from the database file. Safe to call concurrently with other page reads and writes. Reading past the
+   * end of the file yields zeros.
    * @param page_id id of the page
    * @param[out] page_data output buffer
    */
   virtual void ReadPage(page_id_t page_id, char *page_data);
 
+  /**
+   * Write a batch of pages to the database file and make them durable. The pages are written in page id order, runs of
+   * consecutive pages with a single pwritev each, followed by one fdatasync per file. Each file in the batch is
+   * written by its own thread.
+   * @param pages the id and raw data of each page
+   */
+  virtual void WritePages(std::vector<std::pair<page_id_t, const char *>> pages);
+
+  /**
+   * Start writing a page to the database file. The page data must stay untouched until the returned future is ready.
+   * Requests may be queued until SubmitAsync is called. This implementation writes synchronously.
+   * @param page_id id of the page
+   * @param page_data raw page data
+   * @return a future that becomes ready once the write is done
+   */
+  virtual std::future<void> WritePageAsync(page_id_t page_id, const char *page_data);
+
+  /**
+   * Start reading a page from the database file. Requests may be queued until SubmitAsync is called. This
+   * implementation reads synchronously.
+   * @param page_id id of the page
+   * @param[out] page_data output buffer, filled in once the returned future is ready
+   * @return a future that becomes ready once the read is done
+   */
+  virtual std::future<void> ReadPageAsync(page_id_t page_id, char *page_data);
+
+  /** Hand all queued asynchronous requests to the device. Call this before waiting on their futures. */
+  virtual void SubmitAsync() {}
+
+  /**
+   * Get a page straight from a read-only mapping of the database file, for managers that can serve pages without a
+   * copy. The mapping stays valid as long as the disk manager.
+   * @param page_id id of the page
+   * @return the page data, or nullptr if the page has to be read with ReadPage
+   */
+  virtual const char *GetMappedPage(page_id_t page_id) { return nullptr; }
+
+  /**
+   * Hint that pages page_id, page_id + 1, ... are about to be read in order, so that the manager can read them ahead.
+   * Does nothing by default.
+   * @param page_id id of the first page
+   * @param count number of pages
+   */
+  virtual void AdviseSequential(page_id_t page_id, size_t count) {}
+
   /**
    * Flush the entire log buffer into disk.
    * @param log_data raw log data
@@ -76,17 +178,43 @@ class DiskManager {
   bool ReadLog(char *log_data, int size, int offset);
 
   /**
-   * Allocate a page on disk.
+   * Allocate a page on disk. Deallocated pages are reused first, most recently deallocated first.
+   * @param file_id the file to allocate the page in
    * @return the id of the allocated page
+   * @throws Exception if the file does not exist or is full
    */
-  page_id_t AllocatePage();
+  page_id_t AllocatePage(file_id_t file_id = DB_FILE_ID);
 
   /**
-   * Deallocate a page on disk.
+   * Deallocate a page on disk, so that a later AllocatePage can reuse it. The caller must make sure that nobody uses
+   * the page any more. Deallocating a page that is already free or was never allocated does nothing.
    * @param page_id id of the page to deallocate
    */
   void DeallocatePage(page_id_t page_id);
 
+  /** @return the number of deallocated pages waiting to be reused, in all files */
+  size_t GetNumFreePages();
+
+  /**
+   * Create a segment file, or open an existing one, and add it to the segment list.
+   * @param file_name path of the segment file; it may be on another device than the database file
+   * @return the file id of the segment; a file that is already in the list keeps its id
+   * @throws Exception if the manager has no segments (it is not file-based), all file ids are taken, or the file cannot
+   * be opened
+   */
+  file_id_t CreateSegment(const std::string &file_name);
+
+  /**
+   * Drop a segment: remove it from the segment list, and close and unlink its file and maps. Its id is not handed out
+   * again until the next restart. Pages of the segment read as zeros from now on, and writes to them are discarded, so
+   * pages still in a buffer pool can simply be left to be evicted.
+   * @param file_id the file id of the segment
+   */
+  void DropSegment(file_id_t file_id);
+
+  /** @return the path of a file, or an empty string if there is no such file */
+  std::string GetFileName(file_id_t file_id);
+
   /** @return the number of disk flushes */
   int GetNumFlushes() const;
 
@@ -96,6 +224,24 @@ class DiskManager {
   /** @return the number of disk writes */
   int GetNumWrites() const;
 
+  /** @return the number of times the database file was synced to disk */
+  int GetNumSyncs() const { return num_syncs_; }
+
+  /** @return the number of page reads whose checksum did not match */
+  int GetNumChecksumFailures() const { return num_checksum_failures_; }
+
+  /**
+   * @return the pages that failed verification while page_checksum_mode was REPAIR and have not been written since,
+   * in page id order
+   */
+  std::vector<page_id_t> GetDamagedPages();
+
+  /** @return the size of the pages read and written by this disk manager */
+  size_t GetPageSize() const { return page_size_; }
+
+  /** @return true iff page I/O bypasses the OS page cache */
+  bool IsDirectIO() const { return direct_io_; }
+
   /**
    * Sets the future which is used to check for non-blocking flushes.
    * @param f the non-blocking flush check
@@ -105,19 +251,276 @@ class DiskManager {
   /** Checks if the non-blocking flush future was set. */
   inline bool HasFlushLogFuture() { return flush_log_f_ != nullptr; }
 
+  /**
+   * Registers something that uses the disk manager from a background thread, e.g. the writer of a buffer pool. Before
+   * the disk manager shuts down or is destroyed, whichever comes first, it calls stop, which must not return before
+   * the thread is done with the disk manager. Owners can therefore be torn down in either order.
+   * @param stop stops the background user
+   * @return a handle to pass to RemoveBackgroundUser
+   */
+  size_t AddBackgroundUser(std::function<void()> stop);
+
+  /**
+   * Unregisters a background user that has stopped by itself. Must not be called once stop has been called.
+   * @param handle the handle returned by AddBackgroundUser
+   */
+  void RemoveBackgroundUser(size_t handle);
+
  protected:
+  /** Stops all background users. ShutDown and every destructor call this before they tear anything down. */
+  void StopBackgroundUsers();
+
+  // O_DIRECT needs buffers, offsets and lengths aligned to the logical block size of the device, which is at most 4K
+  static constexpr size_t DIRECT_IO_ALIGNMENT = 4096;
+  // how far ahead of the page ids handed out the free-page map reserves them, so that it is not synced on every extension
+  static constexpr page_id_t FSM_RESERVE_PAGES = 64;
+
   int GetFileSize(const std::string &file_name);
+  /**
+   * Checks that a page size can be used.
+   * @param page_size the requested page size
+   * @return page_size
+   */
+  static size_t CheckPageSize(size_t page_size);
+
+  /** Opens the log file next to the database file, creating it if needed. */
+  void OpenLogFile();
+
+  /**
+   * Loads the segment list next to the database file, creating it if needed, and opens the segments in it.
+   * @param reopen false to empty the list instead
+   */
+  void OpenSegments(bool reopen);
+
+
+  /**
+   * Opens the database file, creating it if needed, and caches its size.
+   * @param direct_io try O_DIRECT first
+   */
+  void OpenDbFile(bool direct_io);
+
+  /**
+   * Raises the cached file size after a write, unless a concurrent write already raised it further.
+   * @param end offset of the end of the write
+   */
+  void GrowFileSize(int64_t end) { GrowFileSize(&db_file_size_, end); }
+
+  /** Same as above, for any file. */
+  static void GrowFileSize(std::atomic<int64_t> *file_size, int64_t end);
+
+  /** An entry of the checksum map. This is also its on-disk format. */
+  struct ChecksumEntry {
+    /** flag: crc_ is the checksum of the last image written */
+    static constexpr uint32_t HAS_CRC = 1;
+    /** flag: prev_crc_ is the checksum of the image before it */
+    static constexpr uint32_t HAS_PREV_CRC = 2;
+    uint32_t crc_;
+    uint32_t prev_crc_;
+    uint32_t flags_;
+  };
+  static_assert(sizeof(ChecksumEntry) == 12, "checksum map entries must be packed");
+
+  /** The free-page map and the checksum map of a file. Both are indexed by the page number within the file. */
+  struct PageMaps {
+    // free-page map file, read and written with pread/pwrite: a header block holding allocated_end_, then the bitmap
+    // in blocks of page_size_ bytes; -1 for managers without one
+    int fsm_fd_{-1};
+    std::string fsm_name_;
+    // protected by free_page_latch_: where page allocation goes on, and how far the free-page map on disk says pages
+    // may have been handed out
+    page_id_t next_page_no_{0};
+    page_id_t allocated_end_{0};
+    // protected by free_page_latch_: one bit per page, set while the page is free; always a whole number of blocks
+    std::vector<uint8_t> free_page_bitmap_;
+    // protected by free_page_latch_: the free pages, in the order they were deallocated, so that allocation is O(1)
+    std::vector<page_id_t> free_pages_;
+    // checksum map file, read and written with pread/pwrite; -1 for managers without checksums
+    int crc_fd_{-1};
+    std::string crc_name_;
+    // protected by checksum_latch_: the checksum entry of each page
+    std::vector<ChecksumEntry> checksums_;
+    // protected by checksum_latch_: the pages whose entries changed since the checksum map was last synced
+    std::set<page_id_t> dirty_checksums_;
+    // orders the writes of the checksum map, so that entries land in the order they were recorded
+    std::mutex checksum_io_latch_;
+  };
+
+  /**
+   * Opens the free-page map and the checksum map of a file, creating them if needed, and loads them.
+   * @param maps the maps to open
+   * @param base_name the maps are kept in base_name + ".fsm" and base_name + ".crc"
+   * @param file_size size of the file the maps belong to: it decides which pages exist
+   * @param reopen false to empty both maps instead, and start allocating at page 0
+   */
+  void OpenPageMaps(PageMaps *maps, const std::string &base_name, int64_t file_size, bool reopen);
+
+  /**
+   * Records in the free-page map exactly how far page allocation got, persists the checksum entries that changed, and
+   * closes both maps. The caller holds free_page_latch_.
+   */
+  void ClosePageMaps(PageMaps *maps);
+
+  /**
+   * Loads a checksum map. Checksums of pages past the end of the file are dropped, like in LoadFreePageMap.
+   * @param maps the maps of the file, with crc_fd_ open
+   * @param file_size size of the file
+   */
+  void LoadChecksums(PageMaps *maps, int64_t file_size);
+
+  /**
+   * Records the checksums of pages that are about to be written, or that they have none if page_checksum_mode is OFF.
+   * Only the entries in memory change; SyncChecksums persists them. Must be called before the pages are written.
+   * @param maps the maps of the file the pages belong to
+   * @param pages the id and raw data of each page, in any order
+   * @param count number of pages
+   */
+  void UpdateChecksums(PageMaps *maps, const std::pair<page_id_t, const char *> *pages, size_t count);
+
+  /**
+   * Writes the checksum entries that changed since the last call to the checksum map, and syncs it once.
+   * @param maps the maps of the file
+   */
+  void SyncChecksums(PageMaps *maps);
+
+  /**
+   * Verifies a page that was just read against its checksums, unless page_checksum_mode is OFF or it has none. A
+   * mismatch is counted and logged, and in REPAIR mode remembered, see GetDamagedPages; the page is left as it is.
+   * @param maps the maps of the file the page belongs to
+   * @param page_id id of the page
+   * @param page_data raw page data
+   * @return false iff the checksum does not match
+   */
+  bool VerifyChecksum(const PageMaps &maps, page_id_t page_id, const char *page_data);
+
+  /**
+   * Loads a free-page map and picks up page allocation after the last page that was either written or handed out.
+   * Free bits for pages past that are dropped.
+   * @param maps the maps of the file, with fsm_fd_ open
+   * @param file_size size of the file
+   */
+  void LoadFreePageMap(PageMaps *maps, int64_t file_size);
+
+  /**
+   * Allocates a page of a file, see AllocatePage. The caller holds free_page_latch_.
+   * @param maps the maps of the file
+   * @param max_page_no the last page number the file can have
+   * @return the number of the allocated page within the file
+   * @throws Exception if the file is full, or its free-page map cannot be written
+   */
+  page_id_t AllocatePageNo(PageMaps *maps, page_id_t max_page_no);
+
+  /**
+   * Deallocates a page of a file, see DeallocatePage. The caller holds free_page_latch_.
+   * @param maps the maps of the file
+   * @param page_no the number of the page within the file
+   */
+  void DeallocatePageNo(PageMaps *maps, page_id_t page_no);
+
+  /**
+   * Writes the block of a free-page map that holds the bit of a page, and syncs it. Does nothing for memory based
+   * managers. The caller holds free_page_latch_.
+   * @param maps the maps of the file
+   * @param page_no the page whose bit changed
+   * @return false on an I/O error
+   */
+  bool WriteFreePageMapBlock(const PageMaps &maps, page_id_t page_no);
+
+  /**
+   * Records in a free-page map, and syncs, that pages up to end may have been handed out. The caller holds
+   * free_page_latch_.
+   * @param maps the maps of the file
+   * @param end the page number after the last one that may have been handed out
+   * @return false on an I/O error
+   */
+  bool WriteAllocatedEnd(PageMaps *maps, page_id_t end);
+
+  /** A segment file. */
+  struct Segment {
+    std::string file_name_;
+    int fd_{-1};
+    // like db_file_size_
+    std::atomic<int64_t> file_size_{0};
+    // its free-page map and checksum map; closed if the file could not be opened
+    PageMaps maps_;
+  };
+
+  /**
+   * Writes a whole page into a file, bouncing it through an aligned buffer if O_DIRECT needs it, and raises the cached
+   * file size.
+   * @param fd the file
+   * @param file_size cached size of the file
+   * @param page_no number of the page within the file
+   * @param page_data raw page data
+   * @return false on an I/O error
+   */
+  bool WritePageTo(int fd, std::atomic<int64_t> *file_size, page_id_t page_no, const char *page_data);
+
+  /**
+   * Reads a whole page from a file, zero-filling whatever is past the end of the file.
+   * @param fd the file
+   * @param file_size cached size of the file
+   * @param page_no number of the page within the file
+   * @param[out] page_data output buffer
+   * @return false if the page was not read from the file: an I/O error, or the page is past the end of the file
+   */
+  bool ReadPageFrom(int fd, const std::atomic<int64_t> &file_size, page_id_t page_no, char *page_data);
+
+  /**
+   * Writes pages of one file, consecutive pages with a single pwritev each, and syncs the file.
+   * @param pages the pages, sorted by page id
+   * @param count number of pages
+   */
+  void WriteFilePages(const std::pair<page_id_t, const char *> *pages, size_t count);
+
+  /** @return the segment with a file id, or nullptr if there is none; the caller holds segment_latch_ */
+  Segment *GetSegmentLocked(file_id_t file_id) const {
+    return file_id > DB_FILE_ID && static_cast<size_t>(file_id) < segments_.size() ? segments_[file_id].get()
+                                                                                    : nullptr;
+  }
+
+  /** Rewrites the segment list; the caller holds segment_latch_ exclusively. */
+  void WriteSegmentListLocked();
+
+  /** @return true iff the page is marked free in the cached bitmap of a file */
+  static bool IsFree(const PageMaps &maps, page_id_t page_no) {
+    size_t byte = static_cast<size_t>(page_no) / 8;
+    return byte < maps.free_page_bitmap_.size() && (maps.free_page_bitmap_[byte] & (1U << (page_no % 8))) != 0;
+  }
+
+  size_t page_size_{PAGE_SIZE};
   // stream to write log file
   std::fstream log_io_;
   std::string log_name_;
-  // stream to write db file
-  std::fstream db_io_;
+  // db file, read and written with pread/pwrite, which carry their own offsets and need no latch
+  int db_fd_{-1};
   std::string file_name_;
-  std::atomic<page_id_t> next_page_id_;
+  bool direct_io_{false};
+  // size of the db file, kept up to date by WritePage so that ReadPage does not have to stat the file
+  std::atomic<int64_t> db_file_size_{0};
+  // free-page map and checksum map of the db file
+  PageMaps db_maps_;
+  // protects the free-page maps of all files
+  std::mutex free_page_latch_;
+  // segment list file; empty for managers without segments
+  std::string seg_name_;
+  // protects segments_; held shared across segment I/O, so that a segment cannot be dropped while it is used
+  std::shared_mutex segment_latch_;
+  // the segments, by file id; the database file has no entry
+  std::vector<std::unique_ptr<Segment>> segments_;
+  // protects the checksums of all files and damaged_pages_; never held across I/O
+  std::shared_mutex checksum_latch_;
+  // pages that failed verification in REPAIR mode, until they are written again
+  std::set<page_id_t> damaged_pages_;
+  std::atomic<int> num_checksum_failures_{0};
   int num_flushes_{0};
-  int num_writes_{0};
+  std::atomic<int> num_writes_{0};
+  std::atomic<int> num_syncs_{0};
   bool flush_log_{false};
   std::future<void> *flush_log_f_{nullptr};
+  // protects background_users_ and next_background_user_; held while the users are being stopped
+  std::mutex background_user_latch_;
+  std::map<size_t, std::function<void()>> background_users_;
+  size_t next_background_user_{0};
 };
 
 }  // namespace bustub
@@ -0,0 +1,143 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_manager_compressed.h
+//
+// Identification: src/include/storage/disk/disk_manager_compressed.h
+//
+// Copyright (c) 2015-2020, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>  // NOLINT
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+/**
+ * DiskManagerCompressed stores every page LZ4-compressed, trading a little CPU for disk bandwidth on scans of
+ * repetitive data. Compression is invisible above the disk manager: ReadPage and WritePage still take whole pages.
+ *
+ * The database file is a heap of extents, each a run of SECTOR_SIZE-byte sectors holding one compressed page. Pages
+ * that would not save a sector are stored raw. A page map next to the database file ("foo.db" keeps it in "foo.map")
+ * has one fixed-size entry per page id, so finding the extent of a page is O(1). A page is never rewritten in place:
+ * every write goes to a free extent or the end of the file, and the page map in memory points to it once it is
+ * written. The page map on disk only catches up in SyncPageMap, which WritePages and ShutDown call: it syncs the
+ * database file, writes and syncs the map entries that changed, and only then are the extents they replaced free to be
+ * reused. A crash at any point leaves every page with an intact copy, the one of the last sync or a later one. Free
+ * extents are recovered from the gaps between live extents after a restart.
+ *
+ * Direct and asynchronous I/O are not supported: extents are not aligned, and reads and writes go through the page map.
+ * Neither are segment files.
+ * The page map latch is only held to look up, allocate and install extents, never across I/O, so reads and writes of
+ * pages run concurrently. WritePage does no sync at all; durability comes with the next WritePages batch.
+ */
+class DiskManagerCompressed : public DiskManager {
+ public:
+  /** Granularity of the extents in the database file. */
+  static constexpr size_t SECTOR_SIZE = 512;
+
+  /**
+   * Creates a new disk manager that writes compressed pages to the specified database file.
+   * @param db_file the file name of the database file, see DiskManager
+   * @param page_size size of the pages, see DiskManager
+   * @param reopen pick up an existing database, see DiskManager
+   * @throws Exception if the files cannot be opened
+   */
+  explicit DiskManagerCompressed(const std::string &db_file, size_t page_size = PAGE_SIZE, bool reopen = true);
+
+  ~DiskManagerCompressed() override;
+
+  DISALLOW_COPY_AND_MOVE(DiskManagerCompressed);
+
+  void ShutDown() override;
+
+  void WritePage(page_id_t page_id, const char *page_data) override;
+
+  void ReadPage(page_id_t page_id, char *page_data) override;
+
+  /** Writes the pages, then syncs them and every page written before along with the page map, see SyncPageMap. */
+  void WritePages(std::vector<std::pair<page_id_t, const char *>> pages) override;
+
+ private:
+  /** Where a page is stored. This is also the on-disk format of a page map entry. */
+  struct Extent {
+    /** first sector of the extent */
+    uint32_t sector_;
+    /** number of sectors in the extent, 0 if the page was never written */
+    uint16_t num_sectors_;
+    /** number of bytes stored, page_size_ if the page is stored raw */
+    uint16_t size_;
+  };
+  static_assert(sizeof(Extent) == 8, "page map entries must be packed");
+
+  /** Reads the page map, and rebuilds the free extents and the end of the file from it. */
+  void LoadPageMap();
+
+  /**
+   * Compresses a page.
+   * @param page_data raw page data
+   * @param[out] buf buffer of page_size_ bytes
+   * @return the bytes to store, and their size: either the compressed page in buf, or the page itself
+   */
+  std::pair<const char *, size_t> Compress(const char *page_data, char *buf) const;
+
+  /**
+   * Stores compressed pages in fresh extents and points the page map in memory to them. Their old extents are only
+   * freed by the next SyncPageMap. A page whose data could not be written keeps its old copy.
+   * @param pages the id and raw data of each page
+   * @param stored the bytes to store for each page, and their size, see Compress
+   * @param count number of pages
+   */
+  void StoreExtents(const std::pair<page_id_t, const char *> *pages, const std::pair<const char *, size_t> *stored,
+                    size_t count);
+
+  /**
+   * Syncs the database file, then writes and syncs the page map entries that changed since the last call, and then
+   * frees the extents they replaced. If any of it fails, the entries and extents wait for the next call.
+   */
+  void SyncPageMap();
+
+  /**
+   * Finds room for an extent: a free extent of the same size, a piece of a larger one, or the end of the file. The
+   * caller holds map_latch_ exclusively.
+   * @param num_sectors size of the extent
+   * @return the first sector of the extent
+   */
+  uint32_t AllocateExtentLocked(uint16_t num_sectors);
+
+  // page map file, read and written with pread/pwrite
+  int map_fd_{-1};
+  std::string map_name_;
+  // protects extents_, free_extents_, end_sector_, dirty_pages_, replaced_extents_ and reuse_epoch_; never held
+  // across I/O
+  std::shared_mutex map_latch_;
+  // serializes SyncPageMap, so that the page map entries land in the order they were installed
+  std::mutex map_io_latch_;
+  // the extent of each page
+  std::vector<Extent> extents_;
+  // the first sector of every free extent, by size in sectors
+  std::vector<std::vector<uint32_t>> free_extents_;
+  // the sector after the last extent in use
+  uint32_t end_sector_{0};
+  // the pages whose extent changed since the page map was last synced
+  std::set<page_id_t> dirty_pages_;
+  // the extents replaced since the page map was last synced, which the page map on disk may still point to
+  std::vector<Extent> replaced_extents_;
+  // bumped whenever replaced extents become free, so that ReadPage notices an extent that was reused under it
+  uint64_t reuse_epoch_{0};
+};
+
+}  // namespace bustub
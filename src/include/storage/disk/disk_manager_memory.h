@@ -12,6 +12,8 @@
 #include <fstream>
 #include <future>  // NOLINT
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "common/config.h"
 #include "storage/disk/disk_manager.h"
@@ -24,9 +26,16 @@ namespace bustub {
  */
 class DiskManagerMemory : public DiskManager {
  public:
-  DiskManagerMemory();
+  /**
+   * Creates an in-memory disk manager.
+   * @param page_size size of the pages, see DiskManager
+   */
+  explicit DiskManagerMemory(size_t page_size = PAGE_SIZE);
 
-  ~DiskManagerMemory() override { delete[] memory_; }
+  ~DiskManagerMemory() override {
+    StopBackgroundUsers();
+    delete[] memory_;
+  }
 
   /**
    * Write a page to the database file.
@@ -35,6 +44,12 @@ class DiskManagerMemory : public DiskManager {
    */
   void WritePage(page_id_t page_id, const char *page_data) override;
 
+  /**
+   * Write a batch of pages. There is nothing to coalesce or sync in memory, so this just writes them one by one.
+   * @param pages the id and raw data of each page
+   */
+  void WritePages(std::vector<std::pair<page_id_t, const char *>> pages) override;
+
   /**
    * Read a page from the database file.
    * @param page_id id of the page
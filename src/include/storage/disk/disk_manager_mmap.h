@@ -0,0 +1,74 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_manager_mmap.h
+//
+// Identification: src/include/storage/disk/disk_manager_mmap.h
+//
+// Copyright (c) 2015-2020, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+/**
+ * DiskManagerMmap serves a database file read-only out of a memory mapping, for read-only replicas whose file fits in
+ * the page cache. ReadPage is a memcpy from the mapping instead of a system call. In zero-copy mode the buffer pool
+ * does not even copy: GetMappedPage hands out the mapped page, and the buffer pool points its frame at it. Such pages
+ * must never be written to, since the mapping is read-only.
+ *
+ * The file is mapped once, at the size it has when the manager is created. Pages past that size read as zeros.
+ * WritePage throws, and no log, free-page map or segment file is opened. A checksum map next to the file is used if present.
+ */
+class DiskManagerMmap : public DiskManager {
+ public:
+  /**
+   * Maps an existing database file.
+   * @param db_file the file name of the database file
+   * @param page_size size of the pages in the file, see DiskManager
+   * @param zero_copy let the buffer pool use the mapped pages directly
+   * @throws Exception if the file cannot be opened or mapped
+   */
+  explicit DiskManagerMmap(const std::string &db_file, size_t page_size = PAGE_SIZE, bool zero_copy = false);
+
+  ~DiskManagerMmap() override;
+
+  DISALLOW_COPY_AND_MOVE(DiskManagerMmap);
+
+  /** @throws Exception, the file is read-only */
+  void WritePage(page_id_t page_id, const char *page_data) override;
+
+  /** @throws Exception unless pages is empty, the file is read-only */
+  void WritePages(std::vector<std::pair<page_id_t, const char *>> pages) override;
+
+  void ReadPage(page_id_t page_id, char *page_data) override;
+
+  const char *GetMappedPage(page_id_t page_id) override;
+
+  /** Advises the kernel to read the pages ahead (MADV_WILLNEED) and drop them soon after use (MADV_SEQUENTIAL). */
+  void AdviseSequential(page_id_t page_id, size_t count) override;
+
+  /** @return true iff the buffer pool uses the mapped pages directly */
+  bool IsZeroCopy() const { return zero_copy_; }
+
+ private:
+  /** @return the mapped page, or nullptr if it is past the end of the mapping */
+  const char *PageAt(page_id_t page_id) const;
+
+  char *mapping_{nullptr};
+  size_t mapping_size_{0};
+  bool zero_copy_;
+};
+
+}  // namespace bustub
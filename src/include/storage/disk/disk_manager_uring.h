@@ -0,0 +1,155 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_manager_uring.h
+//
+// Identification: src/include/storage/disk/disk_manager_uring.h
+//
+// Copyright (c) 2015-2020, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <sys/uio.h>
+
+#include <condition_variable>  // NOLINT
+#include <future>              // NOLINT
+#include <mutex>               // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+
+#include "common/config.h"
+#include "common/macros.h"
+#include "storage/disk/disk_manager.h"
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace bustub {
+
+/**
+ * DiskManagerUring is a DiskManager that does its asynchronous page I/O through a Linux io_uring, so that many reads
+ * and writes can be in flight at once. Requests are queued in the submission ring and handed to the kernel in batches:
+ * when SubmitAsync is called, or as soon as SUBMIT_BATCH requests are queued. A polling thread reaps the completions
+ * and fulfils the futures. At most queue_depth requests are in flight; further requests wait for a slot.
+ *
+ * If the kernel does not support io_uring (or it is disabled), the manager falls back to the synchronous
+ * implementation of DiskManager. Synchronous ReadPage and WritePage calls never go through the ring, and neither do
+ * pages of segment files.
+ */
+class DiskManagerUring : public DiskManager {
+ public:
+  /** Number of queued requests that are submitted without waiting for SubmitAsync. */
+  static constexpr unsigned SUBMIT_BATCH = 16;
+
+  /**
+   * Creates a new disk manager that writes to the specified database file.
+   * @param db_file the file name of the database file, see DiskManager
+   * @param page_size size of the pages in the file, see DiskManager
+   * @param direct_io open the database file with O_DIRECT, see DiskManager
+   * @param reopen pick up an existing database, see DiskManager
+   * @param queue_depth the most requests in flight at once
+   */
+  explicit DiskManagerUring(const std::string &db_file, size_t page_size = PAGE_SIZE, bool direct_io = false,
+                            bool reopen = true, unsigned queue_depth = 64);
+
+  /** Waits for all requests in flight, then stops the polling thread. */
+  ~DiskManagerUring() override;
+
+  DISALLOW_COPY_AND_MOVE(DiskManagerUring);
+
+  std::future<void> WritePageAsync(page_id_t page_id, const char *page_data) override;
+
+  std::future<void> ReadPageAsync(page_id_t page_id, char *page_data) override;
+
+  void SubmitAsync() override;
+
+  /** @return true iff asynchronous requests go through io_uring, false if the synchronous fallback is used */
+  bool IsUringEnabled() const { return ring_fd_ >= 0; }
+
+ private:
+  struct Request {
+    page_id_t page_id_;
+    bool is_write_;
+    /** The part of the page data still to be transferred, as the iovec the kernel reads or fills. */
+    struct iovec iov_;
+    std::promise<void> done_;
+    /** Bytes of the page transferred by earlier, short completions. */
+    size_t transferred_{0};
+  };
+
+  /** @return true iff the ring could be set up with queue_depth entries */
+  bool SetUpRing(unsigned queue_depth);
+
+  /** Unmaps the rings and closes the ring file descriptor. */
+  void TearDownRing();
+
+  /**
+   * Queues a request in the submission ring, waiting for a slot if queue_depth requests are in flight.
+   * @param request the request, or nullptr for the no-op that wakes up the polling thread to stop it
+   */
+  void Enqueue(Request *request);
+
+  /**
+   * Writes the submission ring entry of a request, for the part of the page it has not transferred yet. Must be
+   * called with sq_latch_ held.
+   * @param request the request, or nullptr for the no-op
+   */
+  void QueueLocked(Request *request);
+
+  /**
+   * Queues and submits the rest of a request after a short completion. The request keeps its slot.
+   * @param request the request
+   */
+  void Resubmit(Request *request);
+
+  /** Hands all queued requests to the kernel. Must be called with sq_latch_ held. */
+  void SubmitLocked();
+
+  /** Waits for and reaps completions until it reaps the no-op queued by the destructor. */
+  void PollLoop();
+
+  /**
+   * Finishes a request and fulfils its future, or resubmits the rest of the page after a short transfer. Only a read
+   * that reaches the end of the file is zero-filled; a short write always goes on with the rest of the page.
+   * @param request the completed request
+   * @param result the number of bytes transferred, or a negative errno
+   * @return true iff the request is finished and gave up its slot
+   */
+  bool Complete(Request *request, int result);
+
+  int ring_fd_{-1};
+  unsigned queue_depth_{0};
+
+  // submission ring, written by the threads that queue requests under sq_latch_. It cannot overflow, since it holds at
+  // least queue_depth_ entries.
+  void *sq_ring_{nullptr};
+  size_t sq_ring_size_{0};
+  unsigned *sq_tail_{nullptr};
+  unsigned sq_mask_{0};
+  unsigned *sq_array_{nullptr};
+  io_uring_sqe *sqes_{nullptr};
+  size_t sqes_size_{0};
+
+  // completion ring, read by the polling thread; shares its mapping with the submission ring if the kernel allows
+  void *cq_ring_{nullptr};
+  size_t cq_ring_size_{0};
+  unsigned *cq_head_{nullptr};
+  unsigned *cq_tail_{nullptr};
+  unsigned cq_mask_{0};
+  io_uring_cqe *cqes_{nullptr};
+
+  // protects the submission ring, pending_ and in_flight_
+  std::mutex sq_latch_;
+  // signalled when a request completes, for threads waiting for a free slot
+  std::condition_variable slot_cv_;
+  // number of requests queued in the submission ring but not yet handed to the kernel
+  unsigned pending_{0};
+  // number of requests queued or submitted but not completed yet
+  unsigned in_flight_{0};
+  std::thread poll_thread_;
+};
+
+}  // namespace bustub
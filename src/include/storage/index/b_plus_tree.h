@@ -39,8 +39,10 @@ class BPlusTree {
   using LeafPage = BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>;
 
  public:
+  // A max size of 0 makes the nodes as large as the pages of the buffer pool allow. The nodes are allocated in the file
+  // file_id of the disk manager; the root page id is recorded in the header page of the database file regardless.
   explicit BPlusTree(std::string name, BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
-                     int leaf_max_size = LEAF_PAGE_SIZE, int internal_max_size = INTERNAL_PAGE_SIZE);
+                     int leaf_max_size = 0, int internal_max_size = 0, file_id_t file_id = DB_FILE_ID);
 
   // Returns true if this B+ tree has no keys and values.
   bool IsEmpty() const;
@@ -80,6 +82,12 @@ class BPlusTree {
   Page *FindLeafPage(const KeyType &key, bool leftMost = false);
 
  private:
+  /** Optimistic descents that run into a writer are retried this many times before falling back to latching. */
+  static constexpr int OPTIMISTIC_READ_ATTEMPTS = 3;
+
+  ReadPageGuard FindLeafPageRead(const KeyType &key, bool leftMost = false);
+  ReadPageGuard FindLeafPageOptimistic(const KeyType &key, bool leftMost);
+
   void StartNewTree(const KeyType &key, const ValueType &value);
 
   bool InsertIntoLeaf(const KeyType &key, const ValueType &value, Transaction *transaction = nullptr);
@@ -111,10 +119,9 @@ class BPlusTree {
 
   /* Concurrent Access Helper Functions */
   Page *FindLeafPageWLatch(const KeyType &key, Transaction *transaction, Operation operation);
-  Page *FetchPageAndWLatch(const page_id_t &page_id);
-  Page *FetchPageAndRLatch(const page_id_t &page_id);
-  void WUnlatchAndUnpin(Transaction *transaction, bool is_dirty);  // For WLatched pages.
-  void RUnlatchAndUnpin(Page *page);                               // For RLatched pages.
+  WritePageGuard FetchPageAndWLatch(const page_id_t &page_id);
+  ReadPageGuard FetchPageAndRLatch(const page_id_t &page_id);
+  void WUnlatchAndUnpin(Transaction *transaction, bool is_dirty);  // For WLatched pages in the page set.
   void DeletePages(Transaction *transaction);
 
   // member variable
@@ -124,7 +131,11 @@ class BPlusTree {
   KeyComparator comparator_;
   int leaf_max_size_;
   int internal_max_size_;
+  file_id_t file_id_;
   std::mutex root_latch_;
+  // Pages merged away while somebody still had them pinned; the next DeletePages tries them again.
+  std::vector<page_id_t> pending_deletes_;
+  std::mutex pending_deletes_latch_;
 };
 
 }  // namespace bustub
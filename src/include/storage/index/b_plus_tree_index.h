@@ -25,7 +25,12 @@ namespace bustub {
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeIndex : public Index {
  public:
-  BPlusTreeIndex(IndexMetadata *metadata, BufferPoolManager *buffer_pool_manager);
+  /**
+   * @param metadata the index metadata
+   * @param buffer_pool_manager the buffer pool manager
+   * @param file_id the file of the disk manager that the nodes of the tree are allocated in
+   */
+  BPlusTreeIndex(IndexMetadata *metadata, BufferPoolManager *buffer_pool_manager, file_id_t file_id = DB_FILE_ID);
 
   void InsertEntry(const Tuple &key, RID rid, Transaction *transaction) override;
 
@@ -22,10 +22,14 @@ namespace bustub {
 INDEX_TEMPLATE_ARGUMENTS
 class IndexIterator {
  public:
-  IndexIterator(Page *page, int index, BufferPoolManager *bpm);
+  IndexIterator(ReadPageGuard guard, int index, BufferPoolManager *bpm);
   IndexIterator();
   ~IndexIterator();
 
+  // An iterator owns the latch on its current leaf, so it can be moved but not copied.
+  IndexIterator(IndexIterator &&that) noexcept = default;
+  IndexIterator &operator=(IndexIterator &&that) noexcept = default;
+
   bool isEnd();
 
   const MappingType &operator*();
@@ -37,10 +41,22 @@ class IndexIterator {
   bool operator!=(const IndexIterator &itr) const { return !this->operator==(itr); }
 
  private:
-  Page *page_;
-  B_PLUS_TREE_LEAF_PAGE_TYPE *leaf_;
-  int index_;
-  BufferPoolManager *bpm_;
+  /**
+   * Asks the buffer pool to read the next read_ahead_window leaves, following the sibling chain, once the iterator has
+   * reached the last leaf it read ahead before.
+   */
+  void ReadAhead();
+
+  /** @return the page ID of the next leaf, read from the raw data of a leaf page */
+  static page_id_t NextLeafPageId(const char *page_data);
+
+  /** Keeps the current leaf pinned and read-latched. */
+  ReadPageGuard guard_;
+  B_PLUS_TREE_LEAF_PAGE_TYPE *leaf_{nullptr};
+  int index_{0};
+  BufferPoolManager *bpm_{nullptr};
+  /** Leaves left until the iterator reaches the last leaf it has read ahead. */
+  size_t read_ahead_countdown_{0};
 };
 
 }  // namespace bustub
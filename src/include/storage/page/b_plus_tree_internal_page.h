@@ -37,6 +37,10 @@ class BPlusTreeInternalPage : public BPlusTreePage {
  public:
   // must call initialize method after "create" a new node
   void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID, int max_size = INTERNAL_PAGE_SIZE);
+  // number of key & child pointer pairs that fit into an internal page of the given page size
+  static int Capacity(size_t page_size) {
+    return static_cast<int>((page_size - INTERNAL_PAGE_HEADER_SIZE) / sizeof(MappingType));
+  }
 
   KeyType KeyAt(int index) const;
   void SetKeyAt(int index, const KeyType &key);
@@ -44,6 +48,7 @@ class BPlusTreeInternalPage : public BPlusTreePage {
   ValueType ValueAt(int index) const;
 
   ValueType Lookup(const KeyType &key, const KeyComparator &comparator) const;
+  ValueType OptimisticLookup(const KeyType &key, const KeyComparator &comparator, bool leftMost) const;
   void PopulateNewRoot(const ValueType &old_value, const KeyType &new_key, const ValueType &new_value);
   int InsertNodeAfter(const ValueType &old_value, const KeyType &new_key, const ValueType &new_value);
   void Remove(int index);
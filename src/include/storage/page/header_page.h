@@ -25,6 +25,7 @@ namespace bustub {
  *  -----------------------------------------------------------------
  * | RecordCount (4) | Entry_1 name (32) | Entry_1 root_id (4) | ... |
  *  -----------------------------------------------------------------
+ * The number of records is bounded by the page size of the buffer pool.
  */
 class HeaderPage : public Page {
  public:
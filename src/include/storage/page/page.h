@@ -12,8 +12,11 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>  // NOLINT
 #include <cstring>
 #include <iostream>
+#include <mutex>  // NOLINT
 
 #include "common/config.h"
 #include "common/rwlatch.h"
@@ -23,15 +26,16 @@ namespace bustub {
 /**
  * Page is the basic unit of storage within the database system. Page provides a wrapper for actual data pages being
  * held in main memory. Page also contains book-keeping information that is used by the buffer pool manager, e.g.
- * pin count, dirty flag, page id, etc.
+ * pin count, dirty flag, page id, etc. The data itself lives in a frame of the buffer pool's frame arena (or in the
+ * file mapping), never in the Page, so it is only reached through GetData().
  */
 class Page {
   // There is book-keeping information inside the page that should only be relevant to the buffer pool manager.
   friend class BufferPoolManager;
 
  public:
-  /** Constructor. Zeros out the page data. */
-  Page() { ResetMemory(); }
+  /** Constructor. The page has no data until the buffer pool assigns it a frame. */
+  Page() = default;
 
   /** Default destructor. */
   ~Page() = default;
@@ -39,6 +43,9 @@ class Page {
   /** @return the actual data contained within this page */
   inline char *GetData() { return data_; }
 
+  /** @return the size of the data contained within this page, which is the page size of the buffer pool */
+  inline size_t GetPageSize() { return page_size_; }
+
   /** @return the page id of this page */
   inline page_id_t GetPageId() { return page_id_; }
 
@@ -49,17 +56,46 @@ class Page {
   inline bool IsDirty() { return is_dirty_; }
 
   /** Acquire the page write latch. */
-  inline void WLatch() { rwlatch_.WLock(); }
+  inline void WLatch() {
+    rwlatch_.WLock();
+    version_.fetch_add(1);
+  }
 
   /** Release the page write latch. */
-  inline void WUnlatch() { rwlatch_.WUnlock(); }
+  inline void WUnlatch() {
+    version_.fetch_add(1);
+    rwlatch_.WUnlock();
+  }
 
   /** Acquire the page read latch. */
   inline void RLatch() { rwlatch_.RLock(); }
 
+  /** Acquire the page read latch if nobody holds or waits for the write latch. @return true iff it was acquired */
+  inline bool TryRLatch() { return rwlatch_.TryRLock(); }
+
   /** Release the page read latch. */
   inline void RUnlatch() { rwlatch_.RUnlock(); }
 
+  /**
+   * Starts an optimistic read of the page, which takes no latch. The page may change under the reader, so nothing
+   * that was read may be relied upon until ValidateVersion has succeeded.
+   * @param[out] version the version to validate against once the read is done
+   * @return false if the page is write-latched right now, in which case the read would fail anyway
+   */
+  inline bool ReadVersion(uint64_t *version) {
+    *version = version_.load(std::memory_order_acquire);
+    return (*version & 1) == 0;
+  }
+
+  /**
+   * @param version the version obtained from ReadVersion
+   * @return true if nobody has write-latched the page since then, so that everything read in between is consistent
+   */
+  inline bool ValidateVersion(uint64_t version) {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return version_.load(std::memory_order_relaxed) == version;
+  }
+
   /** @return the page LSN. */
   inline lsn_t GetLSN() { return *reinterpret_cast<lsn_t *>(GetData() + OFFSET_LSN); }
 
@@ -76,18 +112,32 @@ class Page {
 
  private:
   /** Zeroes out the data that is held within the page. */
-  inline void ResetMemory() { memset(data_, OFFSET_PAGE_START, PAGE_SIZE); }
+  inline void ResetMemory() { memset(data_, OFFSET_PAGE_START, page_size_); }
 
-  /** The actual data that is stored within a page. */
-  char data_[PAGE_SIZE]{};
+  /** The actual data that is stored within a page: its frame in the buffer pool, or its copy in the file mapping. */
+  char *data_ = nullptr;
+  /** Size of data_. */
+  size_t page_size_ = PAGE_SIZE;
   /** The ID of this page. */
   page_id_t page_id_ = INVALID_PAGE_ID;
-  /** The pin count of this page. */
-  int pin_count_ = 0;
+  /** The pin count of this page. Atomic so that cache hits can pin the page under a shared pool latch. */
+  std::atomic<int> pin_count_ = 0;
   /** True if the page is dirty, i.e. it is different from its corresponding page on disk. */
-  bool is_dirty_ = false;
+  std::atomic<bool> is_dirty_ = false;
+  /** True if the page was read ahead and has not been claimed by a scan yet. */
+  bool is_prefetched_ = false;
+  /**
+   * True while the buffer pool reads the page into this frame, outside of the pool latch. The page is already in the
+   * page table and pinned, so fetchers that find it wait on io_cv_ rather than on the pool latch.
+   */
+  std::atomic<bool> io_in_progress_ = false;
+  /** Protects the wait for io_in_progress_ to clear. */
+  std::mutex io_latch_;
+  std::condition_variable io_cv_;
   /** Page latch. */
   ReaderWriterLatch rwlatch_;
+  /** Incremented when the write latch is taken and again when it is released, so it is odd while a writer holds it. */
+  std::atomic<uint64_t> version_ = 0;
 };
 
 }  // namespace bustub
@@ -0,0 +1,151 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_guard.h
+//
+// Identification: src/include/storage/page/page_guard.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <type_traits>
+
+#include "common/config.h"
+#include "storage/page/page.h"
+
+namespace bustub {
+
+class BufferPoolManager;
+
+/**
+ * ReadPageGuard keeps a page pinned and read-latched for as long as it lives. Guards are returned by
+ * BufferPoolManager::FetchPageRead; they can be moved but not copied. Destroying a guard, dropping it or assigning
+ * another guard to it releases the latch and then the pin, so a page cannot be left pinned on an early return.
+ */
+class ReadPageGuard {
+ public:
+  /** Creates an invalid guard that holds no page. */
+  ReadPageGuard() = default;
+
+  /**
+   * Takes over a page that the caller has already pinned and read-latched.
+   * @param bpm the buffer pool the page was fetched from
+   * @param page the page, nullptr for an invalid guard
+   */
+  ReadPageGuard(BufferPoolManager *bpm, Page *page) : bpm_(bpm), page_(page) {}
+
+  ReadPageGuard(const ReadPageGuard &) = delete;
+  ReadPageGuard &operator=(const ReadPageGuard &) = delete;
+
+  ReadPageGuard(ReadPageGuard &&that) noexcept;
+
+  /** Releases the page held by this guard, if any, and takes over the page of that. */
+  ReadPageGuard &operator=(ReadPageGuard &&that) noexcept;
+
+  ~ReadPageGuard() { Drop(); }
+
+  /** Releases the latch and the pin now. The guard is invalid afterwards. */
+  void Drop();
+
+  /**
+   * Hands the page over to the caller, who becomes responsible for unlatching and unpinning it. The guard is invalid
+   * afterwards.
+   * @return the pinned and read-latched page
+   */
+  Page *Detach();
+
+  /** @return false if the fetch failed, or the guard was dropped, detached or moved from */
+  bool IsValid() const { return page_ != nullptr; }
+
+  /** @return the id of the guarded page */
+  page_id_t PageId() const { return page_->GetPageId(); }
+
+  /** @return the data of the guarded page */
+  const char *GetData() const { return page_->GetData(); }
+
+  /** @return the data of the guarded page viewed as a T, which the holder must only read */
+  template <class T>
+  T *As() const {
+    // Page views such as TablePage derive from Page; node layouts such as the B+ tree pages overlay the data.
+    if constexpr (std::is_base_of_v<Page, T>) {
+      return static_cast<T *>(page_);
+    } else {
+      return reinterpret_cast<T *>(page_->GetData());
+    }
+  }
+
+ private:
+  BufferPoolManager *bpm_{nullptr};
+  Page *page_{nullptr};
+};
+
+/**
+ * WritePageGuard keeps a page pinned and write-latched for as long as it lives. Guards are returned by
+ * BufferPoolManager::FetchPageWrite; they can be moved but not copied. Destroying a guard, dropping it or assigning
+ * another guard to it releases the latch and then the pin. The page is unpinned as dirty iff MarkDirty was called.
+ */
+class WritePageGuard {
+ public:
+  /** Creates an invalid guard that holds no page. */
+  WritePageGuard() = default;
+
+  /**
+   * Takes over a page that the caller has already pinned and write-latched.
+   * @param bpm the buffer pool the page was fetched from
+   * @param page the page, nullptr for an invalid guard
+   */
+  WritePageGuard(BufferPoolManager *bpm, Page *page) : bpm_(bpm), page_(page) {}
+
+  WritePageGuard(const WritePageGuard &) = delete;
+  WritePageGuard &operator=(const WritePageGuard &) = delete;
+
+  WritePageGuard(WritePageGuard &&that) noexcept;
+
+  /** Releases the page held by this guard, if any, and takes over the page of that. */
+  WritePageGuard &operator=(WritePageGuard &&that) noexcept;
+
+  ~WritePageGuard() { Drop(); }
+
+  /** Releases the latch and the pin now. The guard is invalid afterwards. */
+  void Drop();
+
+  /**
+   * Hands the page over to the caller, who becomes responsible for unlatching and unpinning it, as dirty if need be.
+   * The guard is invalid afterwards.
+   * @return the pinned and write-latched page
+   */
+  Page *Detach();
+
+  /** Records that the page was modified, so that it is unpinned as dirty. */
+  void MarkDirty() { is_dirty_ = true; }
+
+  /** @return false if the fetch failed, or the guard was dropped, detached or moved from */
+  bool IsValid() const { return page_ != nullptr; }
+
+  /** @return the id of the guarded page */
+  page_id_t PageId() const { return page_->GetPageId(); }
+
+  /** @return the data of the guarded page */
+  char *GetData() const { return page_->GetData(); }
+
+  /** @return the data of the guarded page viewed as a T */
+  template <class T>
+  T *As() const {
+    if constexpr (std::is_base_of_v<Page, T>) {
+      return static_cast<T *>(page_);
+    } else {
+      return reinterpret_cast<T *>(page_->GetData());
+    }
+  }
+
+ private:
+  BufferPoolManager *bpm_{nullptr};
+  Page *page_{nullptr};
+  bool is_dirty_{false};
+};
+
+}  // namespace bustub
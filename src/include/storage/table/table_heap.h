@@ -12,6 +12,9 @@
 
 #pragma once
 
+#include <atomic>
+#include <vector>
+
 #include "buffer/buffer_pool_manager.h"
 #include "recovery/log_manager.h"
 #include "storage/page/table_page.h"
@@ -46,9 +49,10 @@ class TableHeap {
    * @param lock_manager the lock manager
    * @param log_manager the log manager
    * @param txn the creating transaction
+   * @param file_id the file of the disk manager that the pages of the table are allocated in
    */
   TableHeap(BufferPoolManager *buffer_pool_manager, LockManager *lock_manager, LogManager *log_manager,
-            Transaction *txn);
+            Transaction *txn, file_id_t file_id = DB_FILE_ID);
 
   /**
    * Insert a tuple into the table. If the tuple is too large (>= page_size), return false.
@@ -99,8 +103,22 @@ class TableHeap {
    */
   bool GetTuple(const RID &rid, Tuple *tuple, Transaction *txn);
 
-  /** @return the begin iterator of this table */
-  TableIterator Begin(Transaction *txn);
+  /**
+   * Read several tuples from the table. The pages they live on are fetched as one batch, and each page is latched
+   * once for all of the tuples on it.
+   * @param rids rids of the tuples to read
+   * @param[out] tuples the tuples, in the order of rids
+   * @param txn transaction performing the read
+   * @return true if every read was successful
+   */
+  bool GetTuples(const std::vector<RID> &rids, std::vector<Tuple> *tuples, Transaction *txn);
+
+  /**
+   * @param txn the transaction performing the scan
+   * @param strategy ring of frames used to read the table, nullptr to read it through the shared pool
+   * @return the begin iterator of this table
+   */
+  TableIterator Begin(Transaction *txn, BufferAccessStrategy *strategy = nullptr);
 
   /** @return the end iterator of this table */
   TableIterator End();
@@ -108,11 +126,30 @@ class TableHeap {
   /** @return the id of the first page of this table */
   inline page_id_t GetFirstPageId() const { return first_page_id_; }
 
+  /**
+   * A table opened from an existing first page is walked once to count its pages. The count may lag behind pages that
+   * are being added concurrently.
+   * @return the number of pages in this table
+   */
+  size_t GetNumPages();
+
  private:
+  /**
+   * Asks the buffer pool to read the next read_ahead_window pages of the table, following the page chain from page,
+   * once the scan has reached the last page it read ahead before. Each page is thus asked for once.
+   * @param page the page the scan has just moved onto
+   * @param[in,out] countdown pages left until the scan reaches the last page read ahead; 0 on the first page
+   */
+  void ReadAhead(TablePage *page, size_t *countdown);
+
   BufferPoolManager *buffer_pool_manager_;
   LockManager *lock_manager_;
   LogManager *log_manager_;
   page_id_t first_page_id_{};
+  // the file that new pages of the table are allocated in
+  file_id_t file_id_{DB_FILE_ID};
+  // the number of pages in the table, 0 until it has been counted
+  std::atomic<size_t> num_pages_{0};
 };
 
 }  // namespace bustub
@@ -14,6 +14,7 @@
 
 #include <cassert>
 
+#include "buffer/buffer_access_strategy.h"
 #include "common/rid.h"
 #include "concurrency/transaction.h"
 #include "storage/table/tuple.h"
@@ -27,12 +28,17 @@ class TableHeap;
  */
 class TableIterator {
   friend class Cursor;
+  friend class TableHeap;
 
  public:
-  TableIterator(TableHeap *table_heap, RID rid, Transaction *txn);
+  TableIterator(TableHeap *table_heap, RID rid, Transaction *txn, BufferAccessStrategy *strategy = nullptr);
 
   TableIterator(const TableIterator &other)
-      : table_heap_(other.table_heap_), tuple_(new Tuple(*other.tuple_)), txn_(other.txn_) {}
+      : table_heap_(other.table_heap_),
+        tuple_(new Tuple(*other.tuple_)),
+        txn_(other.txn_),
+        strategy_(other.strategy_),
+        read_ahead_countdown_(other.read_ahead_countdown_) {}
 
   ~TableIterator() { delete tuple_; }
 
@@ -52,6 +58,8 @@ class TableIterator {
     table_heap_ = other.table_heap_;
     *tuple_ = *other.tuple_;
     txn_ = other.txn_;
+    strategy_ = other.strategy_;
+    read_ahead_countdown_ = other.read_ahead_countdown_;
     return *this;
   }
 
@@ -59,6 +67,10 @@ class TableIterator {
   TableHeap *table_heap_;
   Tuple *tuple_;
   Transaction *txn_;
+  /** Ring used to read the pages of the table, nullptr to read them through the shared pool. */
+  BufferAccessStrategy *strategy_;
+  /** Pages left until the scan reaches the last page it has read ahead, see TableHeap::ReadAhead. */
+  size_t read_ahead_countdown_{0};
 };
 
 }  // namespace bustub
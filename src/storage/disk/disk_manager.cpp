@@ -10,13 +10,26 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <algorithm>
 #include <cassert>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <memory>
+#include <sstream>
 #include <string>
 #include <thread>  // NOLINT
+#include <utility>
 
+#include "common/crc32c.h"
 #include "common/exception.h"
 #include "common/logger.h"
 #include "storage/disk/disk_manager.h"
@@ -25,6 +38,22 @@ namespace bustub {
 
 static char *buffer_used;
 
+/**
+ * Opens a segment file, with O_DIRECT if the db file has it and the file system supports it
+ */
+static int OpenSegmentFile(const std::string &file_name, int flags, bool direct_io) {
+  int fd = -1;
+#ifdef O_DIRECT
+  if (direct_io) {
+    fd = open(file_name.c_str(), flags | O_DIRECT, 0644);
+  }
+#endif
+  if (fd < 0) {
+    fd = open(file_name.c_str(), flags, 0644);
+  }
+  return fd;
+}
+
 /**
  * Constructor: used for memory based manager
  */
@@ -34,98 +63,181 @@ DiskManager::DiskManager() = default;
  * Constructor: open/create a single database file & log file
  * @input db_file: database file name
  */
-DiskManager::DiskManager(const std::string &db_file) : file_name_(db_file), next_page_id_(0), flush_log_f_(nullptr) {
+DiskManager::DiskManager(const std::string &db_file, size_t page_size, bool direct_io, bool reopen)
+    : page_size_(CheckPageSize(page_size)), file_name_(db_file), flush_log_f_(nullptr) {
   std::string::size_type n = file_name_.rfind('.');
   if (n == std::string::npos) {
     LOG_DEBUG("wrong file format");
     return;
   }
-  log_name_ = file_name_.substr(0, n) + ".log";
+  // Maps left next to a missing database file belong to a database that is gone.
+  reopen = reopen && GetFileSize(db_file) >= 0;
+  OpenLogFile();
+  OpenDbFile(direct_io);
+  OpenPageMaps(&db_maps_, file_name_.substr(0, n), db_file_size_, reopen);
+  OpenSegments(reopen);
+  buffer_used = nullptr;
+}
 
-  log_io_.open(log_name_, std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
-  // directory or file does not exist
-  if (!log_io_.is_open()) {
-    log_io_.clear();
-    // create a new file
-    log_io_.open(log_name_, std::ios::binary | std::ios::trunc | std::ios::app | std::ios::out);
-    log_io_.close();
-    // reopen with original mode
-    log_io_.open(log_name_, std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
-    if (!log_io_.is_open()) {
-      throw Exception("can't open dblog file");
-    }
+DiskManager::~DiskManager() {
+  StopBackgroundUsers();
+  if (db_fd_ >= 0) {
+    close(db_fd_);
   }
-
-  db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-  // directory or file does not exist
-  if (!db_io_.is_open()) {
-    db_io_.clear();
-    // create a new file
-    db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out);
-    db_io_.close();
-    // reopen with original mode
-    db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-    if (!db_io_.is_open()) {
-      throw Exception("can't open db file");
+  ClosePageMaps(&db_maps_);
+  for (auto &segment : segments_) {
+    if (segment != nullptr && segment->fd_ >= 0) {
+      close(segment->fd_);
+    }
+    if (segment != nullptr) {
+      ClosePageMaps(&segment->maps_);
     }
   }
-  buffer_used = nullptr;
 }
 
 /**
  * Close all file streams
  */
 void DiskManager::ShutDown() {
-  db_io_.close();
+  StopBackgroundUsers();
+  if (db_fd_ >= 0) {
+    close(db_fd_);
+    db_fd_ = -1;
+  }
+  std::scoped_lock<std::shared_mutex> latch(segment_latch_);
+  std::scoped_lock<std::mutex> free_page_latch(free_page_latch_);
+  ClosePageMaps(&db_maps_);
+  for (auto &segment : segments_) {
+    if (segment != nullptr && segment->fd_ >= 0) {
+      close(segment->fd_);
+      segment->fd_ = -1;
+    }
+    if (segment != nullptr) {
+      ClosePageMaps(&segment->maps_);
+    }
+  }
   log_io_.close();
 }
 
+void DiskManager::RemoveFiles(const std::string &db_file) {
+  std::string base_name = db_file.substr(0, db_file.rfind('.'));
+  std::ifstream seg_io(base_name + ".seg");
+  std::string line;
+  // one line per segment: its file id and its path
+  while (std::getline(seg_io, line)) {
+    std::istringstream entry(line);
+    file_id_t file_id;
+    std::string file_name;
+    if (entry >> file_id && std::getline(entry >> std::ws, file_name)) {
+      remove(file_name.c_str());
+      remove((file_name + ".fsm").c_str());
+      remove((file_name + ".crc").c_str());
+    }
+  }
+  seg_io.close();
+  for (const char *suffix : {".log", ".fsm", ".crc", ".map", ".seg", ".seg.tmp"}) {
+    remove((base_name + suffix).c_str());
+  }
+  remove(db_file.c_str());
+}
+
 /**
  * Write the contents of the specified page into disk file
  */
 void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
-  size_t offset = static_cast<size_t>(page_id) * PAGE_SIZE;
-  // set write cursor to offset
   num_writes_ += 1;
-  db_io_.seekp(offset);
-  db_io_.write(page_data, PAGE_SIZE);
-  // check for I/O error
-  if (db_io_.bad()) {
-    LOG_DEBUG("I/O error while writing");
+  std::pair<page_id_t, const char *> page(page_id, page_data);
+  if (GetFileId(page_id) != DB_FILE_ID) {
+    std::shared_lock<std::shared_mutex> latch(segment_latch_);
+    Segment *segment = GetSegmentLocked(GetFileId(page_id));
+    if (segment == nullptr) {
+      LOG_DEBUG("discarding write of page %d of a dropped file", page_id);
+      return;
+    }
+    UpdateChecksums(&segment->maps_, &page, 1);
+    WritePageTo(segment->fd_, &segment->file_size_, GetPageNo(page_id), page_data);
     return;
   }
-  // needs to flush to keep disk file in sync
-  db_io_.flush();
+  UpdateChecksums(&db_maps_, &page, 1);
+  WritePageTo(db_fd_, &db_file_size_, page_id, page_data);
 }
 
 /**
  * Read the contents of the specified page into the given memory area
  */
 void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
-  int offset = page_id * PAGE_SIZE;
-  // check if read beyond file length
-  if (offset > GetFileSize(file_name_)) {
-    LOG_DEBUG("I/O error reading past end of file");
-    // std::cerr << "I/O error while reading" << std::endl;
-  } else {
-    // set read cursor to offset
-    db_io_.seekp(offset);
-    db_io_.read(page_data, PAGE_SIZE);
-    if (db_io_.bad()) {
-      LOG_DEBUG("I/O error while reading");
+  if (GetFileId(page_id) != DB_FILE_ID) {
+    std::shared_lock<std::shared_mutex> latch(segment_latch_);
+    Segment *segment = GetSegmentLocked(GetFileId(page_id));
+    if (segment == nullptr) {
+      LOG_DEBUG("reading page %d of a dropped file", page_id);
+      memset(page_data, 0, page_size_);
       return;
     }
-    // if file ends before reading PAGE_SIZE
-    int read_count = db_io_.gcount();
-    if (read_count < PAGE_SIZE) {
-      LOG_DEBUG("Read less than a page");
-      db_io_.clear();
-      // std::cerr << "Read less than a page" << std::endl;
-      memset(page_data + read_count, 0, PAGE_SIZE - read_count);
+    if (ReadPageFrom(segment->fd_, segment->file_size_, GetPageNo(page_id), page_data)) {
+      VerifyChecksum(segment->maps_, page_id, page_data);
+    }
+    return;
+  }
+  if (ReadPageFrom(db_fd_, db_file_size_, page_id, page_data)) {
+    VerifyChecksum(db_maps_, page_id, page_data);
+  }
+}
+
+/**
+ * Write a batch of pages, one thread per file, and sync each file once
+ */
+void DiskManager::WritePages(std::vector<std::pair<page_id_t, const char *>> pages) {
+  if (pages.empty()) {
+    return;
+  }
+  std::sort(pages.begin(), pages.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+  num_syncs_ += 1;
+  std::shared_lock<std::shared_mutex> latch(segment_latch_);
+  // Sorting by page id groups the pages by file. The first file is written by this thread.
+  std::vector<std::future<void>> others;
+  size_t first_end = 0;
+  size_t begin = 0;
+  while (begin < pages.size()) {
+    size_t end = begin + 1;
+    while (end < pages.size() && GetFileId(pages[end].first) == GetFileId(pages[begin].first)) {
+      ++end;
+    }
+    if (begin == 0) {
+      first_end = end;
+    } else {
+      others.push_back(std::async(std::launch::async, [this, &pages, begin, end] {
+        WriteFilePages(&pages[begin], end - begin);
+      }));
     }
+    begin = end;
+  }
+  WriteFilePages(&pages[0], first_end);
+  for (auto &done : others) {
+    done.wait();
   }
 }
 
+/**
+ * Write the contents of the specified page synchronously, for managers without asynchronous I/O
+ */
+std::future<void> DiskManager::WritePageAsync(page_id_t page_id, const char *page_data) {
+  WritePage(page_id, page_data);
+  std::promise<void> done;
+  done.set_value();
+  return done.get_future();
+}
+
+/**
+ * Read the contents of the specified page synchronously, for managers without asynchronous I/O
+ */
+std::future<void> DiskManager::ReadPageAsync(page_id_t page_id, char *page_data) {
+  ReadPage(page_id, page_data);
+  std::promise<void> done;
+  done.set_value();
+  return done.get_future();
+}
+
 /**
  * Write the contents of the log into disk file
  * Only return when sync is done, and only perform sequence write
@@ -190,16 +302,128 @@ bool DiskManager::ReadLog(char *log_data, int size, int offset) {
 
 /**
  * Allocate new page (operations like create index/table)
- * For now just keep an increasing counter
+ * Reuse the most recently deallocated page if there is one, otherwise extend the file
  */
-page_id_t DiskManager::AllocatePage() { return next_page_id_++; }
+page_id_t DiskManager::AllocatePage(file_id_t file_id) {
+  if (file_id != DB_FILE_ID) {
+    std::shared_lock<std::shared_mutex> segment_latch(segment_latch_);
+    Segment *segment = GetSegmentLocked(file_id);
+    if (segment == nullptr) {
+      throw Exception(ExceptionType::OUT_OF_RANGE, "no such file");
+    }
+    std::scoped_lock<std::mutex> latch(free_page_latch_);
+    return MakePageId(file_id, AllocatePageNo(&segment->maps_, MAX_SEGMENT_PAGE_NO));
+  }
+  std::scoped_lock<std::mutex> latch(free_page_latch_);
+  return AllocatePageNo(&db_maps_, MAX_DB_PAGE_NO);
+}
 
 /**
  * Deallocate page (operations like drop index/table)
- * Need bitmap in header page for tracking pages
- * This does not actually need to do anything for now.
+ * Mark the page free in the free-page map, so that AllocatePage can reuse it
+ */
+void DiskManager::DeallocatePage(page_id_t page_id) {
+  if (GetFileId(page_id) != DB_FILE_ID) {
+    std::shared_lock<std::shared_mutex> segment_latch(segment_latch_);
+    Segment *segment = GetSegmentLocked(GetFileId(page_id));
+    std::scoped_lock<std::mutex> latch(free_page_latch_);
+    if (segment != nullptr) {
+      DeallocatePageNo(&segment->maps_, GetPageNo(page_id));
+    }
+    return;
+  }
+  std::scoped_lock<std::mutex> latch(free_page_latch_);
+  DeallocatePageNo(&db_maps_, page_id);
+}
+
+/**
+ * Returns the number of free pages
  */
-void DiskManager::DeallocatePage(__attribute__((unused)) page_id_t page_id) {}
+size_t DiskManager::GetNumFreePages() {
+  std::shared_lock<std::shared_mutex> segment_latch(segment_latch_);
+  std::scoped_lock<std::mutex> latch(free_page_latch_);
+  size_t num_free_pages = db_maps_.free_pages_.size();
+  for (const auto &segment : segments_) {
+    if (segment != nullptr) {
+      num_free_pages += segment->maps_.free_pages_.size();
+    }
+  }
+  return num_free_pages;
+}
+
+/**
+ * Create or open a segment file and give it a file id
+ */
+file_id_t DiskManager::CreateSegment(const std::string &file_name) {
+  std::scoped_lock<std::shared_mutex> latch(segment_latch_);
+  if (seg_name_.empty()) {
+    throw Exception(ExceptionType::NOT_IMPLEMENTED, "this disk manager has no segment files");
+  }
+  for (size_t file_id = 0; file_id < segments_.size(); ++file_id) {
+    if (segments_[file_id] != nullptr && segments_[file_id]->file_name_ == file_name) {
+      return static_cast<file_id_t>(file_id);
+    }
+  }
+  // Ids of dropped segments are not reused, their pages may still be in a buffer pool.
+  auto file_id = static_cast<file_id_t>(std::max<size_t>(segments_.size(), DB_FILE_ID + 1));
+  if (file_id > MAX_FILE_ID) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "too many segment files");
+  }
+  auto segment = std::make_unique<Segment>();
+  segment->file_name_ = file_name;
+  segment->fd_ = OpenSegmentFile(file_name, O_RDWR | O_CREAT, direct_io_);
+  if (segment->fd_ < 0) {
+    throw Exception("can't open segment file");
+  }
+  struct stat stat_buf;
+  segment->file_size_ = fstat(segment->fd_, &stat_buf) == 0 ? static_cast<int64_t>(stat_buf.st_size) : 0;
+  // An existing file keeps its pages, and the free pages and checksums its maps have for them.
+  try {
+    OpenPageMaps(&segment->maps_, file_name, segment->file_size_, true);
+  } catch (Exception &) {
+    close(segment->fd_);
+    throw;
+  }
+  segments_.resize(file_id + 1);
+  segments_[file_id] = std::move(segment);
+  WriteSegmentListLocked();
+  return file_id;
+}
+
+/**
+ * Drop a segment file
+ */
+void DiskManager::DropSegment(file_id_t file_id) {
+  std::scoped_lock<std::shared_mutex> latch(segment_latch_);
+  Segment *segment = GetSegmentLocked(file_id);
+  if (segment == nullptr) {
+    return;
+  }
+  if (segment->fd_ >= 0) {
+    close(segment->fd_);
+  }
+  std::scoped_lock<std::mutex> free_page_latch(free_page_latch_);
+  ClosePageMaps(&segment->maps_);
+  for (const std::string &name : {segment->file_name_, segment->maps_.fsm_name_, segment->maps_.crc_name_}) {
+    if (!name.empty() && unlink(name.c_str()) != 0) {
+      LOG_DEBUG("can't unlink segment file %s", name.c_str());
+    }
+  }
+  segments_[file_id].reset();
+  WriteSegmentListLocked();
+}
+
+/**
+ * Returns the path of a file
+ */
+std::string DiskManager::GetFileName(file_id_t file_id) {
+  if (file_id == DB_FILE_ID) {
+    return file_name_;
+  }
+  std::shared_lock<std::shared_mutex> latch(segment_latch_);
+  Segment *segment = GetSegmentLocked(file_id);
+  return segment == nullptr ? "" : segment->file_name_;
+}
 
 /**
  * Returns number of flushes made so far
@@ -216,6 +440,641 @@ int DiskManager::GetNumWrites() const { return num_writes_; }
  */
 bool DiskManager::GetFlushState() const { return flush_log_; }
 
+size_t DiskManager::AddBackgroundUser(std::function<void()> stop) {
+  std::scoped_lock<std::mutex> latch(background_user_latch_);
+  background_users_.emplace(next_background_user_, std::move(stop));
+  return next_background_user_++;
+}
+
+void DiskManager::RemoveBackgroundUser(size_t handle) {
+  std::scoped_lock<std::mutex> latch(background_user_latch_);
+  background_users_.erase(handle);
+}
+
+void DiskManager::StopBackgroundUsers() {
+  std::scoped_lock<std::mutex> latch(background_user_latch_);
+  for (auto &[handle, stop] : background_users_) {
+    stop();
+  }
+  background_users_.clear();
+}
+
+/**
+ * Private helper function to validate a page size
+ */
+size_t DiskManager::CheckPageSize(size_t page_size) {
+  if (page_size < static_cast<size_t>(PAGE_SIZE) || page_size > static_cast<size_t>(MAX_PAGE_SIZE) ||
+      (page_size & (page_size - 1)) != 0) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "page size must be a power of two in [PAGE_SIZE, MAX_PAGE_SIZE]");
+  }
+  return page_size;
+}
+
+/**
+ * Private helper function to write a page into a file
+ */
+bool DiskManager::WritePageTo(int fd, std::atomic<int64_t> *file_size, page_id_t page_no, const char *page_data) {
+  auto offset = static_cast<off_t>(page_no) * static_cast<off_t>(page_size_);
+  // O_DIRECT cannot write from an unaligned buffer, so bounce those through an aligned copy
+  std::unique_ptr<char, decltype(&std::free)> bounce(nullptr, &std::free);
+  if (direct_io_ && reinterpret_cast<uintptr_t>(page_data) % DIRECT_IO_ALIGNMENT != 0) {
+    bounce.reset(static_cast<char *>(std::aligned_alloc(DIRECT_IO_ALIGNMENT, page_size_)));
+    memcpy(bounce.get(), page_data, page_size_);
+    page_data = bounce.get();
+  }
+  size_t written = 0;
+  while (written < page_size_) {
+    ssize_t n = pwrite(fd, page_data + written, page_size_ - written, offset + static_cast<off_t>(written));
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    // check for I/O error
+    if (n <= 0) {
+      LOG_DEBUG("I/O error while writing");
+      return false;
+    }
+    written += n;
+  }
+  // pwrite hands the page straight to the kernel, there is no user-space buffer to flush
+  GrowFileSize(file_size, offset + page_size_);
+  return true;
+}
+
+/**
+ * Private helper function to read a page from a file
+ */
+bool DiskManager::ReadPageFrom(int fd, const std::atomic<int64_t> &file_size, page_id_t page_no, char *page_data) {
+  auto offset = static_cast<off_t>(page_no) * static_cast<off_t>(page_size_);
+  // check if read beyond file length
+  if (offset >= file_size.load(std::memory_order_acquire)) {
+    LOG_DEBUG("I/O error reading past end of file");
+    memset(page_data, 0, page_size_);
+    return false;
+  }
+  char *buf = page_data;
+  std::unique_ptr<char, decltype(&std::free)> bounce(nullptr, &std::free);
+  if (direct_io_ && reinterpret_cast<uintptr_t>(page_data) % DIRECT_IO_ALIGNMENT != 0) {
+    bounce.reset(static_cast<char *>(std::aligned_alloc(DIRECT_IO_ALIGNMENT, page_size_)));
+    buf = bounce.get();
+  }
+  size_t read_count = 0;
+  while (read_count < page_size_) {
+    ssize_t n = pread(fd, buf + read_count, page_size_ - read_count, offset + static_cast<off_t>(read_count));
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0) {
+      LOG_DEBUG("I/O error while reading");
+      return false;
+    }
+    if (n == 0) {
+      break;
+    }
+    read_count += n;
+  }
+  // if file ends before reading a whole page
+  if (read_count < page_size_) {
+    LOG_DEBUG("Read less than a page");
+    memset(buf + read_count, 0, page_size_ - read_count);
+  }
+  if (buf != page_data) {
+    memcpy(page_data, buf, page_size_);
+  }
+  return true;
+}
+
+/**
+ * Private helper function to write the pages of one file, coalescing consecutive pages, and sync the file
+ */
+void DiskManager::WriteFilePages(const std::pair<page_id_t, const char *> *pages, size_t count) {
+  file_id_t file_id = GetFileId(pages[0].first);
+  int fd = db_fd_;
+  std::atomic<int64_t> *file_size = &db_file_size_;
+  PageMaps *maps = &db_maps_;
+  if (file_id != DB_FILE_ID) {
+    Segment *segment = GetSegmentLocked(file_id);
+    if (segment == nullptr) {
+      LOG_DEBUG("discarding writes to a dropped file");
+      return;
+    }
+    fd = segment->fd_;
+    file_size = &segment->file_size_;
+    maps = &segment->maps_;
+  }
+  UpdateChecksums(maps, pages, count);
+  SyncChecksums(maps);
+  auto aligned = [&](const char *page_data) {
+    return !direct_io_ || reinterpret_cast<uintptr_t>(page_data) % DIRECT_IO_ALIGNMENT == 0;
+  };
+  std::vector<struct iovec> iov;
+  size_t begin = 0;
+  while (begin < count) {
+    size_t end = begin + 1;
+    // WritePageTo bounces pages that O_DIRECT cannot write from.
+    if (!aligned(pages[begin].second)) {
+      num_writes_ += 1;
+      WritePageTo(fd, file_size, GetPageNo(pages[begin].first), pages[begin].second);
+      begin = end;
+      continue;
+    }
+    while (end < count && end - begin < IOV_MAX && pages[end].first == pages[end - 1].first + 1 &&
+           aligned(pages[end].second)) {
+      ++end;
+    }
+    iov.clear();
+    for (size_t i = begin; i < end; ++i) {
+      iov.push_back({const_cast<char *>(pages[i].second), page_size_});  // NOLINT
+    }
+    num_writes_ += end - begin;
+
+    auto offset = static_cast<off_t>(GetPageNo(pages[begin].first)) * static_cast<off_t>(page_size_);
+    size_t total = iov.size() * page_size_;
+    size_t written = 0;
+    while (written < total) {
+      // After a short write, resume in the middle of the page it stopped in.
+      size_t first = written / page_size_;
+      iov[first].iov_base = const_cast<char *>(pages[begin + first].second) + written % page_size_;  // NOLINT
+      iov[first].iov_len = page_size_ - written % page_size_;
+      ssize_t n =
+          pwritev(fd, iov.data() + first, static_cast<int>(iov.size() - first), offset + static_cast<off_t>(written));
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      if (n <= 0) {
+        LOG_DEBUG("I/O error while writing");
+        break;
+      }
+      written += n;
+    }
+    GrowFileSize(file_size, offset + static_cast<int64_t>(written));
+    begin = end;
+  }
+  if (fdatasync(fd) != 0) {
+    LOG_DEBUG("I/O error while syncing");
+  }
+}
+
+/**
+ * Private helper function to open the log file
+ */
+void DiskManager::OpenLogFile() {
+  log_name_ = file_name_.substr(0, file_name_.rfind('.')) + ".log";
+
+  log_io_.open(log_name_, std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
+  // directory or file does not exist
+  if (!log_io_.is_open()) {
+    log_io_.clear();
+    // create a new file
+    log_io_.open(log_name_, std::ios::binary | std::ios::trunc | std::ios::app | std::ios::out);
+    log_io_.close();
+    // reopen with original mode
+    log_io_.open(log_name_, std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
+    if (!log_io_.is_open()) {
+      throw Exception("can't open dblog file");
+    }
+  }
+}
+
+/**
+ * Private helper function to open the segments in the segment list
+ */
+void DiskManager::OpenSegments(bool reopen) {
+  seg_name_ = file_name_.substr(0, file_name_.rfind('.')) + ".seg";
+  if (!reopen) {
+    WriteSegmentListLocked();
+    return;
+  }
+  std::ifstream seg_io(seg_name_);
+  std::string line;
+  // one line per segment: its file id and its path
+  while (std::getline(seg_io, line)) {
+    std::istringstream entry(line);
+    file_id_t file_id;
+    std::string file_name;
+    if (!(entry >> file_id) || !std::getline(entry >> std::ws, file_name) || file_id <= DB_FILE_ID ||
+        file_id > MAX_FILE_ID) {
+      LOG_DEBUG("skipping malformed segment list entry");
+      continue;
+    }
+    auto segment = std::make_unique<Segment>();
+    segment->file_name_ = file_name;
+    segment->fd_ = OpenSegmentFile(file_name, O_RDWR, direct_io_);
+    // A missing segment reads as zeros, and keeps its entry until it is dropped.
+    if (segment->fd_ < 0) {
+      LOG_WARN("can't open segment file %s", file_name.c_str());
+    }
+    struct stat stat_buf;
+    segment->file_size_ =
+        segment->fd_ >= 0 && fstat(segment->fd_, &stat_buf) == 0 ? static_cast<int64_t>(stat_buf.st_size) : 0;
+    if (segment->fd_ >= 0) {
+      OpenPageMaps(&segment->maps_, file_name, segment->file_size_, true);
+    }
+    if (segments_.size() <= static_cast<size_t>(file_id)) {
+      segments_.resize(file_id + 1);
+    }
+    segments_[file_id] = std::move(segment);
+  }
+}
+
+/**
+ * Private helper function to persist the segment list
+ */
+void DiskManager::WriteSegmentListLocked() {
+  // Written aside, synced and renamed over the old list, and the rename synced too, so that a crash leaves one whole
+  // list or the other.
+  std::ostringstream seg_io;
+  for (size_t file_id = 0; file_id < segments_.size(); ++file_id) {
+    if (segments_[file_id] != nullptr) {
+      seg_io << file_id << ' ' << segments_[file_id]->file_name_ << '\n';
+    }
+  }
+  std::string list = seg_io.str();
+  std::string tmp_name = seg_name_ + ".tmp";
+  int fd = open(tmp_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    LOG_DEBUG("can't open the segment list");
+    return;
+  }
+  size_t written = 0;
+  while (written < list.size()) {
+    ssize_t n = write(fd, list.data() + written, list.size() - written);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      break;
+    }
+    written += n;
+  }
+  bool ok = written == list.size() && fdatasync(fd) == 0;
+  ok = close(fd) == 0 && ok;
+  if (!ok) {
+    LOG_DEBUG("I/O error while writing the segment list");
+    return;
+  }
+  if (rename(tmp_name.c_str(), seg_name_.c_str()) != 0) {
+    LOG_DEBUG("I/O error while replacing the segment list");
+    return;
+  }
+  size_t slash = seg_name_.rfind('/');
+  std::string dir_name = slash == std::string::npos ? "." : seg_name_.substr(0, slash + 1);
+  int dir_fd = open(dir_name.c_str(), O_RDONLY | O_DIRECTORY);
+  if (dir_fd < 0 || fsync(dir_fd) != 0) {
+    LOG_DEBUG("I/O error while syncing the directory of the segment list");
+  }
+  if (dir_fd >= 0) {
+    close(dir_fd);
+  }
+}
+
+/**
+ * Private helper function to open and load the free-page map and the checksum map of a file
+ */
+void DiskManager::OpenPageMaps(PageMaps *maps, const std::string &base_name, int64_t file_size, bool reopen) {
+  int flags = reopen ? O_RDWR | O_CREAT : O_RDWR | O_CREAT | O_TRUNC;
+  maps->fsm_name_ = base_name + ".fsm";
+  maps->fsm_fd_ = open(maps->fsm_name_.c_str(), flags, 0644);
+  if (maps->fsm_fd_ < 0) {
+    throw Exception("can't open free-page map file");
+  }
+  if (reopen) {
+    LoadFreePageMap(maps, file_size);
+  } else {
+    maps->next_page_no_ = 0;
+  }
+
+  maps->crc_name_ = base_name + ".crc";
+  maps->crc_fd_ = open(maps->crc_name_.c_str(), flags, 0644);
+  if (maps->crc_fd_ < 0) {
+    close(maps->fsm_fd_);
+    maps->fsm_fd_ = -1;
+    throw Exception("can't open checksum map file");
+  }
+  LoadChecksums(maps, file_size);
+}
+
+/**
+ * Private helper function to close the maps of a file
+ */
+void DiskManager::ClosePageMaps(PageMaps *maps) {
+  if (maps->fsm_fd_ >= 0) {
+    // A clean shutdown leaks none of the reserved page ids.
+    WriteAllocatedEnd(maps, maps->next_page_no_);
+    close(maps->fsm_fd_);
+    maps->fsm_fd_ = -1;
+  }
+  if (maps->crc_fd_ >= 0) {
+    SyncChecksums(maps);
+    close(maps->crc_fd_);
+    maps->crc_fd_ = -1;
+  }
+}
+
+/**
+ * Private helper function to open the db file
+ */
+void DiskManager::OpenDbFile(bool direct_io) {
+  int flags = O_RDWR | O_CREAT;
+#ifdef O_DIRECT
+  if (direct_io) {
+    db_fd_ = open(file_name_.c_str(), flags | O_DIRECT, 0644);
+    // some file systems, such as tmpfs, refuse O_DIRECT; those get buffered I/O below
+    direct_io_ = db_fd_ >= 0;
+  }
+#endif
+  if (db_fd_ < 0) {
+    db_fd_ = open(file_name_.c_str(), flags, 0644);
+  }
+  if (db_fd_ < 0) {
+    throw Exception("can't open db file");
+  }
+  struct stat stat_buf;
+  db_file_size_ = fstat(db_fd_, &stat_buf) == 0 ? static_cast<int64_t>(stat_buf.st_size) : 0;
+}
+
+/**
+ * Private helper function to keep the cached db file size up to date
+ */
+void DiskManager::GrowFileSize(std::atomic<int64_t> *file_size, int64_t end) {
+  int64_t size = file_size->load(std::memory_order_relaxed);
+  while (size < end && !file_size->compare_exchange_weak(size, end, std::memory_order_release)) {
+  }
+}
+
+/**
+ * Private helper function to read a free-page map and find where page allocation left off
+ */
+void DiskManager::LoadFreePageMap(PageMaps *maps, int64_t file_size) {
+  struct stat stat_buf;
+  int64_t fsm_size = fstat(maps->fsm_fd_, &stat_buf) == 0 ? static_cast<int64_t>(stat_buf.st_size) : 0;
+  page_id_t allocated_end = 0;
+  if (fsm_size >= static_cast<int64_t>(sizeof(allocated_end)) &&
+      pread(maps->fsm_fd_, &allocated_end, sizeof(allocated_end), 0) != static_cast<ssize_t>(sizeof(allocated_end))) {
+    LOG_DEBUG("I/O error while reading the free-page map");
+    allocated_end = 0;
+  }
+  // Pages past the end of the file may still have been handed out before a crash, up to the recorded end.
+  page_id_t file_end = file_size <= 0 ? 0 : static_cast<page_id_t>((file_size + page_size_ - 1) / page_size_);
+  maps->next_page_no_ = std::max(file_end, allocated_end);
+  maps->allocated_end_ = maps->next_page_no_;
+
+  // A partial trailing block can only come from an interrupted extension of the map, which had not set any bits yet.
+  std::vector<uint8_t> &bitmap = maps->free_page_bitmap_;
+  size_t num_blocks = fsm_size <= static_cast<int64_t>(page_size_) ? 0 : (fsm_size - page_size_) / page_size_;
+  bitmap.assign(num_blocks * page_size_, 0);
+  if (num_blocks > 0 && pread(maps->fsm_fd_, bitmap.data(), bitmap.size(), page_size_) < 0) {
+    LOG_DEBUG("I/O error while reading the free-page map");
+    bitmap.assign(num_blocks * page_size_, 0);
+  }
+
+  bool dropped = false;
+  for (size_t byte = 0; byte < bitmap.size(); ++byte) {
+    for (size_t bit = 0; bit < 8 && bitmap[byte] != 0; ++bit) {
+      if ((bitmap[byte] & (1U << bit)) == 0) {
+        continue;
+      }
+      auto page_no = static_cast<page_id_t>(byte * 8 + bit);
+      if (page_no < maps->next_page_no_) {
+        maps->free_pages_.push_back(page_no);
+      } else {
+        bitmap[byte] &= ~(1U << bit);
+        dropped = true;
+      }
+    }
+  }
+  // Reuse low page numbers first after a restart, which keeps the file compact.
+  std::reverse(maps->free_pages_.begin(), maps->free_pages_.end());
+  if (dropped &&
+      (pwrite(maps->fsm_fd_, bitmap.data(), bitmap.size(), page_size_) < 0 || fdatasync(maps->fsm_fd_) != 0)) {
+    LOG_DEBUG("I/O error while writing the free-page map");
+  }
+}
+
+/**
+ * Private helper function to read a checksum map
+ */
+void DiskManager::LoadChecksums(PageMaps *maps, int64_t file_size) {
+  struct stat stat_buf;
+  std::vector<ChecksumEntry> &checksums = maps->checksums_;
+  size_t num_entries =
+      fstat(maps->crc_fd_, &stat_buf) == 0 ? static_cast<size_t>(stat_buf.st_size) / sizeof(ChecksumEntry) : 0;
+  checksums.assign(num_entries, ChecksumEntry{});
+  if (num_entries > 0 && pread(maps->crc_fd_, checksums.data(), num_entries * sizeof(ChecksumEntry), 0) < 0) {
+    LOG_DEBUG("I/O error while reading the checksum map");
+    checksums.assign(num_entries, ChecksumEntry{});
+  }
+  // Entries past the end of the file can only be left over from an older file of the same name.
+  auto num_pages = static_cast<size_t>(std::max<int64_t>(file_size, 0) / page_size_);
+  bool writable = (fcntl(maps->crc_fd_, F_GETFL) & O_ACCMODE) != O_RDONLY;
+  if (writable && checksums.size() > num_pages) {
+    checksums.resize(num_pages);
+    if (ftruncate(maps->crc_fd_, num_pages * sizeof(ChecksumEntry)) != 0) {
+      LOG_DEBUG("I/O error while truncating the checksum map");
+    }
+  }
+}
+
+/**
+ * Private helper function to record the checksums of pages about to be written
+ */
+void DiskManager::UpdateChecksums(PageMaps *maps, const std::pair<page_id_t, const char *> *pages, size_t count) {
+  if (maps->crc_fd_ < 0 || count == 0) {
+    return;
+  }
+  // Checksum outside the latch; that is the expensive part.
+  bool checksums_on = page_checksum_mode != ChecksumMode::OFF;
+  std::vector<uint32_t> checksums(count, 0);
+  if (checksums_on) {
+    for (size_t i = 0; i < count; ++i) {
+      checksums[i] = Crc32c(pages[i].second, page_size_);
+    }
+  }
+  std::scoped_lock<std::shared_mutex> latch(checksum_latch_);
+  std::vector<ChecksumEntry> &entries = maps->checksums_;
+  for (size_t i = 0; i < count; ++i) {
+    auto page_no = static_cast<size_t>(GetPageNo(pages[i].first));
+    if (entries.size() <= page_no) {
+      entries.resize(page_no + 1, ChecksumEntry{});
+    }
+    damaged_pages_.erase(pages[i].first);
+    ChecksumEntry &entry = entries[page_no];
+    ChecksumEntry updated{};
+    if (checksums_on) {
+      bool has_crc = (entry.flags_ & ChecksumEntry::HAS_CRC) != 0;
+      // The image on disk keeps verifying until the new one has replaced it.
+      updated = has_crc && entry.crc_ == checksums[i]
+                    ? entry
+                    : ChecksumEntry{checksums[i], entry.crc_,
+                                    has_crc ? ChecksumEntry::HAS_CRC | ChecksumEntry::HAS_PREV_CRC
+                                            : ChecksumEntry::HAS_CRC};
+    }
+    // Without checksums, pages that never had one cost nothing.
+    if (memcmp(&updated, &entry, sizeof(entry)) == 0) {
+      continue;
+    }
+    entry = updated;
+    maps->dirty_checksums_.insert(static_cast<page_id_t>(page_no));
+  }
+}
+
+/**
+ * Private helper function to persist the checksum entries that changed, one run of consecutive entries at a time
+ */
+void DiskManager::SyncChecksums(PageMaps *maps) {
+  if (maps->crc_fd_ < 0) {
+    return;
+  }
+  // Taken before the snapshot, so that a later snapshot of the same entries cannot be overtaken on its way to disk.
+  std::scoped_lock<std::mutex> io_latch(maps->checksum_io_latch_);
+  std::vector<std::pair<size_t, std::vector<ChecksumEntry>>> runs;
+  {
+    std::scoped_lock<std::shared_mutex> latch(checksum_latch_);
+    for (page_id_t page_no : maps->dirty_checksums_) {
+      if (runs.empty() || runs.back().first + runs.back().second.size() != static_cast<size_t>(page_no)) {
+        runs.emplace_back(page_no, std::vector<ChecksumEntry>());
+      }
+      runs.back().second.push_back(maps->checksums_[page_no]);
+    }
+    maps->dirty_checksums_.clear();
+  }
+  if (runs.empty()) {
+    return;
+  }
+  bool ok = true;
+  for (const auto &[first, entries] : runs) {
+    size_t size = entries.size() * sizeof(ChecksumEntry);
+    ok = ok && pwrite(maps->crc_fd_, entries.data(), size, first * sizeof(ChecksumEntry)) == static_cast<ssize_t>(size);
+  }
+  if (!ok || fdatasync(maps->crc_fd_) != 0) {
+    LOG_DEBUG("I/O error while writing the checksum map");
+  }
+}
+
+/**
+ * Private helper function to verify the checksum of a page that was read
+ */
+bool DiskManager::VerifyChecksum(const PageMaps &maps, page_id_t page_id, const char *page_data) {
+  if (maps.crc_fd_ < 0 || page_checksum_mode == ChecksumMode::OFF) {
+    return true;
+  }
+  ChecksumEntry entry{};
+  {
+    std::shared_lock<std::shared_mutex> latch(checksum_latch_);
+    page_id_t page_no = GetPageNo(page_id);
+    if (page_no >= 0 && static_cast<size_t>(page_no) < maps.checksums_.size()) {
+      entry = maps.checksums_[page_no];
+    }
+  }
+  if ((entry.flags_ & (ChecksumEntry::HAS_CRC | ChecksumEntry::HAS_PREV_CRC)) == 0) {
+    return true;
+  }
+  uint32_t checksum = Crc32c(page_data, page_size_);
+  if (((entry.flags_ & ChecksumEntry::HAS_CRC) != 0 && checksum == entry.crc_) ||
+      ((entry.flags_ & ChecksumEntry::HAS_PREV_CRC) != 0 && checksum == entry.prev_crc_)) {
+    return true;
+  }
+  num_checksum_failures_ += 1;
+  LOG_ERROR("checksum mismatch on page %d, see %s", page_id, maps.crc_name_.c_str());
+  if (page_checksum_mode == ChecksumMode::REPAIR) {
+    std::scoped_lock<std::shared_mutex> latch(checksum_latch_);
+    damaged_pages_.insert(page_id);
+  }
+  return false;
+}
+
+/**
+ * Returns the pages found damaged in REPAIR mode
+ */
+std::vector<page_id_t> DiskManager::GetDamagedPages() {
+  std::shared_lock<std::shared_mutex> latch(checksum_latch_);
+  return {damaged_pages_.begin(), damaged_pages_.end()};
+}
+
+/**
+ * Private helper function to allocate a page of a file
+ * Reuse the most recently deallocated page if there is one, otherwise extend the file
+ */
+page_id_t DiskManager::AllocatePageNo(PageMaps *maps, page_id_t max_page_no) {
+  std::vector<uint8_t> &bitmap = maps->free_page_bitmap_;
+  if (!maps->free_pages_.empty()) {
+    page_id_t page_no = maps->free_pages_.back();
+    bitmap[page_no / 8] &= ~(1U << (page_no % 8));
+    // The page must be in use on disk before anybody can write to it.
+    if (WriteFreePageMapBlock(*maps, page_no)) {
+      maps->free_pages_.pop_back();
+      return page_no;
+    }
+    // Still free on disk, so it stays free here too; extend the file instead.
+    bitmap[page_no / 8] |= 1U << (page_no % 8);
+  }
+  if (maps->next_page_no_ > max_page_no) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "file is full");
+  }
+  // A page handed out but not written yet must not be handed out again after a crash.
+  if (maps->next_page_no_ >= maps->allocated_end_ &&
+      !WriteAllocatedEnd(maps, maps->next_page_no_ + FSM_RESERVE_PAGES)) {
+    throw Exception("can't write free-page map");
+  }
+  return maps->next_page_no_++;
+}
+
+/**
+ * Private helper function to deallocate a page of a file
+ * Mark the page free in the free-page map, so that AllocatePageNo can reuse it
+ */
+void DiskManager::DeallocatePageNo(PageMaps *maps, page_id_t page_no) {
+  if (page_no < 0 || page_no >= maps->next_page_no_ || IsFree(*maps, page_no)) {
+    return;
+  }
+  std::vector<uint8_t> &bitmap = maps->free_page_bitmap_;
+  size_t block_bytes = (static_cast<size_t>(page_no) / 8 / page_size_ + 1) * page_size_;
+  if (bitmap.size() < block_bytes) {
+    bitmap.resize(block_bytes, 0);
+  }
+  bitmap[page_no / 8] |= 1U << (page_no % 8);
+  // Reusable only once it is free on disk; until then a crash would leave it in use there, but free here.
+  if (!WriteFreePageMapBlock(*maps, page_no)) {
+    bitmap[page_no / 8] &= ~(1U << (page_no % 8));
+    return;
+  }
+  maps->free_pages_.push_back(page_no);
+}
+
+/**
+ * Private helper function to persist one block of a free-page map
+ */
+bool DiskManager::WriteFreePageMapBlock(const PageMaps &maps, page_id_t page_no) {
+  if (maps.fsm_fd_ < 0) {
+    return true;
+  }
+  size_t offset = static_cast<size_t>(page_no) / 8 / page_size_ * page_size_;
+  // The bitmap starts after the header block.
+  if (pwrite(maps.fsm_fd_, maps.free_page_bitmap_.data() + offset, page_size_, page_size_ + offset) !=
+          static_cast<ssize_t>(page_size_) ||
+      fdatasync(maps.fsm_fd_) != 0) {
+    LOG_DEBUG("I/O error while writing the free-page map");
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Private helper function to persist how far page allocation may have got
+ */
+bool DiskManager::WriteAllocatedEnd(PageMaps *maps, page_id_t end) {
+  if (maps->fsm_fd_ < 0) {
+    maps->allocated_end_ = end;
+    return true;
+  }
+  if (pwrite(maps->fsm_fd_, &end, sizeof(end), 0) != static_cast<ssize_t>(sizeof(end)) ||
+      fdatasync(maps->fsm_fd_) != 0) {
+    LOG_DEBUG("I/O error while writing the free-page map");
+    return false;
+  }
+  maps->allocated_end_ = end;
+  return true;
+}
+
 /**
  * Private helper function to get disk file size
  */
@@ -0,0 +1,309 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_manager_compressed.cpp
+//
+// Identification: src/storage/disk/disk_manager_compressed.cpp
+//
+// Copyright (c) 2015-2020, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/disk_manager_compressed.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <mutex>  // NOLINT
+
+#include "common/exception.h"
+#include "common/logger.h"
+#include "common/lz4.h"
+
+namespace bustub {
+
+namespace {
+
+/** @return true iff all size bytes were written */
+bool PwriteAll(int fd, const char *data, size_t size, off_t offset) {
+  size_t written = 0;
+  while (written < size) {
+    ssize_t n = pwrite(fd, data + written, size - written, offset + static_cast<off_t>(written));
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    written += n;
+  }
+  return true;
+}
+
+/** @return true iff all size bytes were read */
+bool PreadAll(int fd, char *data, size_t size, off_t offset) {
+  size_t read_count = 0;
+  while (read_count < size) {
+    ssize_t n = pread(fd, data + read_count, size - read_count, offset + static_cast<off_t>(read_count));
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    read_count += n;
+  }
+  return true;
+}
+
+}  // namespace
+
+DiskManagerCompressed::DiskManagerCompressed(const std::string &db_file, size_t page_size, bool reopen)
+    : free_extents_(CheckPageSize(page_size) / SECTOR_SIZE + 1) {
+  page_size_ = page_size;
+  file_name_ = db_file;
+  // Maps left next to a missing database file belong to a database that is gone.
+  reopen = reopen && GetFileSize(db_file) >= 0;
+  OpenLogFile();
+  OpenDbFile(false);
+  map_name_ = file_name_.substr(0, file_name_.rfind('.')) + ".map";
+  // Without the page map, the extents in the database file are garbage that later writes simply overwrite.
+  map_fd_ = open(map_name_.c_str(), reopen ? O_RDWR | O_CREAT : O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (map_fd_ < 0) {
+    throw Exception("can't open page map file");
+  }
+  LoadPageMap();
+  // From here on the file size is the logical one, which decides which pages exist.
+  OpenPageMaps(&db_maps_, file_name_.substr(0, file_name_.rfind('.')), db_file_size_, reopen);
+}
+
+DiskManagerCompressed::~DiskManagerCompressed() {
+  StopBackgroundUsers();
+  if (map_fd_ >= 0) {
+    SyncPageMap();
+    close(map_fd_);
+  }
+}
+
+void DiskManagerCompressed::ShutDown() {
+  StopBackgroundUsers();
+  if (map_fd_ >= 0) {
+    SyncPageMap();
+    close(map_fd_);
+    map_fd_ = -1;
+  }
+  DiskManager::ShutDown();
+}
+
+void DiskManagerCompressed::WritePage(page_id_t page_id, const char *page_data) {
+  char buf[MAX_PAGE_SIZE];
+  auto [data, size] = Compress(page_data, buf);
+  num_writes_ += 1;
+  std::pair<page_id_t, const char *> page(page_id, page_data);
+  UpdateChecksums(&db_maps_, &page, 1);
+  std::pair<const char *, size_t> stored(data, size);
+  StoreExtents(&page, &stored, 1);
+  GrowFileSize((static_cast<int64_t>(page_id) + 1) * static_cast<int64_t>(page_size_));
+}
+
+void DiskManagerCompressed::ReadPage(page_id_t page_id, char *page_data) {
+  char buf[MAX_PAGE_SIZE];
+  Extent extent{};
+  bool read = false;
+  uint64_t reuse_epoch = 0;
+  do {
+    {
+      std::shared_lock<std::shared_mutex> latch(map_latch_);
+      extent = Extent{};
+      if (page_id >= 0 && static_cast<size_t>(page_id) < extents_.size()) {
+        extent = extents_[page_id];
+      }
+      reuse_epoch = reuse_epoch_;
+    }
+    if (extent.num_sectors_ == 0) {
+      LOG_DEBUG("I/O error reading past end of file");
+      memset(page_data, 0, page_size_);
+      return;
+    }
+    char *dst = extent.size_ == page_size_ ? page_data : buf;
+    read = PreadAll(db_fd_, dst, extent.size_, static_cast<off_t>(extent.sector_) * SECTOR_SIZE);
+    // The extent may be replaced during the read, but it is only reused after a sync; then the read starts over.
+    std::shared_lock<std::shared_mutex> latch(map_latch_);
+    if (reuse_epoch_ == reuse_epoch) {
+      break;
+    }
+  } while (true);
+  if (!read || (extent.size_ != page_size_ && !Lz4Decompress(buf, extent.size_, page_data, page_size_))) {
+    LOG_DEBUG("I/O error while reading compressed page %d", page_id);
+    memset(page_data, 0, page_size_);
+  }
+  VerifyChecksum(db_maps_, page_id, page_data);
+}
+
+void DiskManagerCompressed::WritePages(std::vector<std::pair<page_id_t, const char *>> pages) {
+  if (pages.empty()) {
+    return;
+  }
+  std::sort(pages.begin(), pages.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+  // Compress the whole batch before taking the latch.
+  std::vector<char> scratch(pages.size() * page_size_);
+  std::vector<std::pair<const char *, size_t>> stored;
+  stored.reserve(pages.size());
+  for (size_t i = 0; i < pages.size(); ++i) {
+    stored.push_back(Compress(pages[i].second, scratch.data() + i * page_size_));
+  }
+  num_writes_ += pages.size();
+  UpdateChecksums(&db_maps_, pages.data(), pages.size());
+  SyncChecksums(&db_maps_);
+  StoreExtents(pages.data(), stored.data(), pages.size());
+  GrowFileSize((static_cast<int64_t>(pages.back().first) + 1) * static_cast<int64_t>(page_size_));
+  SyncPageMap();
+}
+
+void DiskManagerCompressed::LoadPageMap() {
+  struct stat stat_buf;
+  // A partial trailing entry can only come from an interrupted write of a new page, whose data the map never pointed to.
+  size_t num_entries = fstat(map_fd_, &stat_buf) == 0 ? static_cast<size_t>(stat_buf.st_size) / sizeof(Extent) : 0;
+  extents_.assign(num_entries, Extent{});
+  if (num_entries > 0 && !PreadAll(map_fd_, reinterpret_cast<char *>(extents_.data()), num_entries * sizeof(Extent), 0)) {
+    LOG_DEBUG("I/O error while reading the page map");
+    extents_.assign(num_entries, Extent{});
+  }
+  db_file_size_ = static_cast<int64_t>(extents_.size() * page_size_);
+
+  // Every gap between live extents is free.
+  std::vector<std::pair<uint32_t, uint32_t>> live;
+  for (const auto &extent : extents_) {
+    if (extent.num_sectors_ > 0) {
+      live.emplace_back(extent.sector_, extent.sector_ + extent.num_sectors_);
+    }
+  }
+  std::sort(live.begin(), live.end());
+  uint32_t end = 0;
+  auto max_sectors = static_cast<uint32_t>(free_extents_.size() - 1);
+  for (const auto &[first, last] : live) {
+    while (first > end) {
+      uint32_t size = std::min(max_sectors, first - end);
+      free_extents_[size].push_back(end);
+      end += size;
+    }
+    end = std::max(end, last);
+  }
+  end_sector_ = end;
+}
+
+std::pair<const char *, size_t> DiskManagerCompressed::Compress(const char *page_data, char *buf) const {
+  // Compression that does not save a sector saves nothing on disk.
+  size_t size = Lz4Compress(page_data, page_size_, buf, page_size_ - SECTOR_SIZE);
+  if (size == 0) {
+    return {page_data, page_size_};
+  }
+  return {buf, size};
+}
+
+void DiskManagerCompressed::StoreExtents(const std::pair<page_id_t, const char *> *pages,
+                                         const std::pair<const char *, size_t> *stored, size_t count) {
+  // Every page goes to a fresh extent: the one the page map on disk points to stays intact until it points elsewhere.
+  std::vector<Extent> extents(count, Extent{});
+  {
+    std::scoped_lock<std::shared_mutex> latch(map_latch_);
+    for (size_t i = 0; i < count; ++i) {
+      auto num_sectors = static_cast<uint16_t>((stored[i].second + SECTOR_SIZE - 1) / SECTOR_SIZE);
+      extents[i] = Extent{AllocateExtentLocked(num_sectors), num_sectors, static_cast<uint16_t>(stored[i].second)};
+    }
+  }
+  // No reader knows the fresh extents yet, so they are written outside the latch.
+  std::vector<bool> written(count, false);
+  for (size_t i = 0; i < count; ++i) {
+    auto [data, size] = stored[i];
+    written[i] = PwriteAll(db_fd_, data, size, static_cast<off_t>(extents[i].sector_) * SECTOR_SIZE);
+    if (!written[i]) {
+      LOG_DEBUG("I/O error while writing");
+    }
+  }
+
+  std::scoped_lock<std::shared_mutex> latch(map_latch_);
+  for (size_t i = 0; i < count; ++i) {
+    const Extent &extent = extents[i];
+    if (!written[i]) {
+      free_extents_[extent.num_sectors_].push_back(extent.sector_);
+      continue;
+    }
+    page_id_t page_id = pages[i].first;
+    if (extents_.size() <= static_cast<size_t>(page_id)) {
+      extents_.resize(page_id + 1, Extent{});
+    }
+    if (extents_[page_id].num_sectors_ > 0) {
+      replaced_extents_.push_back(extents_[page_id]);
+    }
+    extents_[page_id] = extent;
+    dirty_pages_.insert(page_id);
+  }
+}
+
+void DiskManagerCompressed::SyncPageMap() {
+  std::scoped_lock<std::mutex> io_latch(map_io_latch_);
+  std::vector<std::pair<page_id_t, Extent>> entries;
+  std::vector<Extent> replaced;
+  {
+    // Every extent installed so far has been written, so the sync below covers it.
+    std::scoped_lock<std::shared_mutex> latch(map_latch_);
+    for (page_id_t page_id : dirty_pages_) {
+      entries.emplace_back(page_id, extents_[page_id]);
+    }
+    dirty_pages_.clear();
+    replaced.swap(replaced_extents_);
+  }
+  if (entries.empty() && replaced.empty()) {
+    return;
+  }
+
+  // The data must be on disk before a map entry points to it, and the map entries before the old extents are reused.
+  num_syncs_ += 1;
+  bool ok = fdatasync(db_fd_) == 0;
+  for (size_t i = 0; ok && i < entries.size(); ++i) {
+    const auto &[page_id, extent] = entries[i];
+    ok = PwriteAll(map_fd_, reinterpret_cast<const char *>(&extent), sizeof(Extent),
+                   static_cast<off_t>(page_id) * static_cast<off_t>(sizeof(Extent)));
+  }
+  ok = ok && fdatasync(map_fd_) == 0;
+
+  std::scoped_lock<std::shared_mutex> latch(map_latch_);
+  if (!ok) {
+    // The entries are written again by the next sync, and the extents they replaced stay in use until then.
+    LOG_DEBUG("I/O error while syncing the page map");
+    for (const auto &entry : entries) {
+      dirty_pages_.insert(entry.first);
+    }
+    replaced_extents_.insert(replaced_extents_.end(), replaced.begin(), replaced.end());
+    return;
+  }
+  for (const auto &extent : replaced) {
+    free_extents_[extent.num_sectors_].push_back(extent.sector_);
+  }
+  reuse_epoch_ += 1;
+}
+
+uint32_t DiskManagerCompressed::AllocateExtentLocked(uint16_t num_sectors) {
+  for (size_t size = num_sectors; size < free_extents_.size(); ++size) {
+    if (free_extents_[size].empty()) {
+      continue;
+    }
+    uint32_t sector = free_extents_[size].back();
+    free_extents_[size].pop_back();
+    if (size > num_sectors) {
+      free_extents_[size - num_sectors].push_back(sector + num_sectors);
+    }
+    return sector;
+  }
+  uint32_t sector = end_sector_;
+  end_sector_ += num_sectors;
+  return sector;
+}
+
+}  // namespace bustub
@@ -25,24 +25,36 @@ namespace bustub {
 /**
  * Constructor: used for memory based manager
  */
-DiskManagerMemory::DiskManagerMemory() { memory_ = new char[1 << 30]; }
+DiskManagerMemory::DiskManagerMemory(size_t page_size) {
+  page_size_ = CheckPageSize(page_size);
+  memory_ = new char[1 << 30];
+}
 
 /**
  * Write the contents of the specified page into disk file
  */
 void DiskManagerMemory::WritePage(page_id_t page_id, const char *page_data) {
-  size_t offset = static_cast<size_t>(page_id) * PAGE_SIZE;
+  size_t offset = static_cast<size_t>(page_id) * page_size_;
   // set write cursor to offset
   num_writes_ += 1;
-  memcpy(memory_ + offset, page_data, PAGE_SIZE);
+  memcpy(memory_ + offset, page_data, page_size_);
+}
+
+/**
+ * Write the contents of the specified pages into disk file
+ */
+void DiskManagerMemory::WritePages(std::vector<std::pair<page_id_t, const char *>> pages) {
+  for (const auto &[page_id, page_data] : pages) {
+    WritePage(page_id, page_data);
+  }
 }
 
 /**
  * Read the contents of the specified page into the given memory area
  */
 void DiskManagerMemory::ReadPage(page_id_t page_id, char *page_data) {
-  int offset = page_id * PAGE_SIZE;
-  memcpy(page_data, memory_ + offset, PAGE_SIZE);
+  size_t offset = static_cast<size_t>(page_id) * page_size_;
+  memcpy(page_data, memory_ + offset, page_size_);
 }
 
 }  // namespace bustub
@@ -0,0 +1,124 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_manager_mmap.cpp
+//
+// Identification: src/storage/disk/disk_manager_mmap.cpp
+//
+// Copyright (c) 2015-2020, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/disk_manager_mmap.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include "common/exception.h"
+#include "common/logger.h"
+
+namespace bustub {
+
+DiskManagerMmap::DiskManagerMmap(const std::string &db_file, size_t page_size, bool zero_copy) : zero_copy_(zero_copy) {
+  page_size_ = CheckPageSize(page_size);
+  file_name_ = db_file;
+  db_fd_ = open(db_file.c_str(), O_RDONLY);
+  if (db_fd_ < 0) {
+    throw Exception("can't open db file");
+  }
+  struct stat stat_buf;
+  if (fstat(db_fd_, &stat_buf) != 0) {
+    throw Exception("can't stat db file");
+  }
+  db_file_size_ = stat_buf.st_size;
+  db_maps_.next_page_no_ = static_cast<page_id_t>((stat_buf.st_size + page_size_ - 1) / page_size_);
+  // Replicas verify against the primary's checksum map if it shipped one.
+  size_t n = file_name_.rfind('.');
+  db_maps_.crc_name_ = file_name_.substr(0, n) + ".crc";
+  db_maps_.crc_fd_ = open(db_maps_.crc_name_.c_str(), O_RDONLY);
+  if (db_maps_.crc_fd_ >= 0) {
+    LoadChecksums(&db_maps_, db_file_size_);
+  }
+  // An empty file cannot be mapped, and has no pages to serve anyway.
+  if (stat_buf.st_size == 0) {
+    return;
+  }
+  mapping_size_ = stat_buf.st_size;
+  void *mapping = mmap(nullptr, mapping_size_, PROT_READ, MAP_SHARED, db_fd_, 0);
+  if (mapping == MAP_FAILED) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "can't map db file");
+  }
+  mapping_ = static_cast<char *>(mapping);
+}
+
+DiskManagerMmap::~DiskManagerMmap() {
+  StopBackgroundUsers();
+  if (mapping_ != nullptr) {
+    munmap(mapping_, mapping_size_);
+  }
+}
+
+void DiskManagerMmap::WritePage(page_id_t page_id, const char *page_data) {
+  throw Exception(ExceptionType::NOT_IMPLEMENTED, "cannot write to a memory-mapped, read-only db file");
+}
+
+void DiskManagerMmap::WritePages(std::vector<std::pair<page_id_t, const char *>> pages) {
+  if (pages.empty()) {
+    return;
+  }
+  throw Exception(ExceptionType::NOT_IMPLEMENTED, "cannot write to a memory-mapped, read-only db file");
+}
+
+void DiskManagerMmap::ReadPage(page_id_t page_id, char *page_data) {
+  const char *page = PageAt(page_id);
+  if (page == nullptr) {
+    LOG_DEBUG("I/O error reading past end of file");
+    memset(page_data, 0, page_size_);
+    return;
+  }
+  // The file may end before a whole page.
+  size_t size = std::min(page_size_, static_cast<size_t>(mapping_ + mapping_size_ - page));
+  memcpy(page_data, page, size);
+  memset(page_data + size, 0, page_size_ - size);
+  VerifyChecksum(db_maps_, page_id, page_data);
+}
+
+const char *DiskManagerMmap::GetMappedPage(page_id_t page_id) {
+  const char *page = PageAt(page_id);
+  // A partial page at the end of the file would let the reader run off the mapping.
+  if (!zero_copy_ || page == nullptr || page + page_size_ > mapping_ + mapping_size_) {
+    return nullptr;
+  }
+  VerifyChecksum(db_maps_, page_id, page);
+  return page;
+}
+
+void DiskManagerMmap::AdviseSequential(page_id_t page_id, size_t count) {
+  const char *page = PageAt(page_id);
+  if (page == nullptr) {
+    return;
+  }
+  // madvise works on whole OS pages; database pages are a multiple of them, so the start is aligned already.
+  size_t length = std::min(count * page_size_, static_cast<size_t>(mapping_ + mapping_size_ - page));
+  auto *start = const_cast<char *>(page);  // NOLINT
+  if (madvise(start, length, MADV_SEQUENTIAL) != 0 || madvise(start, length, MADV_WILLNEED) != 0) {
+    LOG_DEBUG("madvise failed on the db file mapping");
+  }
+}
+
+const char *DiskManagerMmap::PageAt(page_id_t page_id) const {
+  if (page_id < 0) {
+    return nullptr;
+  }
+  size_t offset = static_cast<size_t>(page_id) * page_size_;
+  return offset < mapping_size_ ? mapping_ + offset : nullptr;
+}
+
+}  // namespace bustub
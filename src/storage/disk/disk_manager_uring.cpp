@@ -0,0 +1,314 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_manager_uring.cpp
+//
+// Identification: src/storage/disk/disk_manager_uring.cpp
+//
+// Copyright (c) 2015-2020, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/disk_manager_uring.h"
+
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#ifdef __NR_io_uring_setup
+#define BUSTUB_HAS_IO_URING
+#endif
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+#include "common/logger.h"
+
+namespace bustub {
+
+DiskManagerUring::DiskManagerUring(const std::string &db_file, size_t page_size, bool direct_io, bool reopen,
+                                   unsigned queue_depth)
+    : DiskManager(db_file, page_size, direct_io, reopen) {
+  if (!SetUpRing(queue_depth)) {
+    LOG_INFO("io_uring is not available, falling back to synchronous page I/O");
+    return;
+  }
+  poll_thread_ = std::thread(&DiskManagerUring::PollLoop, this);
+}
+
+DiskManagerUring::~DiskManagerUring() {
+  StopBackgroundUsers();
+  if (ring_fd_ < 0) {
+    return;
+  }
+  {
+    std::unique_lock<std::mutex> latch(sq_latch_);
+    SubmitLocked();
+    slot_cv_.wait(latch, [&] { return in_flight_ == 0; });
+  }
+  Enqueue(nullptr);
+  SubmitAsync();
+  poll_thread_.join();
+  TearDownRing();
+}
+
+std::future<void> DiskManagerUring::WritePageAsync(page_id_t page_id, const char *page_data) {
+  // The kernel cannot do O_DIRECT from an unaligned buffer; the synchronous path bounces those. The ring only serves
+  // the database file, the synchronous path handles segment files.
+  if (ring_fd_ < 0 || (direct_io_ && reinterpret_cast<uintptr_t>(page_data) % DIRECT_IO_ALIGNMENT != 0) ||
+      GetFileId(page_id) != DB_FILE_ID) {
+    return DiskManager::WritePageAsync(page_id, page_data);
+  }
+  num_writes_ += 1;
+  std::pair<page_id_t, const char *> page(page_id, page_data);
+  UpdateChecksums(&db_maps_, &page, 1);
+  // The kernel only reads from the iovec of a write.
+  auto *request = new Request{page_id, true, {const_cast<char *>(page_data), page_size_}, {}};  // NOLINT
+  std::future<void> done = request->done_.get_future();
+  Enqueue(request);
+  return done;
+}
+
+std::future<void> DiskManagerUring::ReadPageAsync(page_id_t page_id, char *page_data) {
+  // Reads past the end of the file need no I/O at all.
+  auto offset = static_cast<int64_t>(page_id) * static_cast<int64_t>(page_size_);
+  if (ring_fd_ < 0 || (direct_io_ && reinterpret_cast<uintptr_t>(page_data) % DIRECT_IO_ALIGNMENT != 0) ||
+      GetFileId(page_id) != DB_FILE_ID || offset >= db_file_size_.load(std::memory_order_acquire)) {
+    return DiskManager::ReadPageAsync(page_id, page_data);
+  }
+  auto *request = new Request{page_id, false, {page_data, page_size_}, {}};
+  std::future<void> done = request->done_.get_future();
+  Enqueue(request);
+  return done;
+}
+
+void DiskManagerUring::SubmitAsync() {
+  if (ring_fd_ < 0) {
+    return;
+  }
+  std::scoped_lock<std::mutex> latch(sq_latch_);
+  SubmitLocked();
+}
+
+bool DiskManagerUring::Complete(Request *request, int result) {
+  // offset of what this completion transferred, and the whole page
+  auto offset = static_cast<int64_t>(request->page_id_) * static_cast<int64_t>(page_size_) +
+                static_cast<int64_t>(request->transferred_);
+  char *page_data = static_cast<char *>(request->iov_.iov_base) - request->transferred_;
+  size_t transferred = request->transferred_ + std::max(result, 0);
+  bool at_end = !request->is_write_ && offset + std::max(result, 0) >= db_file_size_.load(std::memory_order_acquire);
+  if (result < 0) {
+    LOG_DEBUG("I/O error while %s page %d: %s", request->is_write_ ? "writing" : "reading", request->page_id_,
+              strerror(-result));
+  } else if (transferred < page_size_ && result > 0 && !at_end) {
+    // A short transfer, e.g. after a signal: go on with the rest of the page.
+    request->transferred_ = transferred;
+    request->iov_.iov_base = page_data + transferred;
+    request->iov_.iov_len = page_size_ - transferred;
+    Resubmit(request);
+    return false;
+  } else if (request->is_write_) {
+    GrowFileSize(offset + result);
+    if (transferred < page_size_) {
+      LOG_DEBUG("I/O error while writing page %d: no progress", request->page_id_);
+    }
+  } else if (transferred < page_size_ && !at_end) {
+    LOG_DEBUG("I/O error while reading page %d: the file ended early", request->page_id_);
+  } else {
+    if (transferred < page_size_) {
+      // the file ends before a whole page
+      memset(page_data + transferred, 0, page_size_ - transferred);
+    }
+    VerifyChecksum(db_maps_, request->page_id_, page_data);
+  }
+  request->done_.set_value();
+  delete request;
+  return true;
+}
+
+#ifdef BUSTUB_HAS_IO_URING
+
+bool DiskManagerUring::SetUpRing(unsigned queue_depth) {
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  int fd = static_cast<int>(syscall(__NR_io_uring_setup, queue_depth, &params));
+  if (fd < 0) {
+    return false;
+  }
+  ring_fd_ = fd;
+
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap) {
+    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+  }
+  void *sq_ring = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  if (sq_ring == MAP_FAILED) {
+    TearDownRing();
+    return false;
+  }
+  sq_ring_ = sq_ring;
+  if (single_mmap) {
+    cq_ring_ = sq_ring_;
+  } else {
+    void *cq_ring =
+        mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    if (cq_ring == MAP_FAILED) {
+      TearDownRing();
+      return false;
+    }
+    cq_ring_ = cq_ring;
+  }
+  sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+  void *sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED) {
+    sqes_size_ = 0;
+    TearDownRing();
+    return false;
+  }
+  sqes_ = static_cast<io_uring_sqe *>(sqes);
+
+  auto *sq = static_cast<char *>(sq_ring_);
+  sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+  sq_mask_ = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+  sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+  auto *cq = static_cast<char *>(cq_ring_);
+  cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+  cq_mask_ = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+  cqes_ = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+  queue_depth_ = std::min(queue_depth, params.sq_entries);
+  return true;
+}
+
+void DiskManagerUring::TearDownRing() {
+  if (sqes_size_ > 0) {
+    munmap(sqes_, sqes_size_);
+  }
+  if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+    munmap(cq_ring_, cq_ring_size_);
+  }
+  if (sq_ring_ != nullptr) {
+    munmap(sq_ring_, sq_ring_size_);
+  }
+  close(ring_fd_);
+  ring_fd_ = -1;
+}
+
+void DiskManagerUring::Enqueue(Request *request) {
+  std::unique_lock<std::mutex> latch(sq_latch_);
+  if (request != nullptr) {
+    if (in_flight_ >= queue_depth_) {
+      // Whatever is still queued has to reach the kernel before a slot can free up.
+      SubmitLocked();
+      slot_cv_.wait(latch, [&] { return in_flight_ < queue_depth_; });
+    }
+    ++in_flight_;
+  }
+  QueueLocked(request);
+  if (++pending_ >= SUBMIT_BATCH) {
+    SubmitLocked();
+  }
+}
+
+void DiskManagerUring::QueueLocked(Request *request) {
+  unsigned tail = *sq_tail_;
+  unsigned index = tail & sq_mask_;
+  io_uring_sqe *sqe = &sqes_[index];
+  memset(sqe, 0, sizeof(*sqe));
+  if (request == nullptr) {
+    sqe->opcode = IORING_OP_NOP;
+  } else {
+    sqe->opcode = request->is_write_ ? IORING_OP_WRITEV : IORING_OP_READV;
+    sqe->fd = db_fd_;
+    sqe->off = static_cast<uint64_t>(request->page_id_) * page_size_ + request->transferred_;
+    sqe->addr = reinterpret_cast<uint64_t>(&request->iov_);
+    sqe->len = 1;
+  }
+  sqe->user_data = reinterpret_cast<uint64_t>(request);
+  sq_array_[index] = index;
+  // The kernel must see the entry before it sees the new tail.
+  __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+}
+
+void DiskManagerUring::Resubmit(Request *request) {
+  // Already counted in in_flight_, so there is no slot to wait for; the polling thread must not block anyway.
+  std::scoped_lock<std::mutex> latch(sq_latch_);
+  QueueLocked(request);
+  ++pending_;
+  SubmitLocked();
+}
+
+void DiskManagerUring::SubmitLocked() {
+  while (pending_ > 0) {
+    int submitted = static_cast<int>(syscall(__NR_io_uring_enter, ring_fd_, pending_, 0, 0, nullptr, 0));
+    if (submitted < 0 && (errno == EINTR || errno == EAGAIN || errno == EBUSY)) {
+      continue;
+    }
+    if (submitted <= 0) {
+      LOG_ERROR("io_uring submission failed: %s", strerror(errno));
+      return;
+    }
+    pending_ -= submitted;
+  }
+}
+
+void DiskManagerUring::PollLoop() {
+  bool stop = false;
+  while (!stop) {
+    int rc = static_cast<int>(syscall(__NR_io_uring_enter, ring_fd_, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0));
+    if (rc < 0 && errno != EINTR) {
+      LOG_ERROR("io_uring wait failed: %s", strerror(errno));
+    }
+    unsigned head = *cq_head_;
+    unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    unsigned completed = 0;
+    for (; head != tail; ++head) {
+      const io_uring_cqe &cqe = cqes_[head & cq_mask_];
+      auto *request = reinterpret_cast<Request *>(cqe.user_data);
+      if (request == nullptr) {
+        stop = true;
+        continue;
+      }
+      if (Complete(request, cqe.res)) {
+        ++completed;
+      }
+    }
+    // The kernel may reuse the entries once it sees the new head.
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    if (completed > 0) {
+      {
+        std::scoped_lock<std::mutex> latch(sq_latch_);
+        in_flight_ -= completed;
+      }
+      slot_cv_.notify_all();
+    }
+  }
+}
+
+#else
+
+bool DiskManagerUring::SetUpRing(unsigned queue_depth) { return false; }
+
+void DiskManagerUring::TearDownRing() {}
+
+void DiskManagerUring::Enqueue(Request *request) {}
+
+void DiskManagerUring::QueueLocked(Request *request) {}
+
+void DiskManagerUring::Resubmit(Request *request) {}
+
+void DiskManagerUring::SubmitLocked() {}
+
+void DiskManagerUring::PollLoop() {}
+
+#endif
+
+}  // namespace bustub
@@ -9,7 +9,9 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <string>
+#include <utility>
 
 #include "common/exception.h"
 #include "common/rid.h"
@@ -19,13 +21,15 @@
 namespace bustub {
 INDEX_TEMPLATE_ARGUMENTS
 BPLUSTREE_TYPE::BPlusTree(std::string name, BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
-                          int leaf_max_size, int internal_max_size)
+                          int leaf_max_size, int internal_max_size, file_id_t file_id)
     : index_name_(std::move(name)),
       root_page_id_(INVALID_PAGE_ID),
       buffer_pool_manager_(buffer_pool_manager),
       comparator_(comparator),
-      leaf_max_size_(leaf_max_size),
-      internal_max_size_(internal_max_size) {}
+      leaf_max_size_(leaf_max_size > 0 ? leaf_max_size : LeafPage::Capacity(buffer_pool_manager->GetPageSize())),
+      internal_max_size_(internal_max_size > 0 ? internal_max_size
+                                               : InternalPage::Capacity(buffer_pool_manager->GetPageSize())),
+      file_id_(file_id) {}
 
 /*
  * Helper function to decide whether current b+tree is empty
@@ -48,14 +52,11 @@ bool BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result
     return false;
   }
   ValueType value;
-  Page *page = FindLeafPage(key);
-  LeafPage *leaf = reinterpret_cast<LeafPage *>(page->GetData());
-  if (leaf->Lookup(key, &value, comparator_)) {
+  ReadPageGuard guard = FindLeafPageRead(key);
+  if (guard.IsValid() && guard.As<LeafPage>()->Lookup(key, &value, comparator_)) {
     result->emplace_back(std::move(value));
-    RUnlatchAndUnpin(page);
     return true;
   }
-  RUnlatchAndUnpin(page);
   return false;
 }
 
@@ -88,7 +89,7 @@ bool BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transact
  */
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value) {
-  Page *page = buffer_pool_manager_->NewPage(&root_page_id_);
+  Page *page = buffer_pool_manager_->NewPageInFile(file_id_, &root_page_id_);
   if (page == nullptr) {
     throw std::runtime_error("StartNewTree: out of memory");
   }
@@ -137,7 +138,7 @@ INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
 N *BPLUSTREE_TYPE::Split(N *node) {
   page_id_t page_id;
-  Page *page = buffer_pool_manager_->NewPage(&page_id);
+  Page *page = buffer_pool_manager_->NewPageInFile(file_id_, &page_id);
   if (page == nullptr) {
     throw std::runtime_error("Split: out of memory");
   }
@@ -171,7 +172,7 @@ INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node, const KeyType &key, BPlusTreePage *new_node,
                                       Transaction *transaction) {
   if (old_node->IsRootPage()) {
-    Page *page = buffer_pool_manager_->NewPage(&root_page_id_);
+    Page *page = buffer_pool_manager_->NewPageInFile(file_id_, &root_page_id_);
     if (page == nullptr) {
       throw std::runtime_error("Out Of Memory");
     }
@@ -253,27 +254,23 @@ bool BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction) {
   Page *parent_page = buffer_pool_manager_->FetchPage(node->GetParentPageId());
   InternalPage *parent = reinterpret_cast<InternalPage *>(parent_page->GetData());
   int index = parent->ValueIndex(node->GetPageId());
-  Page *sibling_page = FetchPageAndWLatch(parent->ValueAt(index == 0 ? 1 : index - 1));
-  N *sibling = reinterpret_cast<N *>(sibling_page->GetData());
+  WritePageGuard sibling_guard = FetchPageAndWLatch(parent->ValueAt(index == 0 ? 1 : index - 1));
+  N *sibling = sibling_guard.As<N>();
+  // Whichever way this goes, the sibling is modified.
+  sibling_guard.MarkDirty();
   if (node->IsLeafPage() && node->GetSize() + sibling->GetSize() >= node->GetMaxSize()) {  // Leaf Redistribute
     Redistribute(sibling, node, index);
     buffer_pool_manager_->UnpinPage(parent_page->GetPageId(), true);
-    sibling_page->WUnlatch();
-    buffer_pool_manager_->UnpinPage(sibling_page->GetPageId(), true);
     return false;
   }
   if (!node->IsLeafPage() && node->GetSize() + sibling->GetSize() > node->GetMaxSize()) {  // Internal Redistribute
     Redistribute(sibling, node, index);
     buffer_pool_manager_->UnpinPage(parent_page->GetPageId(), true);
-    sibling_page->WUnlatch();
-    buffer_pool_manager_->UnpinPage(sibling_page->GetPageId(), true);
     return false;
   }
   // If not able to redistribute, merge instead.
   Coalesce(&sibling, &node, &parent, index, transaction);
   buffer_pool_manager_->UnpinPage(parent_page->GetPageId(), true);
-  sibling_page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(sibling_page->GetPageId(), true);
   return true;
 }
 
@@ -392,7 +389,7 @@ bool BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) {
  */
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE BPLUSTREE_TYPE::begin() {
-  return INDEXITERATOR_TYPE(FindLeafPage(KeyType(), true), 0, buffer_pool_manager_);
+  return INDEXITERATOR_TYPE(FindLeafPageRead(KeyType(), true), 0, buffer_pool_manager_);
 }
 
 /*
@@ -402,9 +399,9 @@ INDEXITERATOR_TYPE BPLUSTREE_TYPE::begin() {
  */
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin(const KeyType &key) {
-  Page *page = FindLeafPage(key);
-  LeafPage *leaf = reinterpret_cast<LeafPage *>(page->GetData());
-  return INDEXITERATOR_TYPE(page, leaf->KeyIndex(key, comparator_), buffer_pool_manager_);
+  ReadPageGuard guard = FindLeafPageRead(key);
+  int index = guard.As<LeafPage>()->KeyIndex(key, comparator_);
+  return INDEXITERATOR_TYPE(std::move(guard), index, buffer_pool_manager_);
 }
 
 /*
@@ -414,14 +411,12 @@ INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin(const KeyType &key) {
  */
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE BPLUSTREE_TYPE::end() {
-  Page *page = FindLeafPage(KeyType(), true);
-  LeafPage *leaf = reinterpret_cast<LeafPage *>(page->GetData());
-  for (Page *next; leaf->GetNextPageId() != INVALID_PAGE_ID; page = next) {
-    next = FetchPageAndRLatch(leaf->GetNextPageId());
-    RUnlatchAndUnpin(page);
-    leaf = reinterpret_cast<LeafPage *>(next->GetData());
+  ReadPageGuard guard = FindLeafPageRead(KeyType(), true);
+  while (guard.As<LeafPage>()->GetNextPageId() != INVALID_PAGE_ID) {
+    guard = FetchPageAndRLatch(guard.As<LeafPage>()->GetNextPageId());
   }
-  return INDEXITERATOR_TYPE(page, leaf->GetSize(), buffer_pool_manager_);
+  int size = guard.As<LeafPage>()->GetSize();
+  return INDEXITERATOR_TYPE(std::move(guard), size, buffer_pool_manager_);
 }
 
 /*****************************************************************************
@@ -433,38 +428,115 @@ INDEXITERATOR_TYPE BPLUSTREE_TYPE::end() {
  */
 INDEX_TEMPLATE_ARGUMENTS
 Page *BPLUSTREE_TYPE::FindLeafPage(const KeyType &key, bool leftMost) {
+  // Assuming that root_latch_ has been held, and tree is not empty. The leaf is returned pinned and read-latched.
+  return FindLeafPageRead(key, leftMost).Detach();
+}
+
+/*
+ * Find the leaf page for key and read-latch it. Inner pages are first traversed optimistically, without latching
+ * them; if writers keep getting in the way, fall back to latch coupling. Returns an invalid guard if the tree was
+ * emptied in the meantime.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+ReadPageGuard BPLUSTREE_TYPE::FindLeafPageRead(const KeyType &key, bool leftMost) {
   // Assuming that root_latch_ has been held, and tree is not empty
-  Page *page = FetchPageAndRLatch(root_page_id_);
+  for (int attempt = 0; attempt < OPTIMISTIC_READ_ATTEMPTS; ++attempt) {
+    ReadPageGuard guard = FindLeafPageOptimistic(key, leftMost);
+    if (guard.IsValid()) {
+      return guard;
+    }
+    root_latch_.lock();
+    if (IsEmpty()) {
+      root_latch_.unlock();
+      return {};
+    }
+  }
+  ReadPageGuard guard = FetchPageAndRLatch(root_page_id_);
   root_latch_.unlock();
-  BPlusTreePage *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
-  for (Page *child; !node->IsLeafPage(); page = child) {
+  BPlusTreePage *node = guard.As<BPlusTreePage>();
+  while (!node->IsLeafPage()) {
     InternalPage *tmp = reinterpret_cast<InternalPage *>(node);
-    child = FetchPageAndRLatch(leftMost ? tmp->ValueAt(0) : tmp->Lookup(key, comparator_));
-    page->RUnlatch();
+    // The child is latched before the assignment releases its parent.
+    guard = FetchPageAndRLatch(leftMost ? tmp->ValueAt(0) : tmp->Lookup(key, comparator_));
+    node = guard.As<BPlusTreePage>();
+  }
+  return guard;
+}
+
+/*
+ * Optimistic lock coupling: read each inner page without latching it and validate its version before following the
+ * child pointer read from it, and again after the child's version has been read. Only the leaf is latched, and it
+ * is validated once latched. Returns an invalid guard, with nothing pinned, if a writer got in the way.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+ReadPageGuard BPLUSTREE_TYPE::FindLeafPageOptimistic(const KeyType &key, bool leftMost) {
+  // Assuming that root_latch_ has been held, and tree is not empty
+  Page *page = buffer_pool_manager_->FetchPage(root_page_id_);
+  if (page == nullptr) {
+    root_latch_.unlock();
+    throw std::runtime_error("Out Of Memory");
+  }
+  // The root's version is read before root_latch_ is released: a writer that replaces the root changes the old one
+  // too, so validating against this version also catches a root that stopped being the root in the meantime.
+  uint64_t version;
+  bool valid = page->ReadVersion(&version);
+  root_latch_.unlock();
+  while (valid) {
+    BPlusTreePage *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+    if (node->IsLeafPage()) {
+      page->RLatch();
+      if (page->ValidateVersion(version)) {
+        return {buffer_pool_manager_, page};
+      }
+      page->RUnlatch();
+      break;
+    }
+    InternalPage *internal = reinterpret_cast<InternalPage *>(node);
+    page_id_t child_id = internal->OptimisticLookup(key, comparator_, leftMost);
+    if (!page->ValidateVersion(version)) {
+      break;
+    }
+    Page *child = buffer_pool_manager_->FetchPage(child_id);
+    if (child == nullptr) {
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+      throw std::runtime_error("Out Of Memory");
+    }
+    uint64_t child_version;
+    valid = child->ReadVersion(&child_version);
+    // If the parent is unchanged, the child was still linked from it when we read the child's version.
+    if (!page->ValidateVersion(version)) {
+      buffer_pool_manager_->UnpinPage(child->GetPageId(), false);
+      break;
+    }
     buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
-    node = reinterpret_cast<BPlusTreePage *>(child->GetData());
+    page = child;
+    version = child_version;
   }
-  return page;
+  buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+  return {};
 }
 
 /* Concurrent Access Helper Functions */
 INDEX_TEMPLATE_ARGUMENTS
 Page *BPLUSTREE_TYPE::FindLeafPageWLatch(const KeyType &key, Transaction *transaction, Operation operation) {
-  // Assuming that root_latch_ has been held, and tree is not empty
-  Page *page = FetchPageAndWLatch(root_page_id_);
-  BPlusTreePage *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  // Assuming that root_latch_ has been held, and tree is not empty. Every page that stays latched is handed over to
+  // the transaction's page set, which WUnlatchAndUnpin releases.
+  WritePageGuard guard = FetchPageAndWLatch(root_page_id_);
+  BPlusTreePage *node = guard.As<BPlusTreePage>();
   while (!node->IsLeafPage()) {
     InternalPage *tmp = reinterpret_cast<InternalPage *>(node);
     if (node->IsSafe(operation)) {
       WUnlatchAndUnpin(transaction, false);
     }
-    transaction->AddIntoPageSet(page);
-    page = FetchPageAndWLatch(tmp->Lookup(key, comparator_));
-    node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+    WritePageGuard child = FetchPageAndWLatch(tmp->Lookup(key, comparator_));
+    transaction->AddIntoPageSet(guard.Detach());
+    guard = std::move(child);
+    node = guard.As<BPlusTreePage>();
   }
   if (node->IsSafe(operation)) {
     WUnlatchAndUnpin(transaction, false);
   }
+  Page *page = guard.Detach();
   transaction->AddIntoPageSet(page);
   return page;
 }
@@ -485,37 +557,34 @@ void BPLUSTREE_TYPE::WUnlatchAndUnpin(Transaction *transaction, bool is_dirty) {
 
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::DeletePages(Transaction *transaction) {
+  // The pages are unlinked from the tree, but an optimistic reader, or a writer that fetched one before it was
+  // unlinked and is waiting for its latch, may still have it pinned. Such a page cannot be deleted yet, so it is kept
+  // for the next call rather than leaked.
   auto &page_ids = *transaction->GetDeletedPageSet();
-  for (const auto &page_id : page_ids) {
-    buffer_pool_manager_->DeletePage(page_id);
-  }
+  std::scoped_lock<std::mutex> latch(pending_deletes_latch_);
+  pending_deletes_.insert(pending_deletes_.end(), page_ids.begin(), page_ids.end());
   page_ids.clear();
+  auto deleted = std::remove_if(pending_deletes_.begin(), pending_deletes_.end(),
+                                [&](page_id_t page_id) { return buffer_pool_manager_->DeletePage(page_id); });
+  pending_deletes_.erase(deleted, pending_deletes_.end());
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-Page *BPLUSTREE_TYPE::FetchPageAndWLatch(const page_id_t &page_id) {
-  Page *page = buffer_pool_manager_->FetchPage(page_id);
-  if (page == nullptr) {
+WritePageGuard BPLUSTREE_TYPE::FetchPageAndWLatch(const page_id_t &page_id) {
+  WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(page_id);
+  if (!guard.IsValid()) {
     throw std::runtime_error("Out Of Memory");
   }
-  page->WLatch();
-  return page;
+  return guard;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-Page *BPLUSTREE_TYPE::FetchPageAndRLatch(const page_id_t &page_id) {
-  Page *page = buffer_pool_manager_->FetchPage(page_id);
-  if (page == nullptr) {
+ReadPageGuard BPLUSTREE_TYPE::FetchPageAndRLatch(const page_id_t &page_id) {
+  ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(page_id);
+  if (!guard.IsValid()) {
     throw std::runtime_error("Out Of Memory");
   }
-  page->RLatch();
-  return page;
-}
-
-INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::RUnlatchAndUnpin(Page *page) {
-  page->RUnlatch();
-  buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+  return guard;
 }
 
 /*
@@ -2,6 +2,7 @@
  * index_iterator.cpp
  */
 #include <cassert>
+#include <utility>
 
 #include "storage/index/index_iterator.h"
 
@@ -15,16 +16,14 @@ INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE::IndexIterator() = default;
 
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE::IndexIterator(Page *page, int index, BufferPoolManager *bpm)
-    : page_(page), index_(index), bpm_(bpm) {
-  leaf_ = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
+INDEXITERATOR_TYPE::IndexIterator(ReadPageGuard guard, int index, BufferPoolManager *bpm)
+    : guard_(std::move(guard)), index_(index), bpm_(bpm) {
+  leaf_ = guard_.As<B_PLUS_TREE_LEAF_PAGE_TYPE>();
+  ReadAhead();
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE::~IndexIterator() {
-  page_->RUnlatch();
-  bpm_->UnpinPage(leaf_->GetPageId(), false);
-}
+INDEXITERATOR_TYPE::~IndexIterator() = default;
 
 INDEX_TEMPLATE_ARGUMENTS
 bool INDEXITERATOR_TYPE::isEnd() { return leaf_->GetNextPageId() == INVALID_PAGE_ID && index_ == leaf_->GetSize(); }
@@ -35,17 +34,32 @@ const MappingType &INDEXITERATOR_TYPE::operator*() { return leaf_->GetItem(index
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE &INDEXITERATOR_TYPE::operator++() {
   if (++index_ == leaf_->GetSize() && leaf_->GetNextPageId() != INVALID_PAGE_ID) {
-    Page *next_page = bpm_->FetchPage(leaf_->GetNextPageId());
-    next_page->RLatch();
-    page_->RUnlatch();
-    bpm_->UnpinPage(page_->GetPageId(), false);
-    page_ = next_page;
-    leaf_ = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page_->GetData());
+    // The next leaf is latched before the current one is released.
+    guard_ = bpm_->FetchPageRead(leaf_->GetNextPageId());
+    leaf_ = guard_.As<B_PLUS_TREE_LEAF_PAGE_TYPE>();
     index_ = 0;
+    ReadAhead();
   }
   return *this;
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::ReadAhead() {
+  if (read_ahead_countdown_ > 0 && --read_ahead_countdown_ > 0) {
+    return;
+  }
+  size_t window = read_ahead_window;
+  if (window > 0 && leaf_->GetNextPageId() != INVALID_PAGE_ID) {
+    bpm_->PrefetchRange(leaf_->GetNextPageId(), window, &INDEXITERATOR_TYPE::NextLeafPageId);
+    read_ahead_countdown_ = window;
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+page_id_t INDEXITERATOR_TYPE::NextLeafPageId(const char *page_data) {
+  return reinterpret_cast<const B_PLUS_TREE_LEAF_PAGE_TYPE *>(page_data)->GetNextPageId();
+}
+
 template class IndexIterator<GenericKey<4>, RID, GenericComparator<4>>;
 
 template class IndexIterator<GenericKey<8>, RID, GenericComparator<8>>;
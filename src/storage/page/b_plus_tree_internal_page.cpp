@@ -9,6 +9,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 
@@ -99,6 +100,31 @@ ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::Lookup(const KeyType &key, const KeyCo
   return comparator(KeyAt(lo), key) > 0 ? ValueAt(lo - 1) : ValueAt(lo);
 }
 
+/*
+ * Same as Lookup (or ValueAt(0) when leftMost), for a reader that does not hold the page latch and validates the
+ * page version afterwards. A concurrent writer may change the page under us, so the size is read once and clamped
+ * to the max size, and no index is asserted; the result is meaningless unless the version validates.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::OptimisticLookup(const KeyType &key, const KeyComparator &comparator,
+                                                           bool leftMost) const {
+  int size = std::clamp(GetSize(), 1, std::max(GetMaxSize(), 1));
+  if (leftMost || size == 1) {
+    return array[0].second;
+  }
+  int lo = 1;
+  int hi = size - 1;
+  while (lo < hi) {
+    int mid = (hi - lo) / 2 + lo;
+    if (comparator(array[mid].first, key) > 0) {
+      hi = mid;
+    } else {
+      lo = mid + 1;
+    }
+  }
+  return comparator(array[lo].first, key) > 0 ? array[lo - 1].second : array[lo].second;
+}
+
 /*****************************************************************************
  * INSERTION
  *****************************************************************************/
@@ -25,8 +25,8 @@ bool HeaderPage::InsertRecord(const std::string &name, const page_id_t root_id)
 
   int record_num = GetRecordCount();
   int offset = 4 + record_num * 36;
-  // check for duplicate name
-  if (FindRecord(name) != -1) {
+  // check for duplicate name, and that the record fits into the page
+  if (FindRecord(name) != -1 || static_cast<size_t>(offset + 36) > GetPageSize()) {
     return false;
   }
   // copy record content
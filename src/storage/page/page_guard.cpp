@@ -0,0 +1,72 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_guard.cpp
+//
+// Identification: src/storage/page/page_guard.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/page_guard.h"
+
+#include <utility>
+
+#include "buffer/buffer_pool_manager.h"
+
+namespace bustub {
+
+ReadPageGuard::ReadPageGuard(ReadPageGuard &&that) noexcept
+    : bpm_(that.bpm_), page_(std::exchange(that.page_, nullptr)) {}
+
+ReadPageGuard &ReadPageGuard::operator=(ReadPageGuard &&that) noexcept {
+  if (this != &that) {
+    Drop();
+    bpm_ = that.bpm_;
+    page_ = std::exchange(that.page_, nullptr);
+  }
+  return *this;
+}
+
+void ReadPageGuard::Drop() {
+  if (page_ == nullptr) {
+    return;
+  }
+  page_->RUnlatch();
+  bpm_->UnpinPage(page_->GetPageId(), false);
+  page_ = nullptr;
+}
+
+Page *ReadPageGuard::Detach() { return std::exchange(page_, nullptr); }
+
+WritePageGuard::WritePageGuard(WritePageGuard &&that) noexcept
+    : bpm_(that.bpm_), page_(std::exchange(that.page_, nullptr)), is_dirty_(std::exchange(that.is_dirty_, false)) {}
+
+WritePageGuard &WritePageGuard::operator=(WritePageGuard &&that) noexcept {
+  if (this != &that) {
+    Drop();
+    bpm_ = that.bpm_;
+    page_ = std::exchange(that.page_, nullptr);
+    is_dirty_ = std::exchange(that.is_dirty_, false);
+  }
+  return *this;
+}
+
+void WritePageGuard::Drop() {
+  if (page_ == nullptr) {
+    return;
+  }
+  page_->WUnlatch();
+  bpm_->UnpinPage(page_->GetPageId(), is_dirty_);
+  page_ = nullptr;
+  is_dirty_ = false;
+}
+
+Page *WritePageGuard::Detach() {
+  is_dirty_ = false;
+  return std::exchange(page_, nullptr);
+}
+
+}  // namespace bustub
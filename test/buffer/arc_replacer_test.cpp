@@ -0,0 +1,135 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// arc_replacer_test.cpp
+//
+// Identification: test/buffer/arc_replacer_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <vector>
+
+#include "buffer/arc_replacer.h"
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+
+namespace bustub {
+
+/** Loads a page into a frame the way the buffer pool does: the access is recorded while pinned, then unpinned. */
+static void Load(ARCReplacer *replacer, frame_id_t frame_id, page_id_t page_id) {
+  replacer->RecordPageAccess(frame_id, page_id);
+  replacer->Unpin(frame_id);
+}
+
+/** Hits a resident page: pin, record the access, unpin. */
+static void Hit(ARCReplacer *replacer, frame_id_t frame_id, page_id_t page_id) {
+  replacer->RecordPageAccess(frame_id, page_id);
+  replacer->Pin(frame_id);
+  replacer->Unpin(frame_id);
+}
+
+TEST(ARCReplacerTest, SampleTest) {
+  ARCReplacer arc_replacer(3);
+  int value;
+
+  // Scenario: pages seen once sit on T1 and go in LRU order.
+  Load(&arc_replacer, 0, 10);
+  Load(&arc_replacer, 1, 11);
+  Load(&arc_replacer, 2, 12);
+  EXPECT_EQ(3, arc_replacer.Size());
+  ASSERT_TRUE(arc_replacer.Victim(&value));
+  EXPECT_EQ(0, value);
+  EXPECT_EQ(0, arc_replacer.GetTargetT1Size());
+
+  // Scenario: page 10 comes back while it is still a B1 ghost, so T1 should have been bigger, and the page goes to T2.
+  Load(&arc_replacer, 0, 10);
+  EXPECT_EQ(1, arc_replacer.GetTargetT1Size());
+  ASSERT_TRUE(arc_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+
+  // Scenario: with T1 at its target, victims come from T2; a page evicted from T2 that comes back shrinks T1 again.
+  Hit(&arc_replacer, 2, 12);
+  ASSERT_TRUE(arc_replacer.Victim(&value));
+  EXPECT_EQ(0, value);
+  Load(&arc_replacer, 0, 10);
+  EXPECT_EQ(0, arc_replacer.GetTargetT1Size());
+
+  // Scenario: pinned frames are skipped, and the peeked order is the order Victim hands them out.
+  Load(&arc_replacer, 1, 13);
+  arc_replacer.Pin(2);
+  EXPECT_EQ(2, arc_replacer.Size());
+  std::vector<frame_id_t> victims;
+  arc_replacer.PeekVictims(3, &victims);
+  EXPECT_EQ((std::vector<frame_id_t>{1, 0}), victims);
+  for (frame_id_t expected : victims) {
+    ASSERT_TRUE(arc_replacer.Victim(&value));
+    EXPECT_EQ(expected, value);
+  }
+  EXPECT_FALSE(arc_replacer.Victim(&value));
+  arc_replacer.Remove(2);
+  EXPECT_EQ(0, arc_replacer.Size());
+}
+
+TEST(ARCReplacerTest, ScanResistanceTest) {
+  ARCReplacer arc_replacer(4);
+  int value;
+
+  // Scenario: pages 0 and 1 are hot, i.e. on T2.
+  Load(&arc_replacer, 0, 0);
+  Load(&arc_replacer, 1, 1);
+  Hit(&arc_replacer, 0, 0);
+  Hit(&arc_replacer, 1, 1);
+  Load(&arc_replacer, 2, 100);
+  Load(&arc_replacer, 3, 101);
+
+  // Scenario: a long scan only ever recycles the frames of other scanned pages.
+  for (page_id_t page_id = 102; page_id < 200; ++page_id) {
+    ASSERT_TRUE(arc_replacer.Victim(&value));
+    EXPECT_TRUE(value == 2 || value == 3);
+    Load(&arc_replacer, value, page_id);
+  }
+  Hit(&arc_replacer, 0, 0);
+  Hit(&arc_replacer, 1, 1);
+  EXPECT_EQ(0, arc_replacer.GetTargetT1Size());
+}
+
+TEST(ARCReplacerTest, BufferPoolTest) {
+  const size_t buffer_pool_size = 3;
+  auto *disk_manager = new DiskManagerMemory();
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, nullptr, ReplacerType::ARC);
+
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id_temp);
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+  }
+
+  // Scenario: page 0 is used twice, so pages seen once are evicted before it.
+  ASSERT_NE(nullptr, bpm->FetchPage(0));
+  EXPECT_TRUE(bpm->UnpinPage(0, false));
+  for (int i = 0; i < 5; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, false));
+  }
+  bool page0_resident = false;
+  for (const FrameState &frame : bpm->GetFrameStates()) {
+    page0_resident = page0_resident || frame.page_id_ == 0;
+  }
+  EXPECT_TRUE(page0_resident);
+  auto *page = bpm->FetchPage(1);
+  ASSERT_NE(nullptr, page);
+  EXPECT_STREQ("page 1", page->GetData());
+  EXPECT_TRUE(bpm->UnpinPage(1, false));
+
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
@@ -11,10 +11,23 @@
 //===----------------------------------------------------------------------===//
 
 #include "buffer/buffer_pool_manager.h"
+#include <atomic>
+#include <chrono>  // NOLINT
 #include <cstdio>
+#include <cstring>
+#include <future>  // NOLINT
+#include <memory>
 #include <random>
+#include <sstream>
 #include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+#include "common/exception.h"
 #include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/disk/disk_manager_mmap.h"
+#include "storage/disk/disk_manager_uring.h"
 
 namespace bustub {
 
@@ -79,7 +92,7 @@ TEST(BufferPoolManagerTest, BinaryDataTest) {
 
   // Shutdown the disk manager and remove the temporary file we created.
   disk_manager->ShutDown();
-  remove("test.db");
+  DiskManager::RemoveFiles("test.db");
 
   delete bpm;
   delete disk_manager;
@@ -135,7 +148,747 @@ TEST(BufferPoolManagerTest, SampleTest) {
 
   // Shutdown the disk manager and remove the temporary file we created.
   disk_manager->ShutDown();
-  remove("test.db");
+  DiskManager::RemoveFiles("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// Concurrent hits on resident pages must keep pin counts exact and never let a pinned page be evicted
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, ConcurrentHitTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+  const int num_threads = 8;
+  const int num_rounds = 1000;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "%d", page_id_temp);
+  }
+  // Keep page 0 pinned for the whole run, unpin everything else.
+  for (page_id_t page_id = 1; page_id < static_cast<page_id_t>(buffer_pool_size); ++page_id) {
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([bpm, tid, buffer_pool_size]() {
+      for (int round = 0; round < num_rounds; ++round) {
+        page_id_t page_id = (tid + round) % buffer_pool_size;
+        auto *page = bpm->FetchPage(page_id);
+        ASSERT_NE(nullptr, page);
+        EXPECT_EQ(std::to_string(page_id), std::string(page->GetData()));
+        EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  // Scenario: only page 0 is still pinned, so exactly buffer_pool_size - 1 new pages fit.
+  auto *page0 = bpm->FetchPage(0);
+  ASSERT_NE(nullptr, page0);
+  EXPECT_EQ(2, page0->GetPinCount());
+  for (size_t i = 1; i < buffer_pool_size; ++i) {
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  }
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+
+  disk_manager->ShutDown();
+  DiskManager::RemoveFiles("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+// A scan with an access strategy must only recycle the frames of its own ring
+TEST(BufferPoolManagerTest, ScanRingTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+  const size_t ring_size = 2;
+  const page_id_t num_pages = 50;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  page_id_t page_id_temp;
+  for (page_id_t i = 0; i < num_pages; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, false));
+  }
+  // Scenario: pages 0..7 are the hot set, loaded through the shared pool.
+  const page_id_t num_hot = buffer_pool_size - ring_size;
+  for (page_id_t page_id = 0; page_id < num_hot; ++page_id) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "hot %d", page_id);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: scanning every other page through a ring of two frames leaves the hot set alone.
+  auto writes = disk_manager->GetNumWrites();
+  BufferAccessStrategy strategy(ring_size);
+  for (page_id_t page_id = num_hot; page_id < num_pages; ++page_id) {
+    ASSERT_NE(nullptr, bpm->FetchPageWithStrategy(page_id, &strategy));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  for (page_id_t page_id = 0; page_id < num_hot; ++page_id) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("hot " + std::to_string(page_id), std::string(page->GetData()));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  // None of the dirty hot pages was evicted, so nothing had to be written back.
+  EXPECT_EQ(writes, disk_manager->GetNumWrites());
+
+  // Scenario: a pinned ring page is never recycled; the scan falls back to the shared pool instead.
+  BufferAccessStrategy pinned_strategy(1);
+  auto *pinned = bpm->FetchPageWithStrategy(num_hot, &pinned_strategy);
+  ASSERT_NE(nullptr, pinned);
+  ASSERT_NE(nullptr, bpm->FetchPageWithStrategy(num_hot + 1, &pinned_strategy));
+  EXPECT_EQ(num_hot, pinned->GetPageId());
+  EXPECT_TRUE(bpm->UnpinPage(num_hot, false));
+  EXPECT_TRUE(bpm->UnpinPage(num_hot + 1, false));
+
+  disk_manager->ShutDown();
+  DiskManager::RemoveFiles("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, PageSizeTest) {
+  const size_t page_size = 16384;
+  const size_t buffer_pool_size = 3;
+
+  EXPECT_THROW(DiskManagerMemory(PAGE_SIZE + 1), Exception);
+  auto *disk_manager = new DiskManagerMemory(page_size);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  EXPECT_EQ(page_size, bpm->GetPageSize());
+
+  // Scenario: every byte of a large page survives eviction and a re-read.
+  page_id_t page_id_temp;
+  auto *page0 = bpm->NewPage(&page_id_temp);
+  ASSERT_NE(nullptr, page0);
+  EXPECT_EQ(page_size, page0->GetPageSize());
+  for (size_t i = 0; i < page_size; ++i) {
+    page0->GetData()[i] = static_cast<char>(i % 251);
+  }
+  EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, false));
+  }
+  page0 = bpm->FetchPage(0);
+  ASSERT_NE(nullptr, page0);
+  for (size_t i = 0; i < page_size; ++i) {
+    ASSERT_EQ(static_cast<char>(i % 251), page0->GetData()[i]);
+  }
+  EXPECT_TRUE(bpm->UnpinPage(0, false));
+
+  delete bpm;
+  delete disk_manager;
+}
+
+/** A disk manager that counts the pages read from disk, and the pages written by the thread that created it. */
+class CountingDiskManager : public DiskManager {
+ public:
+  explicit CountingDiskManager(const std::string &db_file)
+      : DiskManager(db_file), owner_(std::this_thread::get_id()) {}
+
+  void ReadPage(page_id_t page_id, char *page_data) override {
+    DiskManager::ReadPage(page_id, page_data);
+    num_reads_ += 1;
+  }
+
+  void WritePage(page_id_t page_id, const char *page_data) override {
+    DiskManager::WritePage(page_id, page_data);
+    if (std::this_thread::get_id() == owner_) {
+      num_owner_writes_ += 1;
+    }
+  }
+
+  int GetNumReads() const { return num_reads_; }
+
+  int GetNumOwnerWrites() const { return num_owner_writes_; }
+
+ private:
+  std::thread::id owner_;
+  std::atomic<int> num_reads_{0};
+  std::atomic<int> num_owner_writes_{0};
+};
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, PrefetchTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+  const page_id_t num_pages = 20;
+  // Every page stores the id of its successor here, like the chain of a table heap.
+  constexpr size_t next_offset = 12;
+  const size_t data_offset = 16;
+  BufferPoolManager::next_page_fn next_page = [](const char *page_data) {
+    page_id_t next_page_id;
+    memcpy(&next_page_id, page_data + next_offset, sizeof(page_id_t));
+    return next_page_id;
+  };
+
+  auto *disk_manager = new CountingDiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  // Scenario: the even pages form a chain 0 -> 2 -> ... -> 18. Only pages 10..19 stay resident.
+  page_id_t page_id_temp;
+  for (page_id_t i = 0; i < num_pages; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    page_id_t next_page_id = i + 2 < num_pages ? i + 2 : INVALID_PAGE_ID;
+    memcpy(page->GetData() + next_offset, &next_page_id, sizeof(page_id_t));
+    snprintf(page->GetData() + data_offset, PAGE_SIZE - data_offset, "page %d", i);
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+  }
+  EXPECT_EQ(0, disk_manager->GetNumReads());
+
+  // Scenario: reading ahead four pages of the chain happens in the background.
+  bpm->PrefetchRange(0, 4, next_page);
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (disk_manager->GetNumReads() < 4 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  ASSERT_EQ(4, disk_manager->GetNumReads());
+
+  // Scenario: fetching the prefetched pages does not go to disk, but anything off the chain does.
+  for (page_id_t page_id = 0; page_id < 8; page_id += 2) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(page_id), std::string(page->GetData() + data_offset));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(4, disk_manager->GetNumReads());
+  ASSERT_NE(nullptr, bpm->FetchPage(1));
+  EXPECT_TRUE(bpm->UnpinPage(1, false));
+  EXPECT_EQ(5, disk_manager->GetNumReads());
+
+  disk_manager->ShutDown();
+  DiskManager::RemoveFiles("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, DiskManagerFirstTest) {
+  const size_t buffer_pool_size = 10;
+  auto *disk_manager = new DiskManagerMemory();
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size * 4; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+  }
+
+  // Scenario: the disk manager goes away while read-ahead is still running. It stops the prefetcher before it does,
+  // and the pool can still be destroyed afterwards.
+  bpm->PrefetchRange(0, buffer_pool_size * 4);
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, AsyncPrefetchTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+  const page_id_t num_pages = 20;
+  const size_t data_offset = 16;
+
+  auto *disk_manager = new DiskManagerUring(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  page_id_t page_id_temp;
+  for (page_id_t i = 0; i < num_pages; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData() + data_offset, PAGE_SIZE - data_offset, "page %d", i);
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+  }
+
+  // Scenario: a consecutive range is read ahead with all its reads in flight at once.
+  bpm->PrefetchRange(0, 8);
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (bpm->GetStats().reads_ < 8 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  ASSERT_EQ(8U, bpm->GetStats().reads_);
+
+  // Scenario: the prefetched pages are served from the pool and hold what was written.
+  for (page_id_t page_id = 0; page_id < 8; ++page_id) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(page_id), std::string(page->GetData() + data_offset));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(8U, bpm->GetStats().reads_);
+
+  delete bpm;
+  disk_manager->ShutDown();
+  DiskManager::RemoveFiles("test.db");
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, FlushAllPagesTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id_temp);
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+  }
+
+  // Scenario: all the dirty pages go out as one batch, with one sync.
+  int writes = disk_manager->GetNumWrites();
+  bpm->FlushAllPages();
+  EXPECT_EQ(writes + static_cast<int>(buffer_pool_size), disk_manager->GetNumWrites());
+  EXPECT_EQ(1, disk_manager->GetNumSyncs());
+  char data[PAGE_SIZE];
+  for (page_id_t page_id = 0; page_id < static_cast<page_id_t>(buffer_pool_size); ++page_id) {
+    disk_manager->ReadPage(page_id, data);
+    EXPECT_EQ("page " + std::to_string(page_id), std::string(data));
+  }
+
+  // Scenario: with nothing dirty, there is nothing to sync.
+  bpm->FlushAllPages();
+  EXPECT_EQ(1, disk_manager->GetNumSyncs());
+
+  // Scenario: a flush waits for the latch of a page that is being updated without holding up the rest of the pool,
+  // and writes the page as it is once the update is done.
+  auto *page = bpm->FetchPage(0);
+  ASSERT_NE(nullptr, page);
+  EXPECT_TRUE(bpm->UnpinPage(0, true));
+  ASSERT_EQ(page, bpm->FetchPage(0));
+  page->WLatch();
+  auto flush = std::async(std::launch::async, [&] { bpm->FlushAllPages(); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  auto *new_page = bpm->NewPage(&page_id_temp);
+  ASSERT_NE(nullptr, new_page);
+  EXPECT_TRUE(bpm->UnpinPage(page_id_temp, false));
+  snprintf(page->GetData(), PAGE_SIZE, "page 0 updated");
+  page->WUnlatch();
+  EXPECT_TRUE(bpm->UnpinPage(0, true));
+  flush.get();
+  disk_manager->ReadPage(0, data);
+  EXPECT_EQ("page 0 updated", std::string(data));
+
+  delete bpm;
+  disk_manager->ShutDown();
+  DiskManager::RemoveFiles("test.db");
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, ZeroCopyMmapTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 4;
+  const page_id_t num_pages = 10;
+
+  auto *disk_manager = new DiskManager(db_name);
+  char data[PAGE_SIZE] = {0};
+  for (page_id_t i = 0; i < num_pages; ++i) {
+    snprintf(data, sizeof(data), "page %d", i);
+    disk_manager->WritePage(i, data);
+  }
+  disk_manager->ShutDown();
+  delete disk_manager;
+
+  // Scenario: fetched pages alias the mapping, also once their frames have held other pages.
+  auto *mapped = new DiskManagerMmap(db_name, PAGE_SIZE, true);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, mapped);
+  for (page_id_t i = 0; i < num_pages; ++i) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(mapped->GetMappedPage(i), page->GetData());
+    EXPECT_EQ("page " + std::to_string(i), std::string(page->GetData()));
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+  std::vector<Page *> pages;
+  bpm->FetchPages({0, 1, 2}, &pages);
+  for (page_id_t i = 0; i < 3; ++i) {
+    ASSERT_NE(nullptr, pages[i]);
+    EXPECT_EQ(mapped->GetMappedPage(i), pages[i]->GetData());
+  }
+  EXPECT_TRUE(bpm->UnpinPages({0, 1, 2}, false));
+
+  delete bpm;
+  mapped->ShutDown();
+  delete mapped;
+  DiskManager::RemoveFiles("test.db");
+}
+
+class BackgroundWriterTest : public ::testing::Test {
+ protected:
+  // This function is called before every test.
+  void SetUp() override {
+    low_watermark_ = bg_writer_low_watermark;
+    high_watermark_ = bg_writer_high_watermark;
+    bg_writer_low_watermark = 0.5;
+    bg_writer_high_watermark = 0.5;
+  }
+
+  // This function is called after every test.
+  void TearDown() override {
+    bg_writer_low_watermark = low_watermark_;
+    bg_writer_high_watermark = high_watermark_;
+    DiskManager::RemoveFiles("test.db");
+  }
+
+  double low_watermark_;
+  double high_watermark_;
+};
+
+// NOLINTNEXTLINE
+TEST_F(BackgroundWriterTest, CleanVictimsTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+
+  auto disk_manager = std::make_unique<CountingDiskManager>(db_name);
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get());
+
+  // Scenario: once the pool fills up with dirty pages, the writer cleans the five next in line for eviction.
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+  }
+  auto background_writes = [&] { return disk_manager->GetNumWrites() - disk_manager->GetNumOwnerWrites(); };
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (background_writes() < 5 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  ASSERT_EQ(5, background_writes());
+
+  // Scenario: evicting them does not make this thread write anything beyond the new pages themselves.
+  auto owner_writes = disk_manager->GetNumOwnerWrites();
+  for (int i = 0; i < 5; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  }
+  EXPECT_EQ(owner_writes + 5, disk_manager->GetNumOwnerWrites());
+
+  bpm.reset();
+  disk_manager->ShutDown();
+}
+
+/** A disk manager whose reads of one page block until the test lets them through. */
+class GatedDiskManager : public DiskManager {
+ public:
+  GatedDiskManager(const std::string &db_file, page_id_t gated_page_id)
+      : DiskManager(db_file), gated_page_id_(gated_page_id), gate_(open_.get_future().share()) {}
+
+  void ReadPage(page_id_t page_id, char *page_data) override {
+    if (page_id == gated_page_id_) {
+      read_started_ = true;
+      gate_.wait();
+    }
+    DiskManager::ReadPage(page_id, page_data);
+  }
+
+  bool ReadStarted() const { return read_started_; }
+
+  void Open() { open_.set_value(); }
+
+ private:
+  page_id_t gated_page_id_;
+  std::promise<void> open_;
+  std::shared_future<void> gate_;
+  std::atomic<bool> read_started_{false};
+};
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, IOOutsideLatchTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+  const page_id_t slow_page_id = 0;
+
+  auto *disk_manager = new GatedDiskManager(db_name, slow_page_id);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  // Pages 1..10 are resident and dirty; page 0 has been written back and evicted.
+  page_id_t page_id_temp;
+  for (page_id_t i = 0; i <= static_cast<page_id_t>(buffer_pool_size); ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+  }
+
+  // Scenario: a fetch of page 0 is stuck reading from disk.
+  auto slow_fetch = std::async(std::launch::async, [&] { return bpm->FetchPage(slow_page_id); });
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (!disk_manager->ReadStarted() && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  ASSERT_TRUE(disk_manager->ReadStarted());
+
+  // Scenario: meanwhile, hits and misses on other pages go through, and page 1 comes back as it was written.
+  auto other_fetches = std::async(std::launch::async, [&] {
+    Page *hit = bpm->FetchPage(5);
+    Page *miss = bpm->FetchPage(1);
+    return std::make_pair(hit, miss);
+  });
+  bool other_fetches_done = other_fetches.wait_for(std::chrono::seconds(10)) == std::future_status::ready;
+  EXPECT_TRUE(other_fetches_done);
+
+  // Scenario: a second fetch of page 0 waits for the first one's read instead of reading it again.
+  auto waiting_fetch = std::async(std::launch::async, [&] { return bpm->FetchPage(slow_page_id); });
+  EXPECT_EQ(std::future_status::timeout, waiting_fetch.wait_for(std::chrono::milliseconds(50)));
+
+  disk_manager->Open();
+  Page *slow_page = slow_fetch.get();
+  ASSERT_NE(nullptr, slow_page);
+  EXPECT_EQ(slow_page, waiting_fetch.get());
+  EXPECT_EQ("page 0", std::string(slow_page->GetData()));
+  EXPECT_TRUE(bpm->UnpinPage(slow_page_id, false));
+  EXPECT_TRUE(bpm->UnpinPage(slow_page_id, false));
+  if (other_fetches_done) {
+    auto [hit, miss] = other_fetches.get();
+    ASSERT_NE(nullptr, hit);
+    ASSERT_NE(nullptr, miss);
+    EXPECT_EQ("page 5", std::string(hit->GetData()));
+    EXPECT_EQ("page 1", std::string(miss->GetData()));
+    EXPECT_TRUE(bpm->UnpinPage(5, false));
+    EXPECT_TRUE(bpm->UnpinPage(1, false));
+  }
+
+  disk_manager->ShutDown();
+  DiskManager::RemoveFiles("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, WarmRestartTest) {
+  const std::string db_name = "test.db";
+  const std::string dump_name = "test.bpdump";
+  const size_t buffer_pool_size = 5;
+  remove(dump_name.c_str());
+
+  auto *disk_manager = new CountingDiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  page_id_t page_id_temp;
+  for (page_id_t i = 0; i < 10; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+  }
+  // Scenario: after these fetches the resident pages are 9, 7, 3, 8, 2, from least to most recently used.
+  for (page_id_t page_id : {7, 3, 8, 2}) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(0, bpm->LoadResidentPages(dump_name));
+  ASSERT_TRUE(bpm->DumpResidentPages(dump_name));
+  bpm->FlushAllPages();
+  delete bpm;
+
+  // Scenario: a restarted pool gets the same pages back without any further reads.
+  bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  int num_reads = disk_manager->GetNumReads();
+  EXPECT_EQ(5, bpm->LoadResidentPages(dump_name));
+  EXPECT_EQ(num_reads + 5, disk_manager->GetNumReads());
+  num_reads = disk_manager->GetNumReads();
+  // Scenario: the replacer order survives the restart, so the next miss evicts page 9.
+  ASSERT_NE(nullptr, bpm->FetchPage(0));
+  EXPECT_TRUE(bpm->UnpinPage(0, false));
+  for (page_id_t page_id : {7, 3, 8, 2}) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(page_id), std::string(page->GetData()));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(num_reads + 1, disk_manager->GetNumReads());
+  ASSERT_NE(nullptr, bpm->FetchPage(9));
+  EXPECT_TRUE(bpm->UnpinPage(9, false));
+  EXPECT_EQ(num_reads + 2, disk_manager->GetNumReads());
+  delete bpm;
+
+  // Scenario: a smaller pool keeps only the hottest pages of the dump.
+  bpm = new BufferPoolManager(3, disk_manager);
+  EXPECT_EQ(3, bpm->LoadResidentPages(dump_name));
+  num_reads = disk_manager->GetNumReads();
+  for (page_id_t page_id : {3, 8, 2}) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(num_reads, disk_manager->GetNumReads());
+
+  // Scenario: the id of a page that was loaded from the dump is given back while the page is still pinned. A new page
+  // does not take the id over until the stale copy is unpinned.
+  auto *stale = bpm->FetchPage(2);
+  ASSERT_NE(nullptr, stale);
+  disk_manager->DeallocatePage(2);
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_NE(2, page_id_temp);
+  EXPECT_TRUE(bpm->UnpinPage(page_id_temp, false));
+  EXPECT_EQ("page 2", std::string(stale->GetData()));
+  EXPECT_TRUE(bpm->UnpinPage(2, false));
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(2, page_id_temp);
+  EXPECT_TRUE(bpm->UnpinPage(page_id_temp, false));
+
+  disk_manager->ShutDown();
+  DiskManager::RemoveFiles("test.db");
+  remove(dump_name.c_str());
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, BatchFetchTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 5;
+
+  auto *disk_manager = new CountingDiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  page_id_t page_id_temp;
+  for (page_id_t i = 0; i < 8; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+  }
+
+  // Scenario: a batch mixes hits (6, 7) with misses (0, 1), some of which evict dirty pages. Repeated ids are pinned
+  // once per occurrence, and only the misses are read.
+  int num_reads = disk_manager->GetNumReads();
+  std::vector<page_id_t> page_ids{7, 1, 6, 0, 1};
+  std::vector<Page *> pages;
+  bpm->FetchPages(page_ids, &pages);
+  ASSERT_EQ(page_ids.size(), pages.size());
+  for (size_t i = 0; i < page_ids.size(); ++i) {
+    ASSERT_NE(nullptr, pages[i]);
+    EXPECT_EQ(page_ids[i], pages[i]->GetPageId());
+    EXPECT_EQ("page " + std::to_string(page_ids[i]), std::string(pages[i]->GetData()));
+  }
+  EXPECT_EQ(pages[1], pages[4]);
+  EXPECT_EQ(2, pages[1]->GetPinCount());
+  EXPECT_EQ(num_reads + 2, disk_manager->GetNumReads());
+
+  // Scenario: pages that do not fit while the rest of the batch is pinned come back as nullptr.
+  std::vector<Page *> more_pages;
+  bpm->FetchPages({2, 3, 4}, &more_pages);
+  ASSERT_EQ(3, more_pages.size());
+  EXPECT_NE(nullptr, more_pages[0]);
+  EXPECT_EQ(nullptr, more_pages[1]);
+  EXPECT_EQ(nullptr, more_pages[2]);
+  EXPECT_TRUE(bpm->UnpinPages({2}, false));
+
+  // Scenario: a batch unpin releases every pin, and reports pages that were not pinned.
+  EXPECT_TRUE(bpm->UnpinPages(page_ids, false));
+  EXPECT_EQ(0, pages[1]->GetPinCount());
+  EXPECT_FALSE(bpm->UnpinPages({0, 3}, false));
+
+  disk_manager->ShutDown();
+  DiskManager::RemoveFiles("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, MetricsTest) {
+  const size_t buffer_pool_size = 3;
+
+  auto *disk_manager = new DiskManagerMemory();
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  }
+  EXPECT_TRUE(bpm->UnpinPage(0, true));
+  EXPECT_TRUE(bpm->UnpinPage(1, false));
+
+  // Scenario: the frame states show the pin that was never released, and the order the unpinned pages go in.
+  std::vector<FrameState> frames = bpm->GetFrameStates();
+  ASSERT_EQ(buffer_pool_size, frames.size());
+  for (const FrameState &frame : frames) {
+    EXPECT_EQ(frame.page_id_, bpm->GetPages()[frame.frame_id_].GetPageId());
+    EXPECT_EQ(frame.page_id_ == 2 ? 1 : 0, frame.pin_count_);
+    EXPECT_EQ(frame.page_id_ == 0, frame.is_dirty_);
+    EXPECT_EQ(frame.page_id_ == 2 ? -1 : frame.page_id_, frame.replacer_position_);
+  }
+  std::ostringstream dump;
+  bpm->DumpFrameStates(dump);
+  EXPECT_NE(std::string::npos, dump.str().find("frame\tpage\tpins"));
+
+  // Scenario: a hit, a new page that evicts the clean page 1, a miss that evicts the dirty page 0, and a flush.
+  ASSERT_NE(nullptr, bpm->FetchPage(0));
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_TRUE(bpm->UnpinPage(0, false));
+  EXPECT_TRUE(bpm->UnpinPage(page_id_temp, false));
+  ASSERT_NE(nullptr, bpm->FetchPage(1));
+  EXPECT_TRUE(bpm->FlushPage(1));
+  BufferPoolStats stats = bpm->GetStats();
+  EXPECT_EQ(1, stats.hits_);
+  EXPECT_EQ(1, stats.misses_);
+  EXPECT_EQ(2, stats.evictions_);
+  EXPECT_EQ(1, stats.dirty_evictions_);
+  EXPECT_EQ(1, stats.flushes_);
+  EXPECT_EQ(1, stats.reads_);
+  EXPECT_EQ(6, stats.writes_);
+  EXPECT_DOUBLE_EQ(0.5, stats.HitRatio());
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, DeletePageTest) {
+  const size_t buffer_pool_size = 3;
+
+  auto *disk_manager = new DiskManagerMemory();
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  }
+
+  // Scenario: a pinned page cannot be deleted, and its id is not given back to the disk manager.
+  EXPECT_FALSE(bpm->DeletePage(1));
+  EXPECT_EQ(0, disk_manager->GetNumFreePages());
+
+  // Scenario: a deleted page frees its frame and its id, and the next new page reuses both.
+  EXPECT_TRUE(bpm->UnpinPage(1, true));
+  EXPECT_TRUE(bpm->DeletePage(1));
+  EXPECT_EQ(1, disk_manager->GetNumFreePages());
+  auto *page = bpm->NewPage(&page_id_temp);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(1, page_id_temp);
+  EXPECT_EQ(0, page->GetData()[0]);
+
+  // Scenario: a page that is not resident can be deleted too.
+  EXPECT_TRUE(bpm->UnpinPage(0, false));
+  EXPECT_TRUE(bpm->UnpinPage(1, false));
+  EXPECT_TRUE(bpm->UnpinPage(2, false));
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, false));
+  }
+  EXPECT_TRUE(bpm->DeletePage(0));
+  EXPECT_EQ(0, disk_manager->AllocatePage());
 
   delete bpm;
   delete disk_manager;
@@ -14,12 +14,14 @@
 #include <thread>  // NOLINT
 #include <vector>
 
+#include "buffer/buffer_pool_manager.h"
 #include "buffer/clock_replacer.h"
 #include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
 
 namespace bustub {
 
-TEST(ClockReplacerTest, DISABLED_SampleTest) {
+TEST(ClockReplacerTest, SampleTest) {
   ClockReplacer clock_replacer(7);
 
   // Scenario: unpin six elements, i.e. add them to the replacer.
@@ -59,4 +61,87 @@ TEST(ClockReplacerTest, DISABLED_SampleTest) {
   EXPECT_EQ(4, value);
 }
 
+TEST(ClockReplacerTest, PeekVictimsTest) {
+  ClockReplacer clock_replacer(5);
+  for (frame_id_t frame_id = 0; frame_id < 5; ++frame_id) {
+    clock_replacer.Unpin(frame_id);
+  }
+  int value;
+  ASSERT_TRUE(clock_replacer.Victim(&value));
+  EXPECT_EQ(0, value);
+
+  // Scenario: the sweep cleared every reference bit; touching 2 again gives it a second chance.
+  clock_replacer.Pin(2);
+  clock_replacer.Unpin(2);
+  std::vector<frame_id_t> victims;
+  clock_replacer.PeekVictims(5, &victims);
+  EXPECT_EQ((std::vector<frame_id_t>{1, 3, 4, 2}), victims);
+  for (frame_id_t expected : victims) {
+    ASSERT_TRUE(clock_replacer.Victim(&value));
+    EXPECT_EQ(expected, value);
+  }
+  EXPECT_FALSE(clock_replacer.Victim(&value));
+  EXPECT_EQ(0, clock_replacer.Size());
+}
+
+TEST(ClockReplacerTest, ConcurrencyTest) {
+  const size_t num_frames = 64;
+  const int num_threads = 4;
+  const int rounds = 10000;
+  ClockReplacer clock_replacer(num_frames);
+
+  // Scenario: threads pin and unpin their own frames while sharing the clock; every frame ends up unpinned.
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([&clock_replacer, tid]() {
+      for (int i = 0; i < rounds; ++i) {
+        auto frame_id = static_cast<frame_id_t>(tid + num_threads * (i % (num_frames / num_threads)));
+        clock_replacer.Pin(frame_id);
+        clock_replacer.Unpin(frame_id);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(num_frames, clock_replacer.Size());
+
+  // Scenario: each frame is handed out as a victim exactly once.
+  std::vector<bool> seen(num_frames, false);
+  int value;
+  for (size_t i = 0; i < num_frames; ++i) {
+    ASSERT_TRUE(clock_replacer.Victim(&value));
+    EXPECT_FALSE(seen[value]);
+    seen[value] = true;
+  }
+  EXPECT_FALSE(clock_replacer.Victim(&value));
+}
+
+TEST(ClockReplacerTest, BufferPoolTest) {
+  const size_t buffer_pool_size = 3;
+  auto *disk_manager = new DiskManagerMemory();
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, nullptr, ReplacerType::CLOCK);
+
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id_temp);
+  }
+
+  // Scenario: with every frame pinned nothing can be evicted; once one is unpinned, it is the victim.
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_TRUE(bpm->UnpinPage(1, true));
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_TRUE(bpm->UnpinPage(page_id_temp, false));
+  EXPECT_TRUE(bpm->UnpinPage(0, false));
+  auto *page = bpm->FetchPage(1);
+  ASSERT_NE(nullptr, page);
+  EXPECT_STREQ("page 1", page->GetData());
+  EXPECT_TRUE(bpm->UnpinPage(1, false));
+
+  delete bpm;
+  delete disk_manager;
+}
+
 }  // namespace bustub
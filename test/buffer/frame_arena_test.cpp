@@ -0,0 +1,79 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena_test.cpp
+//
+// Identification: test/buffer/frame_arena_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdint>
+#include <cstring>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/frame_arena.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(FrameArenaTest, SampleTest) {
+  // Scenario: a small arena hands out zeroed frames aligned to their size.
+  {
+    FrameArena arena(10, 16384);
+    for (size_t i = 0; i < 10; ++i) {
+      char *frame = arena.GetFrame(i);
+      EXPECT_EQ(0, reinterpret_cast<uintptr_t>(frame) % 16384);
+      EXPECT_EQ(0, frame[0]);
+      EXPECT_EQ(0, frame[16383]);
+      memset(frame, static_cast<int>(i), 16384);
+    }
+    for (size_t i = 0; i < 10; ++i) {
+      EXPECT_EQ(static_cast<char>(i), arena.GetFrame(i)[16383]);
+    }
+  }
+
+  // Scenario: a large arena starts on a huge page boundary, whether or not huge pages are available.
+  {
+    const size_t num_frames = 1000;
+    FrameArena arena(num_frames, PAGE_SIZE);
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(arena.GetFrame(0)) % FrameArena::HUGE_PAGE_SIZE);
+    memset(arena.GetFrame(0), 1, num_frames * PAGE_SIZE);
+    EXPECT_EQ(1, arena.GetFrame(num_frames - 1)[PAGE_SIZE - 1]);
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(FrameArenaTest, BufferPoolFramesTest) {
+  const size_t buffer_pool_size = 10;
+  const size_t page_size = 16384;
+  auto *disk_manager = new DiskManagerMemory(page_size);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  // Scenario: every large page's data is page-aligned, and the frames are laid out back to back.
+  Page *pages = bpm->GetPages();
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(pages[i].GetData()) % page_size);
+    EXPECT_EQ(pages[0].GetData() + i * page_size, pages[i].GetData());
+  }
+  delete bpm;
+  delete disk_manager;
+
+  // Scenario: pages of the default size are kept in the arena too, apart from their descriptors.
+  disk_manager = new DiskManagerMemory();
+  bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  pages = bpm->GetPages();
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(pages[i].GetData()) % PAGE_SIZE);
+    EXPECT_EQ(pages[0].GetData() + i * PAGE_SIZE, pages[i].GetData());
+  }
+  EXPECT_LT(sizeof(Page), PAGE_SIZE);
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
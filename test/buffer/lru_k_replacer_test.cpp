@@ -0,0 +1,174 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer_test.cpp
+//
+// Identification: test/buffer/lru_k_replacer_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/lru_k_replacer.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+TEST(LRUKReplacerTest, SampleTest) {
+  LRUKReplacer lru_k_replacer(7, 2);
+
+  // Scenario: frames 1..5 are accessed once, frame 1 is accessed a second time.
+  for (frame_id_t frame_id = 1; frame_id <= 5; ++frame_id) {
+    lru_k_replacer.RecordAccess(frame_id);
+    lru_k_replacer.Unpin(frame_id);
+  }
+  lru_k_replacer.RecordAccess(1);
+  lru_k_replacer.Pin(1);
+  lru_k_replacer.Unpin(1);
+  EXPECT_EQ(5, lru_k_replacer.Size());
+
+  // Scenario: frames with fewer than k accesses go first, oldest first access first.
+  int value;
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(2, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(3, value);
+
+  // Scenario: pinned frames are never victims.
+  lru_k_replacer.Pin(4);
+  EXPECT_EQ(2, lru_k_replacer.Size());
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(5, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+  EXPECT_FALSE(lru_k_replacer.Victim(&value));
+
+  // Scenario: a frame with k accesses outlives frames with a larger backward k-distance.
+  lru_k_replacer.Unpin(4);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(4, value);
+  EXPECT_EQ(0, lru_k_replacer.Size());
+}
+
+TEST(LRUKReplacerTest, CorrelatedReferenceTest) {
+  const uint64_t correlated_period = 4;
+  LRUKReplacer lru_k_replacer(7, 2, correlated_period);
+
+  // Scenario: frame 2 is pinned, and stays pinned while frame 1 is hit many times in a burst. The burst is correlated
+  // and counts as one access.
+  lru_k_replacer.RecordAccess(2);
+  lru_k_replacer.Pin(2);
+  for (uint64_t i = 0; i < 2 * correlated_period; ++i) {
+    lru_k_replacer.RecordAccess(1);
+    lru_k_replacer.Pin(1);
+  }
+  lru_k_replacer.Unpin(1);
+
+  // Scenario: frame 2 is referenced again, still pinned but long after its first access. Being pinned does not make
+  // the access correlated.
+  lru_k_replacer.RecordAccess(2);
+  lru_k_replacer.Pin(2);
+  lru_k_replacer.Unpin(2);
+  lru_k_replacer.RecordAccess(3);
+  lru_k_replacer.Unpin(3);
+
+  // Frames 1 and 3 only have one uncorrelated access each, so they go before frame 2, which has two.
+  int value;
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(3, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(2, value);
+  EXPECT_FALSE(lru_k_replacer.Victim(&value));
+}
+
+TEST(LRUKReplacerTest, ConcurrentAccessTest) {
+  const frame_id_t num_frames = 8;
+  LRUKReplacer lru_k_replacer(num_frames, 2);
+  for (frame_id_t frame_id = 0; frame_id < num_frames; ++frame_id) {
+    lru_k_replacer.RecordAccess(frame_id);
+    lru_k_replacer.Unpin(frame_id);
+  }
+
+  // Scenario: frames 0..3 are hit from many threads while evictable, without going through Pin.
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < 4; ++tid) {
+    threads.emplace_back([&lru_k_replacer]() {
+      for (int i = 0; i < 1000; ++i) {
+        lru_k_replacer.RecordAccess(i % 4);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(8U, lru_k_replacer.Size());
+
+  // The frames that were only referenced once still go first, in the order they were referenced.
+  int value;
+  for (frame_id_t frame_id = 4; frame_id < num_frames; ++frame_id) {
+    ASSERT_TRUE(lru_k_replacer.Victim(&value));
+    EXPECT_EQ(frame_id, value);
+  }
+  std::vector<bool> evicted(4, false);
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_TRUE(lru_k_replacer.Victim(&value));
+    ASSERT_LT(value, 4);
+    EXPECT_FALSE(evicted[value]);
+    evicted[value] = true;
+  }
+  EXPECT_FALSE(lru_k_replacer.Victim(&value));
+}
+
+TEST(LRUKReplacerTest, ScanResistanceTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, nullptr, ReplacerType::LRU_K);
+
+  // Scenario: pages 0..4 form a hot set that is referenced twice.
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size / 2; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "hot %d", page_id_temp);
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+  }
+  for (page_id_t page_id = 0; page_id < static_cast<page_id_t>(buffer_pool_size / 2); ++page_id) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+
+  // Scenario: a scan much larger than the pool only recycles the frames it brought in itself. Each new page is
+  // written once on creation; evicting a dirty hot page would show up as an extra write.
+  const int scan_size = 100;
+  auto writes = disk_manager->GetNumWrites();
+  for (int i = 0; i < scan_size; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, false));
+  }
+  EXPECT_EQ(writes + scan_size, disk_manager->GetNumWrites());
+  for (page_id_t page_id = 0; page_id < static_cast<page_id_t>(buffer_pool_size / 2); ++page_id) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("hot " + std::to_string(page_id), std::string(page->GetData()));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  remove("test.log");
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
@@ -0,0 +1,236 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_buffer_pool_manager_test.cpp
+//
+// Identification: test/buffer/parallel_buffer_pool_manager_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/parallel_buffer_pool_manager.h"
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, SampleTest) {
+  const std::string db_name = "test.db";
+  const size_t num_instances = 5;
+  const size_t pool_size = 2;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, pool_size, disk_manager);
+  EXPECT_EQ(num_instances * pool_size, bpm->GetPoolSize());
+
+  // Scenario: we should be able to create new pages until every instance is full.
+  std::vector<page_id_t> page_ids;
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < num_instances * pool_size; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id_temp);
+    page_ids.push_back(page_id_temp);
+  }
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+
+  // Scenario: after unpinning every page, all of them can be evicted and read back from disk.
+  for (auto page_id : page_ids) {
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  for (size_t i = 0; i < num_instances * pool_size; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, false));
+  }
+  for (auto page_id : page_ids) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(page_id), std::string(page->GetData()));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+    EXPECT_TRUE(bpm->DeletePage(page_id));
+  }
+
+  disk_manager->ShutDown();
+  DiskManager::RemoveFiles("test.db");
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, BatchFetchTest) {
+  const size_t num_instances = 3;
+  const size_t pool_size = 4;
+
+  auto *disk_manager = new DiskManagerMemory();
+  auto *bpm = new ParallelBufferPoolManager(num_instances, pool_size, disk_manager);
+  page_id_t page_id_temp;
+  for (page_id_t i = 0; i < 6; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id_temp);
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+  }
+
+  // Scenario: a batch that spans every instance comes back in the requested order.
+  std::vector<page_id_t> page_ids{5, 0, 4, 1, 3, 2};
+  std::vector<Page *> pages;
+  bpm->FetchPages(page_ids, &pages);
+  ASSERT_EQ(page_ids.size(), pages.size());
+  for (size_t i = 0; i < page_ids.size(); ++i) {
+    ASSERT_NE(nullptr, pages[i]);
+    EXPECT_EQ("page " + std::to_string(page_ids[i]), std::string(pages[i]->GetData()));
+  }
+  EXPECT_TRUE(bpm->UnpinPages(page_ids, false));
+  EXPECT_FALSE(bpm->UnpinPages({0}, false));
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, RejectedPageIdTest) {
+  const std::string db_name = "test.db";
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(2, 1, disk_manager);
+
+  page_id_t page_id_0;
+  page_id_t page_id_1;
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id_0));
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id_1));
+  EXPECT_EQ(0, page_id_0);
+  EXPECT_EQ(1, page_id_1);
+
+  // Scenario: page 2 belongs to the full instance 0, so page 3 is handed out instead and page 2 is given back.
+  EXPECT_TRUE(bpm->UnpinPage(page_id_1, false));
+  page_id_t page_id_temp;
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(3, page_id_temp);
+  EXPECT_EQ(1U, disk_manager->GetNumFreePages());
+
+  // Scenario: once instance 0 has room again, the rejected id is the next one to be used.
+  EXPECT_TRUE(bpm->UnpinPage(page_id_0, false));
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(2, page_id_temp);
+  EXPECT_EQ(0U, disk_manager->GetNumFreePages());
+
+  disk_manager->ShutDown();
+  DiskManager::RemoveFiles(db_name);
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, ConcurrencyTest) {
+  const int num_threads = 8;
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new ParallelBufferPoolManager(4, 20, disk_manager);
+
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([bpm]() {
+      page_id_t temp_page_id;
+      std::vector<page_id_t> page_ids;
+      for (int i = 0; i < 5; i++) {
+        auto *new_page = bpm->NewPage(&temp_page_id);
+        ASSERT_NE(nullptr, new_page);
+        strcpy(new_page->GetData(), std::to_string(temp_page_id).c_str());  // NOLINT
+        page_ids.push_back(temp_page_id);
+      }
+      for (auto page_id : page_ids) {
+        EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+      }
+      for (auto page_id : page_ids) {
+        auto *page = bpm->FetchPage(page_id);
+        ASSERT_NE(nullptr, page);
+        EXPECT_EQ(0, std::strcmp(std::to_string(page_id).c_str(), page->GetData()));
+        EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+      }
+      for (auto page_id : page_ids) {
+        EXPECT_TRUE(bpm->DeletePage(page_id));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  DiskManager::RemoveFiles("test.db");
+  delete bpm;
+  delete disk_manager;
+}
+
+/*
+ * Scaling benchmark: every thread fetches and unpins pages from a shared working set that fits in the pool, so the
+ * measured cost is dominated by buffer pool latching. Prints the throughput of a single BufferPoolManager and of a
+ * ParallelBufferPoolManager for 1 to 64 threads.
+ */
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, DISABLED_ScalingBenchmark) {
+  const size_t num_instances = 16;
+  const size_t total_pool_size = 4096;
+  const size_t num_pages = 2048;
+  const size_t ops_per_thread = 50000;
+
+  auto run = [&](BufferPoolManager *bpm, size_t num_threads) {
+    std::vector<page_id_t> page_ids;
+    page_id_t temp_page_id;
+    for (size_t i = 0; i < num_pages; i++) {
+      bpm->NewPage(&temp_page_id);
+      bpm->UnpinPage(temp_page_id, false);
+      page_ids.push_back(temp_page_id);
+    }
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<std::thread> threads;
+    for (size_t tid = 0; tid < num_threads; tid++) {
+      threads.emplace_back([&, tid]() {
+        std::default_random_engine rng(tid);
+        std::uniform_int_distribution<size_t> dist(0, num_pages - 1);
+        for (size_t i = 0; i < ops_per_thread; i++) {
+          page_id_t page_id = page_ids[dist(rng)];
+          bpm->FetchPage(page_id);
+          bpm->UnpinPage(page_id, false);
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    auto seconds = std::chrono::duration<double>(end - start).count();
+    return static_cast<double>(num_threads * ops_per_thread) / seconds;
+  };
+
+  for (size_t num_threads = 1; num_threads <= 64; num_threads *= 2) {
+    auto *disk_manager = new DiskManagerMemory();
+    auto *single = new BufferPoolManager(total_pool_size, disk_manager);
+    double single_ops = run(single, num_threads);
+    delete single;
+    delete disk_manager;
+
+    disk_manager = new DiskManagerMemory();
+    auto *parallel = new ParallelBufferPoolManager(num_instances, total_pool_size / num_instances, disk_manager);
+    double parallel_ops = run(parallel, num_threads);
+    delete parallel;
+    delete disk_manager;
+
+    std::cout << "[BENCHMARK: ParallelBufferPoolManagerTest] threads=" << num_threads
+              << " single=" << static_cast<uint64_t>(single_ops) << " ops/s"
+              << " parallel=" << static_cast<uint64_t>(parallel_ops) << " ops/s" << std::endl;
+  }
+}
+
+}  // namespace bustub
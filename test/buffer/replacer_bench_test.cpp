@@ -0,0 +1,174 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// replacer_bench_test.cpp
+//
+// Identification: test/buffer/replacer_bench_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/arc_replacer.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_k_replacer.h"
+#include "buffer/lru_replacer.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+/** Draws page ids from a Zipfian distribution: page i is picked with probability proportional to 1 / (i + 1)^theta. */
+class ZipfianGenerator {
+ public:
+  ZipfianGenerator(size_t num_pages, double theta, uint64_t seed) : cdf_(num_pages), engine_(seed) {
+    double sum = 0;
+    for (size_t i = 0; i < num_pages; ++i) {
+      sum += 1.0 / std::pow(static_cast<double>(i + 1), theta);
+      cdf_[i] = sum;
+    }
+    for (double &p : cdf_) {
+      p /= sum;
+    }
+  }
+
+  page_id_t Next() {
+    double u = uniform_(engine_);
+    auto rank = std::lower_bound(cdf_.begin(), cdf_.end(), u) - cdf_.begin();
+    // Scatter the hot pages over the id space, so that they are not also adjacent frames.
+    return static_cast<page_id_t>((static_cast<size_t>(rank) * 7919) % cdf_.size());
+  }
+
+ private:
+  std::vector<double> cdf_;
+  std::mt19937_64 engine_;
+  std::uniform_real_distribution<double> uniform_{0.0, 1.0};
+};
+
+/**
+ * Replays a page trace against a replacer the way the buffer pool drives it: a hit pins and unpins the page's frame,
+ * a miss takes a free frame or a victim.
+ * @return the hit ratio
+ */
+double ReplayTrace(Replacer *replacer, const std::vector<page_id_t> &trace, size_t pool_size) {
+  std::unordered_map<page_id_t, frame_id_t> page_table;
+  std::vector<page_id_t> frame_pages(pool_size, INVALID_PAGE_ID);
+  size_t used_frames = 0;
+  size_t hits = 0;
+  for (page_id_t page_id : trace) {
+    auto it = page_table.find(page_id);
+    frame_id_t frame_id;
+    if (it != page_table.end()) {
+      frame_id = it->second;
+      replacer->RecordPageAccess(frame_id, page_id);
+      replacer->Pin(frame_id);
+      hits++;
+    } else {
+      if (used_frames < pool_size) {
+        frame_id = static_cast<frame_id_t>(used_frames++);
+      } else {
+        EXPECT_TRUE(replacer->Victim(&frame_id));
+        page_table.erase(frame_pages[frame_id]);
+      }
+      page_table[page_id] = frame_id;
+      frame_pages[frame_id] = page_id;
+      replacer->RecordPageAccess(frame_id, page_id);
+    }
+    replacer->Unpin(frame_id);
+  }
+  return static_cast<double>(hits) / static_cast<double>(trace.size());
+}
+
+/**
+ * Runs num_threads threads that pin and unpin random frames, as concurrent buffer pool hits do.
+ * @return the wall-clock time, in milliseconds
+ */
+int64_t HammerPinUnpin(Replacer *replacer, size_t pool_size, size_t num_threads, size_t iterations) {
+  for (size_t i = 0; i < pool_size; ++i) {
+    replacer->Unpin(static_cast<frame_id_t>(i));
+  }
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([replacer, pool_size, iterations, tid]() {
+      std::mt19937 engine(tid);
+      std::uniform_int_distribution<frame_id_t> frames(0, static_cast<frame_id_t>(pool_size - 1));
+      for (size_t i = 0; i < iterations; ++i) {
+        frame_id_t frame_id = frames(engine);
+        replacer->RecordAccess(frame_id);
+        replacer->Pin(frame_id);
+        replacer->Unpin(frame_id);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+}
+
+void ReportReplacer(const std::string &name, const std::function<std::unique_ptr<Replacer>(size_t)> &make_replacer) {
+  const size_t num_pages = 100000;
+  const size_t pool_size = 5000;
+  const size_t trace_length = 2000000;
+  for (double theta : {0.8, 0.99, 1.2}) {
+    ZipfianGenerator zipf(num_pages, theta, 42);
+    std::vector<page_id_t> trace(trace_length);
+    for (auto &page_id : trace) {
+      page_id = zipf.Next();
+    }
+    auto replacer = make_replacer(pool_size);
+    auto start = std::chrono::steady_clock::now();
+    double hit_ratio = ReplayTrace(replacer.get(), trace, pool_size);
+    auto end = std::chrono::steady_clock::now();
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    std::cout << name << ": zipf theta=" << theta << " hit_ratio=" << hit_ratio
+              << " ns/access=" << ns / static_cast<int64_t>(trace_length) << std::endl;
+  }
+  {
+    // Lookups on a hot set interleaved with reporting scans, each scan reading 3x the pool once.
+    ZipfianGenerator zipf(num_pages, 0.99, 42);
+    std::vector<page_id_t> trace;
+    page_id_t scan_page = 0;
+    while (trace.size() < trace_length) {
+      for (size_t i = 0; i < pool_size * 10; ++i) {
+        trace.push_back(zipf.Next());
+      }
+      for (size_t i = 0; i < pool_size * 3; ++i) {
+        trace.push_back(static_cast<page_id_t>(num_pages) + scan_page++);
+      }
+    }
+    auto replacer = make_replacer(pool_size);
+    double hit_ratio = ReplayTrace(replacer.get(), trace, pool_size);
+    std::cout << name << ": zipf theta=0.99 with scans hit_ratio=" << hit_ratio << std::endl;
+  }
+  for (size_t num_threads : {1, 4}) {
+    auto replacer = make_replacer(pool_size);
+    int64_t ms = HammerPinUnpin(replacer.get(), pool_size, num_threads, 1000000);
+    std::cout << name << ": pin/unpin threads=" << num_threads << " time=" << ms << "ms" << std::endl;
+  }
+}
+
+// Compares the replacers on skewed traces. Run with --gtest_also_run_disabled_tests.
+// NOLINTNEXTLINE
+TEST(ReplacerBenchmarkTest, DISABLED_Zipfian) {
+  ReportReplacer("LRUReplacer", [](size_t n) { return std::make_unique<LRUReplacer>(n); });
+  ReportReplacer("LRUKReplacer", [](size_t n) { return std::make_unique<LRUKReplacer>(n); });
+  ReportReplacer("ClockReplacer", [](size_t n) { return std::make_unique<ClockReplacer>(n); });
+  ReportReplacer("ARCReplacer", [](size_t n) { return std::make_unique<ARCReplacer>(n); });
+}
+
+}  // namespace bustub
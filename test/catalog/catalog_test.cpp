@@ -10,13 +10,17 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <sys/stat.h>
+
 #include <string>
 #include <unordered_set>
 #include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "catalog/catalog.h"
+#include "concurrency/transaction.h"
 #include "gtest/gtest.h"
+#include "storage/b_plus_tree_test_util.h"  // NOLINT
 #include "type/value_factory.h"
 
 namespace bustub {
@@ -46,6 +50,68 @@ TEST(CatalogTest, CreateTableTest) {
   delete catalog;
   delete bpm;
   delete disk_manager;
+  DiskManager::RemoveFiles("catalog_test.db");
+}
+
+/** @return the size of one of the files of a disk manager */
+int64_t FileSizeOf(DiskManager *disk_manager, file_id_t file_id) {
+  struct stat stat_buf;
+  return stat(disk_manager->GetFileName(file_id).c_str(), &stat_buf) == 0 ? stat_buf.st_size : -1;
+}
+
+// NOLINTNEXTLINE
+TEST(CatalogTest, SegmentTest) {
+  auto disk_manager = new DiskManager("catalog_test.db");
+  auto bpm = new BufferPoolManager(32, disk_manager);
+  auto catalog = new Catalog(bpm, nullptr, nullptr);
+  file_id_t table_file = disk_manager->CreateSegment("catalog_test_table.db");
+  file_id_t index_file = disk_manager->CreateSegment("catalog_test_index.db");
+  // The header page, where the index records its root, stays in the database file.
+  page_id_t header_page_id;
+  ASSERT_NE(nullptr, bpm->NewPage(&header_page_id));
+  bpm->UnpinPage(header_page_id, true);
+
+  std::vector<Column> columns;
+  columns.emplace_back("A", TypeId::BIGINT);
+  columns.emplace_back("B", TypeId::BOOLEAN);
+  Schema schema(columns);
+  auto *table_metadata = catalog->CreateTable(nullptr, "potato", schema, table_file);
+  EXPECT_EQ(table_file, GetFileId(table_metadata->table_->GetFirstPageId()));
+
+  // Enough tuples to spill over several pages, all of them in the table's file.
+  Transaction txn(0);
+  std::vector<RID> rids;
+  for (int64_t i = 0; i < 1000; ++i) {
+    std::vector<Value> values{ValueFactory::GetBigIntValue(i), ValueFactory::GetBooleanValue(i % 2 == 0)};
+    RID rid;
+    ASSERT_TRUE(table_metadata->table_->InsertTuple(Tuple(values, &schema), &rid, &txn));
+    EXPECT_EQ(table_file, GetFileId(rid.GetPageId()));
+    rids.push_back(rid);
+  }
+
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  auto *index_info = catalog->CreateIndex<GenericKey<8>, RID, GenericComparator<8>>(&txn, "index1", "potato", schema,
+                                                                                    *key_schema, {0}, 8, index_file);
+  std::vector<Value> values{ValueFactory::GetBigIntValue(500), ValueFactory::GetBooleanValue(true)};
+  Tuple index_key = Tuple(values, &schema).KeyFromTuple(schema, *key_schema, index_info->index_->GetKeyAttrs());
+  std::vector<RID> index_rids;
+  index_info->index_->ScanKey(index_key, &index_rids, &txn);
+  ASSERT_EQ(1U, index_rids.size());
+  EXPECT_EQ(rids[500].Get(), index_rids[0].Get());
+
+  // Each file holds its own pages once they are written back.
+  bpm->FlushAllPages();
+  EXPECT_EQ(bpm->GetPageSize(), static_cast<size_t>(FileSizeOf(disk_manager, DB_FILE_ID)));
+  EXPECT_LT(bpm->GetPageSize(), static_cast<size_t>(FileSizeOf(disk_manager, table_file)));
+  EXPECT_LT(0, FileSizeOf(disk_manager, index_file));
+
+  delete key_schema;
+  delete catalog;
+  delete bpm;
+  disk_manager->DropSegment(table_file);
+  disk_manager->DropSegment(index_file);
+  delete disk_manager;
+  DiskManager::RemoveFiles("catalog_test.db");
 }
 
 }  // namespace bustub
@@ -0,0 +1,85 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// crc32c_bench_test.cpp
+//
+// Identification: test/common/crc32c_bench_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "common/config.h"
+#include "common/crc32c.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+/**
+ * Checksum a page iterations times.
+ * @return the average time per page, in nanoseconds
+ */
+template <class F>
+double TimePerPage(F checksum, size_t iterations) {
+  std::vector<char> page(PAGE_SIZE, 'x');
+  uint32_t sum = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < iterations; i++) {
+    page[i % PAGE_SIZE] = static_cast<char>(i);
+    sum ^= checksum(page.data(), page.size());
+  }
+  auto end = std::chrono::steady_clock::now();
+  // Use the result so that the loop cannot be optimized away.
+  EXPECT_NE(0xFFFFFFFFU, sum + 1);
+  return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()) / iterations;
+}
+
+/**
+ * Read num_pages pages back iterations times through a disk manager.
+ * @return the average time per page, in nanoseconds
+ */
+double ReadTimePerPage(ChecksumMode mode, page_id_t num_pages, size_t iterations) {
+  DiskManager::RemoveFiles("bench.db");
+  page_checksum_mode = mode;
+  std::vector<char> page(PAGE_SIZE, 'x');
+  DiskManager dm("bench.db");
+  for (page_id_t i = 0; i < num_pages; i++) {
+    dm.WritePage(i, page.data());
+  }
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < iterations; i++) {
+    for (page_id_t j = 0; j < num_pages; j++) {
+      dm.ReadPage(j, page.data());
+    }
+  }
+  auto end = std::chrono::steady_clock::now();
+  dm.ShutDown();
+  page_checksum_mode = ChecksumMode::OFF;
+  DiskManager::RemoveFiles("bench.db");
+  return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()) /
+         (iterations * num_pages);
+}
+
+// Compares the SSE4.2 and table-driven checksums, and the cost of verifying reads. Run with
+// --gtest_also_run_disabled_tests.
+// NOLINTNEXTLINE
+TEST(Crc32cBenchmarkTest, DISABLED_Compare) {
+  const size_t iterations = 100000;
+  std::cout << "Crc32c (" << (Crc32cIsHardwareAccelerated() ? "sse4.2" : "software")
+            << "): " << TimePerPage(Crc32c, iterations) << "ns/page" << std::endl;
+  std::cout << "Crc32cSoftware: " << TimePerPage(Crc32cSoftware, iterations) << "ns/page" << std::endl;
+  std::cout << "ReadPage, checksums off: " << ReadTimePerPage(ChecksumMode::OFF, 256, 100) << "ns/page" << std::endl;
+  std::cout << "ReadPage, checksums verified: " << ReadTimePerPage(ChecksumMode::VERIFY, 256, 100) << "ns/page"
+            << std::endl;
+}
+
+}  // namespace bustub
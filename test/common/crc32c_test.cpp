@@ -0,0 +1,46 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// crc32c_test.cpp
+//
+// Identification: test/common/crc32c_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "common/config.h"
+#include "common/crc32c.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(Crc32cTest, KnownValueTest) {
+  const char *check = "123456789";
+  EXPECT_EQ(0xE3069283U, Crc32c(check, std::strlen(check)));
+  EXPECT_EQ(0xE3069283U, Crc32cSoftware(check, std::strlen(check)));
+  EXPECT_EQ(0U, Crc32c(check, 0));
+}
+
+// NOLINTNEXTLINE
+TEST(Crc32cTest, HardwareMatchesSoftwareTest) {
+  std::mt19937 rng(15445);
+  std::vector<char> data(PAGE_SIZE + 7);
+  for (auto &c : data) {
+    c = static_cast<char>(rng());
+  }
+  // Odd sizes and offsets exercise the unaligned head and the byte-wise tail.
+  for (size_t offset : {0, 1, 3}) {
+    for (size_t size : {1, 7, 8, 9, 63, 4096}) {
+      EXPECT_EQ(Crc32cSoftware(data.data() + offset, size), Crc32c(data.data() + offset, size));
+    }
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,78 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lz4_test.cpp
+//
+// Identification: test/common/lz4_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "common/config.h"
+#include "common/lz4.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(Lz4Test, RoundTripTest) {
+  std::mt19937 rng(15445);
+  std::vector<char> page(PAGE_SIZE);
+  std::vector<char> compressed(PAGE_SIZE * 2);
+  std::vector<char> out(PAGE_SIZE);
+
+  // Scenario: a page of small, repetitive integers, like most table pages, shrinks a lot.
+  for (size_t i = 0; i < PAGE_SIZE / sizeof(int32_t); ++i) {
+    auto value = static_cast<int32_t>(i % 16);
+    std::memcpy(page.data() + i * sizeof(int32_t), &value, sizeof(value));
+  }
+  size_t size = Lz4Compress(page.data(), page.size(), compressed.data(), compressed.size());
+  ASSERT_NE(0U, size);
+  EXPECT_LT(size, PAGE_SIZE / 8U);
+  ASSERT_TRUE(Lz4Decompress(compressed.data(), size, out.data(), out.size()));
+  EXPECT_EQ(page, out);
+
+  // Scenario: random data round-trips too, and does not fit in less than its own size.
+  for (auto &c : page) {
+    c = static_cast<char>(rng());
+  }
+  EXPECT_EQ(0U, Lz4Compress(page.data(), page.size(), compressed.data(), page.size() - 1));
+  size = Lz4Compress(page.data(), page.size(), compressed.data(), compressed.size());
+  ASSERT_NE(0U, size);
+  ASSERT_TRUE(Lz4Decompress(compressed.data(), size, out.data(), out.size()));
+  EXPECT_EQ(page, out);
+
+  // Scenario: inputs shorter than the shortest match, and runs that overlap themselves.
+  for (size_t length : {0, 1, 5, 12, 13, 100}) {
+    std::vector<char> input(length, 'a');
+    std::vector<char> output(length);
+    size = Lz4Compress(input.data(), length, compressed.data(), compressed.size());
+    ASSERT_NE(0U, size);
+    ASSERT_TRUE(Lz4Decompress(compressed.data(), size, output.data(), length));
+    EXPECT_EQ(input, output);
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(Lz4Test, MalformedInputTest) {
+  std::vector<char> page(PAGE_SIZE, 'a');
+  std::vector<char> compressed(PAGE_SIZE);
+  std::vector<char> out(PAGE_SIZE);
+  size_t size = Lz4Compress(page.data(), page.size(), compressed.data(), compressed.size());
+  ASSERT_NE(0U, size);
+
+  // Truncated input, a wrong output size, and a match before the start of the output are all rejected.
+  EXPECT_FALSE(Lz4Decompress(compressed.data(), size - 1, out.data(), out.size()));
+  EXPECT_FALSE(Lz4Decompress(compressed.data(), size, out.data(), out.size() - 1));
+  const char bad_offset[] = {0x10, 'a', 0x05, 0x00, 0x00};
+  EXPECT_FALSE(Lz4Decompress(bad_offset, sizeof(bad_offset), out.data(), 10));
+}
+
+}  // namespace bustub
@@ -0,0 +1,81 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// rwlatch_bench_test.cpp
+//
+// Identification: test/common/rwlatch_bench_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <iostream>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "common/rwlatch.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+/**
+ * Run num_threads threads that each take the latch iterations times, in write mode once every write_every
+ * acquisitions and in read mode otherwise.
+ * @return the wall-clock time, in milliseconds
+ */
+template <class Latch>
+int64_t RunLatchBenchmark(size_t num_threads, size_t iterations, size_t write_every) {
+  Latch latch;
+  uint64_t counter = 0;
+  std::atomic<uint64_t> reads{0};
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&latch, &counter, &reads, iterations, write_every]() {
+      uint64_t sum = 0;
+      for (size_t i = 1; i <= iterations; i++) {
+        if (i % write_every == 0) {
+          latch.WLock();
+          counter++;
+          latch.WUnlock();
+        } else {
+          latch.RLock();
+          sum += counter;
+          latch.RUnlock();
+        }
+      }
+      // Publish what was read so that the reads cannot be optimized away.
+      reads += sum;
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto end = std::chrono::steady_clock::now();
+  EXPECT_EQ(counter, num_threads * (iterations / write_every));
+  return std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+}
+
+template <class Latch>
+void ReportLatchBenchmark(const char *name) {
+  const size_t iterations = 1000000;
+  for (size_t num_threads : {1, 2, 4, 8}) {
+    for (size_t write_every : {1000, 10}) {
+      int64_t ms = RunLatchBenchmark<Latch>(num_threads, iterations, write_every);
+      std::cout << name << ": threads=" << num_threads << " writes=1/" << write_every << " time=" << ms << "ms"
+                << std::endl;
+    }
+  }
+}
+
+// Compares the atomic latch with the std::mutex-based one. Run with --gtest_also_run_disabled_tests.
+// NOLINTNEXTLINE
+TEST(RWLatchBenchmarkTest, DISABLED_Compare) {
+  ReportLatchBenchmark<MutexReaderWriterLatch>("MutexReaderWriterLatch");
+  ReportLatchBenchmark<ReaderWriterLatch>("ReaderWriterLatch");
+}
+
+}  // namespace bustub
@@ -10,6 +10,8 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <atomic>
+#include <chrono>  // NOLINT
 #include <thread>  // NOLINT
 #include <vector>
 
@@ -57,4 +59,37 @@ TEST(RWLatchTest, BasicTest) {
   }
   EXPECT_EQ(counter.Read(), 55);
 }
+
+// NOLINTNEXTLINE
+TEST(RWLatchTest, WriterPreferenceTest) {
+  ReaderWriterLatch latch;
+  std::atomic<bool> writer_done{false};
+  std::atomic<bool> reader_done{false};
+
+  latch.RLock();
+  // The writer enters, then waits for the reader that already holds the latch.
+  std::thread writer([&] {
+    latch.WLock();
+    writer_done = true;
+    latch.WUnlock();
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(writer_done);
+
+  // A new reader must queue behind the waiting writer.
+  std::thread reader([&] {
+    latch.RLock();
+    EXPECT_TRUE(writer_done);
+    reader_done = true;
+    latch.RUnlock();
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(reader_done);
+
+  latch.RUnlock();
+  writer.join();
+  reader.join();
+  EXPECT_TRUE(writer_done);
+  EXPECT_TRUE(reader_done);
+}
 }  // namespace bustub
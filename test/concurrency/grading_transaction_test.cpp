@@ -75,7 +75,7 @@ class GradingTransactionTest : public ::testing::Test {
     txn_mgr_->Commit(txn_);
     // Shut down the disk manager and clean up the transaction.
     disk_manager_->ShutDown();
-    remove("executor_test.db");
+    DiskManager::RemoveFiles("executor_test.db");
     delete txn_;
   };
 
@@ -2,6 +2,7 @@
  * b_plus_tree_test.cpp
  */
 
+#include <atomic>
 #include <chrono>  // NOLINT
 #include <cstdio>
 #include <functional>
@@ -330,4 +331,63 @@ TEST(BPlusTreeConcurrentTest, MixTest) {
   remove("test.log");
 }
 
+// helper function to look up keys that must be present
+void LookupHelper(BPlusTree<GenericKey<8>, RID, GenericComparator<8>> *tree, const std::vector<int64_t> &keys,
+                  std::atomic<int> *misses, __attribute__((unused)) uint64_t thread_itr = 0) {
+  GenericKey<8> index_key;
+  std::vector<RID> rids;
+  for (int round = 0; round < 5; ++round) {
+    for (auto key : keys) {
+      rids.clear();
+      index_key.SetFromInteger(key);
+      if (!tree->GetValue(index_key, &rids) || rids.size() != 1 || rids[0].GetSlotNum() != key) {
+        *misses += 1;
+      }
+    }
+  }
+}
+
+TEST(BPlusTreeConcurrentTest, ReadWhileInsertTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  // create b+ tree with small nodes, so that concurrent inserts keep splitting the pages readers go through
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 4, 5);
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+  // first, populate index with the even keys
+  std::vector<int64_t> even_keys;
+  std::vector<int64_t> odd_keys;
+  for (int64_t key = 0; key < 1000; key++) {
+    (key % 2 == 0 ? even_keys : odd_keys).push_back(key);
+  }
+  InsertHelper(&tree, even_keys);
+
+  // insert the odd keys while other threads look up the even ones, which must be found every time
+  std::atomic<int> misses{0};
+  std::thread writer0(InsertHelperSplit, &tree, odd_keys, 2, 0);
+  std::thread writer1(InsertHelperSplit, &tree, odd_keys, 2, 1);
+  LaunchParallelTest(2, LookupHelper, &tree, even_keys, &misses);
+  writer0.join();
+  writer1.join();
+  EXPECT_EQ(0, misses);
+
+  misses = 0;
+  LookupHelper(&tree, odd_keys, &misses);
+  EXPECT_EQ(0, misses);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
 }  // namespace bustub
@@ -139,4 +139,65 @@ TEST(BPlusTreeTests, InsertTest2) {
   remove("test.db");
   remove("test.log");
 }
+
+TEST(BPlusTreeTests, LargePageTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  // 16K pages: with the default max sizes, nodes fill the larger pages
+  DiskManager *disk_manager = new DiskManager("test.db", 16384);
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator);
+  GenericKey<8> index_key;
+  RID rid;
+  // create transaction
+  Transaction *transaction = new Transaction(0);
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  int64_t num_keys = 2000;
+  for (int64_t key = 1; key <= num_keys; key++) {
+    rid.Set(static_cast<int32_t>(key >> 32), key & 0xFFFFFFFF);
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, rid, transaction);
+  }
+
+  std::vector<RID> rids;
+  for (int64_t key = 1; key <= num_keys; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    ASSERT_TRUE(tree.GetValue(index_key, &rids));
+    EXPECT_EQ(rids[0].GetSlotNum(), key);
+  }
+
+  // a leaf fills a 16K page and holds about a thousand keys, so the whole tree takes a handful of pages
+  Page *leaf_page = tree.FindLeafPage(index_key);
+  auto leaf = reinterpret_cast<BPlusTreeLeafPage<GenericKey<8>, RID, GenericComparator<8>> *>(leaf_page->GetData());
+  EXPECT_EQ(leaf->GetMaxSize(), leaf->Capacity(16384));
+  EXPECT_GT(leaf->GetMaxSize(), leaf->Capacity(PAGE_SIZE));
+  leaf_page->RUnlatch();
+  bpm->UnpinPage(leaf_page->GetPageId(), false);
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  EXPECT_LE(page_id, 6);
+  bpm->UnpinPage(page_id, false);
+
+  int64_t current_key = 1;
+  for (auto &pair : tree) {
+    EXPECT_EQ(pair.second.GetSlotNum(), current_key);
+    current_key = current_key + 1;
+  }
+  EXPECT_EQ(current_key, num_keys + 1);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete transaction;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
 }  // namespace bustub
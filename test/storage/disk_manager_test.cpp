@@ -10,11 +10,25 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <sys/stat.h>
+
+#include <cstdio>
 #include <cstring>
+#include <fstream>
+#include <future>  // NOLINT
+#include <iterator>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
 
 #include "common/exception.h"
 #include "gtest/gtest.h"
 #include "storage/disk/disk_manager.h"
+#include "storage/disk/disk_manager_compressed.h"
+#include "storage/disk/disk_manager_mmap.h"
+#include "storage/disk/disk_manager_uring.h"
 
 namespace bustub {
 
@@ -22,14 +36,24 @@ class DiskManagerTest : public ::testing::Test {
  protected:
   // This function is called before every test.
   void SetUp() override {
-    remove("test.db");
-    remove("test.log");
+    DiskManager::RemoveFiles("test.db");
+    remove("test_seg.db");
+    remove("test_seg.db.fsm");
+    remove("test_seg.db.crc");
+    remove("test_seg2.db");
+    remove("test_seg2.db.fsm");
+    remove("test_seg2.db.crc");
   }
 
   // This function is called after every test.
   void TearDown() override {
-    remove("test.db");
-    remove("test.log");
+    DiskManager::RemoveFiles("test.db");
+    remove("test_seg.db");
+    remove("test_seg.db.fsm");
+    remove("test_seg.db.crc");
+    remove("test_seg2.db");
+    remove("test_seg2.db.fsm");
+    remove("test_seg2.db.crc");
   };
 };
 
@@ -72,6 +96,506 @@ TEST_F(DiskManagerTest, ReadWriteLogTest) {
   dm.ShutDown();
 }
 
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, FreePageTest) {
+  char data[PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  auto *dm = new DiskManager(db_file);
+  for (page_id_t i = 0; i < 10; ++i) {
+    EXPECT_EQ(i, dm->AllocatePage());
+    dm->WritePage(i, data);
+  }
+
+  // Scenario: deallocated pages are reused, most recently deallocated first, before the file grows.
+  dm->DeallocatePage(3);
+  dm->DeallocatePage(7);
+  dm->DeallocatePage(7);
+  dm->DeallocatePage(42);
+  EXPECT_EQ(2, dm->GetNumFreePages());
+  EXPECT_EQ(7, dm->AllocatePage());
+  EXPECT_EQ(3, dm->AllocatePage());
+  EXPECT_EQ(10, dm->AllocatePage());
+  EXPECT_EQ(0, dm->GetNumFreePages());
+
+  // Scenario: free pages survive a reopen, lowest first, and allocation picks up after the last page handed out, even
+  // though page 10 was never written.
+  dm->DeallocatePage(5);
+  dm->DeallocatePage(1);
+  dm->DeallocatePage(10);
+  dm->ShutDown();
+  delete dm;
+  dm = new DiskManager(db_file, PAGE_SIZE, false, true);
+  EXPECT_EQ(3, dm->GetNumFreePages());
+  EXPECT_EQ(1, dm->AllocatePage());
+  dm->ShutDown();
+  delete dm;
+
+  // Scenario: the page handed out before the reopen is still in use after another one.
+  dm = new DiskManager(db_file, PAGE_SIZE, false, true);
+  EXPECT_EQ(2, dm->GetNumFreePages());
+  EXPECT_EQ(5, dm->AllocatePage());
+  EXPECT_EQ(10, dm->AllocatePage());
+  EXPECT_EQ(11, dm->AllocatePage());
+
+  // Scenario: after a crash, pages that may have been handed out count as allocated, although they were not written.
+  std::string fsm_copy;
+  {
+    std::ifstream fsm_io("test.fsm", std::ios::binary);
+    fsm_copy.assign(std::istreambuf_iterator<char>(fsm_io), std::istreambuf_iterator<char>());
+  }
+  dm->ShutDown();
+  delete dm;
+  {
+    std::ofstream fsm_io("test.fsm", std::ios::binary | std::ios::trunc);
+    fsm_io << fsm_copy;
+  }
+  dm = new DiskManager(db_file, PAGE_SIZE, false, true);
+  EXPECT_EQ(0, dm->GetNumFreePages());
+  EXPECT_LT(11, dm->AllocatePage());
+  dm->ShutDown();
+  delete dm;
+
+  // Scenario: creating the database anew starts over.
+  dm = new DiskManager(db_file, PAGE_SIZE, false, false);
+  EXPECT_EQ(0, dm->GetNumFreePages());
+  EXPECT_EQ(0, dm->AllocatePage());
+  dm->ShutDown();
+  delete dm;
+
+  // Scenario: an existing database is reopened by default, so page 0 stays in use, but the maps of a database file
+  // that is gone are not picked up.
+  dm = new DiskManager(db_file);
+  EXPECT_LT(0, dm->AllocatePage());
+  dm->ShutDown();
+  delete dm;
+  remove("test.db");
+  dm = new DiskManager(db_file);
+  EXPECT_EQ(0, dm->AllocatePage());
+  dm->ShutDown();
+  delete dm;
+
+  // Scenario: removing the database takes the files next to it along.
+  DiskManager::RemoveFiles(db_file);
+  struct stat stat_buf;
+  for (const char *file_name : {"test.db", "test.log", "test.fsm", "test.crc", "test.seg"}) {
+    EXPECT_NE(0, stat(file_name, &stat_buf)) << file_name;
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, WritePagesTest) {
+  const page_id_t num_pages = 8;
+  std::string db_file("test.db");
+  DiskManager dm(db_file);
+  std::vector<std::vector<char>> data(num_pages, std::vector<char>(PAGE_SIZE));
+  for (page_id_t i = 0; i < num_pages; ++i) {
+    std::memset(data[i].data(), 'a' + i, PAGE_SIZE);
+  }
+
+  // Scenario: an unordered batch with two runs of consecutive pages and a gap is written in full, and synced once.
+  std::vector<std::pair<page_id_t, const char *>> batch;
+  for (page_id_t i : {6, 1, 3, 2, 7, 5}) {
+    batch.emplace_back(i, data[i].data());
+  }
+  dm.WritePages(batch);
+  EXPECT_EQ(6, dm.GetNumWrites());
+  EXPECT_EQ(1, dm.GetNumSyncs());
+
+  std::vector<char> buf(PAGE_SIZE);
+  for (page_id_t i : {1, 2, 3, 5, 6, 7}) {
+    dm.ReadPage(i, buf.data());
+    EXPECT_EQ(data[i], buf);
+  }
+  dm.ReadPage(4, buf.data());
+  EXPECT_EQ(std::vector<char>(PAGE_SIZE, 0), buf);
+
+  // Scenario: an empty batch does not sync.
+  dm.WritePages({});
+  EXPECT_EQ(1, dm.GetNumSyncs());
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, DirectIOTest) {
+  // One byte off, so that the disk manager has to bounce the page through an aligned buffer.
+  char buf[PAGE_SIZE + 1] = {0};
+  char data[PAGE_SIZE + 1] = {0};
+  std::string db_file("test.db");
+  auto *dm = new DiskManager(db_file, PAGE_SIZE, true);
+  std::strncpy(data + 1, "A test string.", PAGE_SIZE);
+
+  dm->WritePage(3, data + 1);
+  dm->ReadPage(3, buf + 1);
+  EXPECT_EQ(std::memcmp(buf + 1, data + 1, PAGE_SIZE), 0);
+
+  // The hole before the page reads back as zeros, and so does the space past the end of the file.
+  std::memset(buf, 1, sizeof(buf));
+  dm->ReadPage(1, buf + 1);
+  EXPECT_EQ(0, buf[1]);
+  std::memset(buf, 1, sizeof(buf));
+  dm->ReadPage(4, buf + 1);
+  EXPECT_EQ(0, buf[PAGE_SIZE]);
+  dm->ShutDown();
+  delete dm;
+
+  // The file size is picked up again after a reopen.
+  dm = new DiskManager(db_file, PAGE_SIZE, false, true);
+  EXPECT_EQ(4, dm->AllocatePage());
+  dm->ReadPage(3, buf);
+  EXPECT_EQ(std::memcmp(buf, data + 1, PAGE_SIZE), 0);
+  dm->ShutDown();
+  delete dm;
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ConcurrentReadWriteTest) {
+  const int num_threads = 4;
+  const int pages_per_thread = 64;
+  std::string db_file("test.db");
+  DiskManager dm(db_file);
+
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([&dm, tid] {
+      char buf[PAGE_SIZE];
+      char data[PAGE_SIZE];
+      for (int i = 0; i < pages_per_thread; ++i) {
+        page_id_t page_id = i * num_threads + tid;
+        std::memset(data, page_id % 128, sizeof(data));
+        dm.WritePage(page_id, data);
+        dm.ReadPage(page_id, buf);
+        EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  char buf[PAGE_SIZE];
+  for (page_id_t page_id = 0; page_id < num_threads * pages_per_thread; ++page_id) {
+    dm.ReadPage(page_id, buf);
+    EXPECT_EQ(page_id % 128, buf[0]);
+    EXPECT_EQ(page_id % 128, buf[PAGE_SIZE - 1]);
+  }
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, AsyncIOTest) {
+  const page_id_t num_pages = 100;
+  std::string db_file("test.db");
+  // A shallow queue, so that requests have to wait for slots.
+  auto *dm = new DiskManagerUring(db_file, PAGE_SIZE, false, false, 8);
+  std::vector<std::vector<char>> data(num_pages, std::vector<char>(PAGE_SIZE));
+  std::vector<std::vector<char>> buf(num_pages, std::vector<char>(PAGE_SIZE, 1));
+
+  // Scenario: many writes in flight at once all land.
+  std::vector<std::future<void>> done;
+  for (page_id_t i = 0; i < num_pages; ++i) {
+    std::memset(data[i].data(), i, PAGE_SIZE);
+    done.push_back(dm->WritePageAsync(i, data[i].data()));
+  }
+  dm->SubmitAsync();
+  for (auto &f : done) {
+    f.wait();
+  }
+  EXPECT_EQ(num_pages, dm->GetNumWrites());
+
+  // Scenario: so do many reads, and reading past the end of the file yields zeros.
+  done.clear();
+  for (page_id_t i = 0; i < num_pages; ++i) {
+    done.push_back(dm->ReadPageAsync(i, buf[i].data()));
+  }
+  std::vector<char> past_end(PAGE_SIZE, 1);
+  done.push_back(dm->ReadPageAsync(num_pages, past_end.data()));
+  dm->SubmitAsync();
+  for (auto &f : done) {
+    f.wait();
+  }
+  EXPECT_EQ(data, buf);
+  EXPECT_EQ(std::vector<char>(PAGE_SIZE, 0), past_end);
+
+  // Scenario: synchronous calls see what the asynchronous ones wrote.
+  dm->ReadPage(num_pages - 1, buf[0].data());
+  EXPECT_EQ(data[num_pages - 1], buf[0]);
+
+  dm->ShutDown();
+  delete dm;
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, MmapTest) {
+  char buf[PAGE_SIZE] = {0};
+  char data[PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  auto *dm = new DiskManager(db_file);
+  std::strncpy(data, "A test string.", sizeof(data));
+  dm->WritePage(0, data);
+  dm->WritePage(2, data);
+  dm->ShutDown();
+  delete dm;
+
+  // Scenario: pages are copied out of the mapping, and pages past the end of the file read as zeros.
+  auto *mapped = new DiskManagerMmap(db_file);
+  mapped->ReadPage(2, buf);
+  EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+  std::memset(buf, 1, sizeof(buf));
+  mapped->ReadPage(3, buf);
+  EXPECT_EQ(0, buf[PAGE_SIZE - 1]);
+  EXPECT_EQ(nullptr, mapped->GetMappedPage(0));
+  EXPECT_THROW(mapped->WritePage(0, data), Exception);
+  mapped->AdviseSequential(0, 8);
+  mapped->ShutDown();
+  delete mapped;
+
+  // Scenario: in zero-copy mode the pages themselves are handed out.
+  mapped = new DiskManagerMmap(db_file, PAGE_SIZE, true);
+  const char *page = mapped->GetMappedPage(2);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(std::memcmp(page, data, sizeof(data)), 0);
+  EXPECT_EQ(page - PAGE_SIZE * 2, mapped->GetMappedPage(0));
+  EXPECT_EQ(nullptr, mapped->GetMappedPage(3));
+  mapped->ShutDown();
+  delete mapped;
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ChecksumTest) {
+  char buf[PAGE_SIZE] = {0};
+  char data[PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  std::strncpy(data, "A test string.", sizeof(data));
+  page_checksum_mode = ChecksumMode::VERIFY;
+  auto *dm = new DiskManager(db_file);
+  dm->WritePage(0, data);
+  dm->WritePage(1, data);
+  dm->ReadPage(1, buf);
+  EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+  EXPECT_EQ(0, dm->GetNumChecksumFailures());
+
+  // Scenario: single writes only update the checksums in memory; the checksum map is written at shutdown.
+  struct stat stat_buf;
+  ASSERT_EQ(0, stat("test.crc", &stat_buf));
+  EXPECT_EQ(0, stat_buf.st_size);
+  dm->ShutDown();
+  delete dm;
+  ASSERT_EQ(0, stat("test.crc", &stat_buf));
+  EXPECT_LT(0, stat_buf.st_size);
+
+  // Flip a byte of page 1 behind the disk manager's back.
+  FILE *file = fopen("test.db", "r+b");
+  ASSERT_NE(nullptr, file);
+  fseek(file, PAGE_SIZE + 1, SEEK_SET);
+  fputc('x', file);
+  fclose(file);
+
+  // Scenario: the checksums survive a reopen, and a damaged page is counted but returned as read.
+  dm = new DiskManager(db_file, PAGE_SIZE, false, true);
+  dm->ReadPage(0, buf);
+  EXPECT_EQ(0, dm->GetNumChecksumFailures());
+  dm->ReadPage(1, buf);
+  EXPECT_EQ(1, dm->GetNumChecksumFailures());
+  EXPECT_EQ('x', buf[1]);
+
+  // Scenario: in REPAIR mode the damaged page is remembered too, but still returned as read, until it is rewritten.
+  page_checksum_mode = ChecksumMode::REPAIR;
+  EXPECT_TRUE(dm->GetDamagedPages().empty());
+  dm->ReadPage(1, buf);
+  EXPECT_EQ(2, dm->GetNumChecksumFailures());
+  EXPECT_EQ('x', buf[1]);
+  EXPECT_EQ(std::vector<page_id_t>{1}, dm->GetDamagedPages());
+
+  // Scenario: with checksums off, nothing is verified, and a rewrite drops the stale checksum.
+  page_checksum_mode = ChecksumMode::OFF;
+  dm->ReadPage(1, buf);
+  EXPECT_EQ('x', buf[1]);
+  dm->WritePage(1, buf);
+  EXPECT_TRUE(dm->GetDamagedPages().empty());
+  page_checksum_mode = ChecksumMode::VERIFY;
+  dm->ReadPage(1, buf);
+  EXPECT_EQ(2, dm->GetNumChecksumFailures());
+
+  // Scenario: a crash after the checksums of a batch were written but before its pages were leaves the old pages,
+  // which still verify.
+  dm->WritePages({{0, buf}});
+  dm->ShutDown();
+  delete dm;
+  file = fopen("test.db", "r+b");
+  ASSERT_NE(nullptr, file);
+  fwrite(data, 1, sizeof(data), file);
+  fclose(file);
+  dm = new DiskManager(db_file, PAGE_SIZE, false, true);
+  dm->ReadPage(0, buf);
+  EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+  EXPECT_EQ(0, dm->GetNumChecksumFailures());
+  page_checksum_mode = ChecksumMode::OFF;
+  dm->ShutDown();
+  delete dm;
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, CompressionTest) {
+  const page_id_t num_pages = 32;
+  std::string db_file("test.db");
+  auto *dm = new DiskManagerCompressed(db_file);
+  std::vector<std::vector<char>> data(num_pages, std::vector<char>(PAGE_SIZE));
+  for (page_id_t i = 0; i < num_pages; ++i) {
+    for (size_t j = 0; j < PAGE_SIZE / sizeof(int32_t); ++j) {
+      auto value = static_cast<int32_t>(i + j % 8);
+      std::memcpy(data[i].data() + j * sizeof(int32_t), &value, sizeof(value));
+    }
+  }
+
+  // Scenario: repetitive pages take a fraction of their size on disk, and read back whole.
+  std::vector<std::pair<page_id_t, const char *>> batch;
+  for (page_id_t i = 0; i < num_pages; ++i) {
+    batch.emplace_back(i, data[i].data());
+  }
+  dm->WritePages(batch);
+  struct stat stat_buf;
+  ASSERT_EQ(0, stat("test.db", &stat_buf));
+  EXPECT_LE(stat_buf.st_size, num_pages * static_cast<off_t>(DiskManagerCompressed::SECTOR_SIZE));
+  std::vector<char> buf(PAGE_SIZE, 1);
+  for (page_id_t i = 0; i < num_pages; ++i) {
+    dm->ReadPage(i, buf.data());
+    EXPECT_EQ(data[i], buf);
+  }
+  dm->ReadPage(num_pages, buf.data());
+  EXPECT_EQ(std::vector<char>(PAGE_SIZE, 0), buf);
+
+  // Scenario: pages that grow move to a bigger extent, up to a page stored raw once it no longer compresses.
+  std::mt19937 rng(15445);
+  for (auto &c : data[3]) {
+    c = static_cast<char>(rng());
+  }
+  dm->WritePage(3, data[3].data());
+  std::memset(data[5].data(), 'x', PAGE_SIZE / 2);
+  dm->WritePage(5, data[5].data());
+  dm->ReadPage(3, buf.data());
+  EXPECT_EQ(data[3], buf);
+  dm->ReadPage(5, buf.data());
+  EXPECT_EQ(data[5], buf);
+  EXPECT_EQ(1, dm->GetNumSyncs());
+
+  // Scenario: a single write leaves the page map on disk alone, so the extent it points to is not overwritten, even if
+  // the page fits. The next batch moves the page map on disk along.
+  auto first_sector = [](page_id_t page_id) {
+    std::ifstream map_io("test.map", std::ios::binary);
+    uint32_t sector = 0;
+    map_io.seekg(page_id * 8);
+    map_io.read(reinterpret_cast<char *>(&sector), sizeof(sector));
+    return sector;
+  };
+  uint32_t sector = first_sector(7);
+  dm->WritePage(7, data[7].data());
+  EXPECT_EQ(sector, first_sector(7));
+  dm->ReadPage(7, buf.data());
+  EXPECT_EQ(data[7], buf);
+  dm->WritePages({{8, data[8].data()}});
+  EXPECT_EQ(2, dm->GetNumSyncs());
+  EXPECT_NE(sector, first_sector(7));
+  dm->ReadPage(7, buf.data());
+  EXPECT_EQ(data[7], buf);
+  dm->ShutDown();
+  delete dm;
+
+  // Scenario: after a reopen the page map is reloaded, and new pages are allocated past the last one.
+  dm = new DiskManagerCompressed(db_file, PAGE_SIZE, true);
+  for (page_id_t i = 0; i < num_pages; ++i) {
+    dm->ReadPage(i, buf.data());
+    EXPECT_EQ(data[i], buf);
+  }
+  EXPECT_EQ(num_pages, dm->AllocatePage());
+  dm->ShutDown();
+  delete dm;
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, SegmentTest) {
+  char buf[PAGE_SIZE] = {0};
+  char data[PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  std::strncpy(data, "A test string.", sizeof(data));
+  page_checksum_mode = ChecksumMode::VERIFY;
+  auto *dm = new DiskManager(db_file);
+  file_id_t file_id = dm->CreateSegment("test_seg.db");
+  EXPECT_EQ(1, file_id);
+  EXPECT_EQ(file_id, dm->CreateSegment("test_seg.db"));
+
+  // Scenario: pages of a segment are numbered from 0 within it, and do not touch the database file.
+  page_id_t seg_page = dm->AllocatePage(file_id);
+  EXPECT_EQ(MakePageId(file_id, 0), seg_page);
+  EXPECT_EQ(file_id, GetFileId(seg_page));
+  EXPECT_EQ(0, dm->AllocatePage());
+  // The database file is not limited to the page numbers a segment can have.
+  EXPECT_EQ(DB_FILE_ID, GetFileId(MAX_SEGMENT_PAGE_NO + 1));
+  EXPECT_EQ(MAX_SEGMENT_PAGE_NO + 1, GetPageNo(MAX_SEGMENT_PAGE_NO + 1));
+  EXPECT_EQ(DB_FILE_ID, GetFileId(MAX_DB_PAGE_NO));
+  EXPECT_EQ(DB_FILE_ID, GetFileId(INVALID_PAGE_ID));
+  EXPECT_EQ(MAX_FILE_ID, GetFileId(MakePageId(MAX_FILE_ID, MAX_SEGMENT_PAGE_NO)));
+  EXPECT_EQ(MAX_SEGMENT_PAGE_NO, GetPageNo(MakePageId(MAX_FILE_ID, MAX_SEGMENT_PAGE_NO)));
+  dm->WritePage(seg_page, data);
+  dm->ReadPage(seg_page, buf);
+  EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+  dm->ReadPage(0, buf);
+  EXPECT_EQ(0, buf[0]);
+
+  // Scenario: a batch spanning both files lands in both, with one sync per file.
+  page_id_t seg_page2 = dm->AllocatePage(file_id);
+  dm->WritePages({{seg_page2, data}, {0, data}});
+  EXPECT_EQ(1, dm->GetNumSyncs());
+  dm->ReadPage(0, buf);
+  EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+  struct stat stat_buf;
+  ASSERT_EQ(0, stat("test_seg.db", &stat_buf));
+  EXPECT_EQ(2 * PAGE_SIZE, stat_buf.st_size);
+
+  // Scenario: deallocated segment pages are reused.
+  dm->DeallocatePage(seg_page);
+  EXPECT_EQ(1U, dm->GetNumFreePages());
+  EXPECT_EQ(seg_page, dm->AllocatePage(file_id));
+  dm->DeallocatePage(seg_page);
+  dm->ShutDown();
+  delete dm;
+
+  // Flip a byte of the second segment page behind the disk manager's back.
+  FILE *file = fopen("test_seg.db", "r+b");
+  ASSERT_NE(nullptr, file);
+  fseek(file, PAGE_SIZE + 1, SEEK_SET);
+  fputc('x', file);
+  fclose(file);
+
+  // Scenario: segments are reopened with the database, along with their free pages and checksums.
+  dm = new DiskManager(db_file, PAGE_SIZE, false, true);
+  EXPECT_EQ("test_seg.db", dm->GetFileName(file_id));
+  dm->ReadPage(seg_page2, buf);
+  EXPECT_EQ(1, dm->GetNumChecksumFailures());
+  EXPECT_EQ('x', buf[1]);
+  dm->WritePage(seg_page2, data);
+  dm->ReadPage(seg_page2, buf);
+  EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+  EXPECT_EQ(1, dm->GetNumChecksumFailures());
+  EXPECT_EQ(1U, dm->GetNumFreePages());
+  EXPECT_EQ(seg_page, dm->AllocatePage(file_id));
+  EXPECT_EQ(MakePageId(file_id, 2), dm->AllocatePage(file_id));
+
+  // Scenario: a dropped segment is unlinked with its maps, its pages read as zeros, and its id is not handed out again.
+  dm->DropSegment(file_id);
+  EXPECT_NE(0, stat("test_seg.db", &stat_buf));
+  EXPECT_NE(0, stat("test_seg.db.fsm", &stat_buf));
+  EXPECT_NE(0, stat("test_seg.db.crc", &stat_buf));
+  EXPECT_EQ("", dm->GetFileName(file_id));
+  dm->WritePage(seg_page2, data);
+  dm->ReadPage(seg_page2, buf);
+  EXPECT_EQ(0, buf[0]);
+  EXPECT_THROW(dm->AllocatePage(file_id), Exception);
+  EXPECT_EQ(2, dm->CreateSegment("test_seg2.db"));
+  page_checksum_mode = ChecksumMode::OFF;
+  dm->ShutDown();
+  delete dm;
+}
+
 // NOLINTNEXTLINE
 TEST_F(DiskManagerTest, ThrowBadFileTest) { EXPECT_THROW(DiskManager("dev/null\\/foo/bar/baz/test.db"), Exception); }
 
@@ -0,0 +1,98 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_guard_test.cpp
+//
+// Identification: test/storage/page_guard_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <utility>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/page/page_guard.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(PageGuardTest, SampleTest) {
+  const size_t buffer_pool_size = 5;
+
+  auto *disk_manager = new DiskManagerMemory();
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  page_id_t page_id_temp;
+  auto *page0 = bpm->NewPage(&page_id_temp);
+  ASSERT_NE(nullptr, page0);
+  EXPECT_TRUE(bpm->UnpinPage(page0->GetPageId(), false));
+
+  // Scenario: a read guard holds a pin until it is dropped.
+  {
+    ReadPageGuard guard = bpm->FetchPageRead(0);
+    ASSERT_TRUE(guard.IsValid());
+    EXPECT_EQ(0, guard.PageId());
+    EXPECT_EQ(1, page0->GetPinCount());
+    guard.Drop();
+    EXPECT_FALSE(guard.IsValid());
+    EXPECT_EQ(0, page0->GetPinCount());
+  }
+
+  // Scenario: moving a guard transfers the pin; assigning over a guard releases what it held.
+  {
+    ReadPageGuard guard = bpm->FetchPageRead(0);
+    ReadPageGuard moved(std::move(guard));
+    EXPECT_FALSE(guard.IsValid());  // NOLINT
+    EXPECT_TRUE(moved.IsValid());
+    EXPECT_EQ(1, page0->GetPinCount());
+    moved = ReadPageGuard();
+    EXPECT_EQ(0, page0->GetPinCount());
+  }
+
+  // Scenario: several readers share the page; leaving the scope releases every pin.
+  {
+    ReadPageGuard first = bpm->FetchPageRead(0);
+    ReadPageGuard second = bpm->FetchPageRead(0);
+    EXPECT_EQ(2, page0->GetPinCount());
+  }
+  EXPECT_EQ(0, page0->GetPinCount());
+
+  // Scenario: a write guard unpins the page as dirty only if it was marked dirty.
+  {
+    WritePageGuard guard = bpm->FetchPageWrite(0);
+    ASSERT_TRUE(guard.IsValid());
+    EXPECT_FALSE(page0->IsDirty());
+  }
+  EXPECT_FALSE(page0->IsDirty());
+  {
+    WritePageGuard guard = bpm->FetchPageWrite(0);
+    snprintf(guard.GetData(), PAGE_SIZE, "Hello");
+    guard.MarkDirty();
+    WritePageGuard moved = std::move(guard);
+  }
+  EXPECT_EQ(0, page0->GetPinCount());
+  EXPECT_TRUE(page0->IsDirty());
+  EXPECT_EQ(0, strcmp(bpm->FetchPageRead(0).GetData(), "Hello"));
+  EXPECT_EQ(0, page0->GetPinCount());
+
+  // Scenario: a fetch that cannot find a frame gives back an invalid guard.
+  for (size_t i = 1; i < buffer_pool_size; ++i) {
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  }
+  {
+    ReadPageGuard pinned = bpm->FetchPageRead(0);
+    EXPECT_FALSE(bpm->FetchPageWrite(buffer_pool_size).IsValid());
+  }
+
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
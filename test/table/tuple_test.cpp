@@ -13,12 +13,14 @@
 #include <algorithm>
 #include <cstdio>
 #include <iostream>
+#include <random>
 #include <string>
 #include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "gtest/gtest.h"
 #include "logging/common.h"
+#include "storage/disk/disk_manager_memory.h"
 #include "storage/table/table_heap.h"
 #include "storage/table/tuple.h"
 
@@ -71,4 +73,90 @@ TEST(TupleTest, DISABLED_TableHeapTest) {
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+TEST(TupleTest, GetTuplesTest) {
+  Column col1{"a", TypeId::VARCHAR, 20};
+  Column col2{"b", TypeId::BIGINT};
+  std::vector<Column> cols{col1, col2};
+  Schema schema{cols};
+
+  auto *transaction = new Transaction(0);
+  auto *disk_manager = new DiskManagerMemory();
+  auto *buffer_pool_manager = new BufferPoolManager(50, disk_manager);
+  auto *table = new TableHeap(buffer_pool_manager, nullptr, nullptr, transaction);
+
+  std::vector<RID> rid_v;
+  for (int i = 0; i < 1000; ++i) {
+    RID rid;
+    ASSERT_TRUE(table->InsertTuple(ConstructTuple(&schema), &rid, transaction));
+    rid_v.push_back(rid);
+  }
+
+  // Scenario: a batch of rids scattered over many pages, with repeats, reads the same tuples as one read per rid.
+  std::shuffle(rid_v.begin(), rid_v.end(), std::default_random_engine(0));
+  rid_v.resize(200);
+  rid_v.push_back(rid_v[0]);
+  std::vector<Tuple> tuples;
+  ASSERT_TRUE(table->GetTuples(rid_v, &tuples, transaction));
+  ASSERT_EQ(rid_v.size(), tuples.size());
+  for (size_t i = 0; i < rid_v.size(); ++i) {
+    Tuple expected;
+    ASSERT_TRUE(table->GetTuple(rid_v[i], &expected, transaction));
+    EXPECT_EQ(rid_v[i], tuples[i].GetRid());
+    EXPECT_EQ(expected.ToString(&schema), tuples[i].ToString(&schema));
+  }
+
+  // Scenario: every page the batch fetched has been unpinned again.
+  for (size_t i = 0; i < buffer_pool_manager->GetPoolSize(); ++i) {
+    EXPECT_EQ(0, buffer_pool_manager->GetPages()[i].GetPinCount());
+  }
+
+  // Scenario: with all but a few frames pinned by someone else, the batch still reads every tuple.
+  std::vector<page_id_t> pinned(buffer_pool_manager->GetPoolSize() - 3);
+  for (auto &page_id : pinned) {
+    ASSERT_NE(nullptr, buffer_pool_manager->NewPage(&page_id));
+  }
+  tuples.clear();
+  ASSERT_TRUE(table->GetTuples(rid_v, &tuples, transaction));
+  EXPECT_EQ(TransactionState::GROWING, transaction->GetState());
+  for (size_t i = 0; i < rid_v.size(); ++i) {
+    EXPECT_EQ(rid_v[i], tuples[i].GetRid());
+  }
+  EXPECT_TRUE(buffer_pool_manager->UnpinPages(pinned, false));
+
+  delete table;
+  delete buffer_pool_manager;
+  delete disk_manager;
+  delete transaction;
+}
+
+// NOLINTNEXTLINE
+TEST(TupleTest, NumPagesTest) {
+  Column col1{"a", TypeId::VARCHAR, 20};
+  Column col2{"b", TypeId::BIGINT};
+  std::vector<Column> cols{col1, col2};
+  Schema schema{cols};
+
+  auto *transaction = new Transaction(0);
+  auto *disk_manager = new DiskManagerMemory();
+  auto *buffer_pool_manager = new BufferPoolManager(50, disk_manager);
+  auto *table = new TableHeap(buffer_pool_manager, nullptr, nullptr, transaction);
+  EXPECT_EQ(1U, table->GetNumPages());
+  for (int i = 0; i < 1000; ++i) {
+    RID rid;
+    ASSERT_TRUE(table->InsertTuple(ConstructTuple(&schema), &rid, transaction));
+  }
+  EXPECT_LT(1U, table->GetNumPages());
+
+  // Scenario: a table opened from its first page counts the pages by walking them, and arrives at the same number.
+  auto *reopened = new TableHeap(buffer_pool_manager, nullptr, nullptr, table->GetFirstPageId());
+  EXPECT_EQ(table->GetNumPages(), reopened->GetNumPages());
+
+  delete reopened;
+  delete table;
+  delete buffer_pool_manager;
+  delete disk_manager;
+  delete transaction;
+}
+
 }  // namespace bustub